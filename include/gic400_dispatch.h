@@ -0,0 +1,26 @@
+// SPDX-License-Identifier: MPL-2.0 OR GPL-2.0+
+#ifndef _GIC400_DISPATCH_H
+#define _GIC400_DISPATCH_H
+
+/* Layout shared between the C library and the optional assembly dispatcher
+ * (src/gic400_dispatch.S). Only preprocessor definitions may live here; the
+ * C side checks every offset against struct GIC_Dispatch at compile time.
+ */
+
+/* struct GIC_Dispatch */
+#define GIC_DISPATCH_IAR 0       // APTR GICC_IAR address
+#define GIC_DISPATCH_EOIR 4      // APTR GICC_EOIR address
+#define GIC_DISPATCH_MAX_IRQS 8  // u32 number of IRQs
+#define GIC_DISPATCH_HANDLERS 12 // struct Interrupt ** handler table
+#define GIC_DISPATCH_FLAGS 16    // u8 * per-IRQ GIC_IRQF_* flags
+#define GIC_DISPATCH_BASE 20     // struct GIC_Base *
+#define GIC_DISPATCH_HOOKS 24    // u32 GIC_HOOK_*, non-zero takes the C path
+
+/* struct Interrupt */
+#define GIC_IS_DATA 14
+#define GIC_IS_CODE 18
+
+/* Per-IRQ flags that need gic400_dispatch() instead of the direct call */
+#define GIC_IRQF_DISPATCH_MASK 0xF2 // GIC_IRQF_OVERRUN | GIC_IRQF_STAMP | GIC_IRQF_CLASS | GIC_IRQF_BUDGET | GIC_IRQF_DEFERRED
+
+#endif /* _GIC400_DISPATCH_H */
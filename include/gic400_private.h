@@ -21,12 +21,21 @@
 #include "debug.h"
 #include <hardware/intbits.h>
 #include <libraries/gic400.h>
+#include "gic400_dispatch.h"
 
 #if defined(__INTELLISENSE__)
 #define asm(x)
 #define __attribute__(x)
 #endif
 
+/* Host builds (tools/) have no m68k registers to bind parameters to, and
+ * call servers through the harness instead of the Exec ABI.
+ */
+#ifdef GIC400_HOST
+#define asm(x)
+void gic400_host_call(struct Interrupt *interrupt, u32 irq, u32 hint, u32 stamp);
+#endif
+
 /* These are overriden by cmake */
 #ifndef LIBRARY_NAME
 #define LIBRARY_NAME "gic400.library"
@@ -48,6 +57,167 @@
 #define LIBRARY_PRIORITY 126
 #endif
 
+/* Hot dispatcher state, read directly by gic400_exec_dispatcher_asm();
+ * offsets must match GIC_DISPATCH_* in gic400_dispatch.h. Filled once the
+ * tables are allocated.
+ */
+struct GIC_Dispatch
+{
+    APTR gicc_iar;
+    APTR gicc_eoir;
+    u32 max_irqs;
+    struct Interrupt **handlers;
+    u8 *irq_flags;
+    struct GIC_Base *base;
+    volatile u32 hooks; // GIC_HOOK_*, non-zero sends every IRQ through gic400_dispatch()
+};
+
+/* Dispatcher-wide policies (gicBase->dispatch.hooks) */
+#define GIC_HOOK_FAIR (1u << 0)  // fair-share priority demotion
+#define GIC_HOOK_TRACE (1u << 1) // record arrival and service time
+
+/* One IRQ staged by StageIntConfig(), indexed by IRQ number */
+struct GIC_StagedInt
+{
+    u8 flags; // GIC400_CFGF_*, 0 when not staged
+    u8 priority;
+    u8 targets;
+    u8 state; // GIC_STAGED_EDGE | GIC_STAGED_ENABLE
+};
+
+#define GIC_STAGED_EDGE (1u << 0)
+#define GIC_STAGED_ENABLE (1u << 1)
+
+/* IRQ set registered by AddIntServerGroup() */
+struct GIC_IntGroup
+{
+    struct MinNode node;
+    struct Interrupt server;     // registered for every member
+    struct Interrupt *interrupt; // caller's server
+    struct GIC_Base *base;
+    u32 count;
+    u32 irqs[]; // in the caller's order, bit n of the mask is irqs[n]
+};
+
+/* One decoded GIC interrupt specifier of a device-tree node */
+struct GIC_DTInt
+{
+    APTR key; // devicetree.resource node
+    u16 irq;  // IRQ number with the SPI/PPI offset applied
+    u8 index; // position in the node's "interrupts" property
+    u8 flags; // GIC400_DT_TRIGGER_*
+};
+
+/* Single-producer/single-consumer ring behind struct GICIntQueue. head is
+ * only written by the producer and tail only by the consumer; the padding
+ * keeps them (and the read-mostly header) in different 64-byte cache lines.
+ */
+#define GIC_QUEUE_LINE 64
+
+struct GIC_IntQueue
+{
+    u32 mask; // capacity - 1, capacity a power of two
+    struct Task *task;
+    u32 signals;
+    u8 pad0[GIC_QUEUE_LINE - 3 * sizeof(u32)];
+    volatile u32 head; // free-running put count
+    u8 pad1[GIC_QUEUE_LINE - sizeof(u32)];
+    volatile u32 tail; // free-running get count
+    u8 pad2[GIC_QUEUE_LINE - sizeof(u32)];
+    APTR slots[];
+};
+
+/* Object pool behind struct GICPool. The free list is a stack of object
+ * indices linked through next[]; head holds a change tag in its upper half
+ * and the top index in its lower half, so a compare-and-swap on head alone
+ * pushes or pops without the ABA problem. head and the counters sit in
+ * cache lines of their own; the whole block starts on a line boundary.
+ */
+#define GIC_POOL_NIL 0xFFFFu
+
+struct GIC_Pool
+{
+    APTR raw;    // allocation as returned by AllocMem()
+    u32 bytes;   // its size
+    u32 size;    // object stride
+    u32 count;
+    u8 *objects; // first object, line aligned
+    u8 pad0[GIC_QUEUE_LINE - 4 * sizeof(u32) - sizeof(u8 *)];
+    volatile u32 head; // tag << 16 | index of the first free object
+    u8 pad1[GIC_QUEUE_LINE - sizeof(u32)];
+    volatile u32 in_use;
+    volatile u32 high_water;
+    volatile u32 exhausted;
+    u8 pad2[GIC_QUEUE_LINE - 3 * sizeof(u32)];
+    u16 next[]; // free-list link per object
+};
+
+/* Warm-restart record left behind by an expunged library (SetWarmRestart).
+ * Lives in its own public allocation, published as a named semaphore so the
+ * next LibInit() finds it. The fields up to size keep their offsets in every
+ * version, so any version can unlink and free a record it does not accept.
+ */
+#define GIC_WARM_NAME "gic400.library warm restart"
+#define GIC_WARM_MAGIC 0x47494357u // 'GICW'
+#define GIC_WARM_VERSION 1
+
+struct GIC_WarmRecord
+{
+    struct SignalSemaphore semaphore;
+    char name[32]; // semaphore name, must outlive the library that wrote it
+    u32 magic;
+    u32 version;
+    u32 size; // whole allocation in bytes
+    u32 checksum; // over everything after this field
+    APTR gic_base_distributor;
+    APTR gic_base_cpuif;
+    u32 gicd_iidr;
+    u32 gicd_typer;
+    u32 gicc_iidr;
+    u32 dt_gic_phandle;
+    u32 regs[]; // IPRIORITYR[max_irqs / 4], ITARGETSR[max_irqs / 4], ICFGR[max_irqs / 16]
+};
+
+/* IRQ registered by latency class */
+struct GIC_ClassEntry
+{
+    u16 irq;
+    u8 priority; // last assigned
+    u8 met;
+    u32 target;  // us, GIC400_LATENCY_BULK for none
+    struct Interrupt *interrupt; // current server, followed by ReplaceIntServerEx()
+    volatile u32 count; // services in the current period
+    volatile u32 busy;  // server time in the current period, us
+    u32 rate;    // services per second, last period
+    u32 service; // mean server time, us
+    u32 bound;
+};
+
+/* Deferred work queue levels, one per GIC priority byte >> 4 */
+#define GIC_WORK_LEVELS 16
+
+/* Execution budget of one IRQ (SetIntBudget) */
+struct GIC_Budget
+{
+    u32 budget; // us
+    u32 runs;
+    u32 violations;
+    u32 worst; // us
+    u8 flags;   // GIC400_BUDGETF_*
+    u8 state;   // GIC400_BUDGET_*
+    u8 strikes; // violations net of compliant runs, up to GIC400_BUDGET_STRIKES
+    u8 pad;
+    struct GICWork work; // runs the server from the work queue while deferred
+};
+
+/* IRQ temporarily demoted by the fairness policy */
+struct GIC_FairDemotion
+{
+    u16 irq;
+    u8 saved;    // priority to restore
+    u8 demoted;  // priority we wrote; anything else means someone else changed it
+};
+
 /* GIC Base structure */
 struct GIC_Base
 {
@@ -63,12 +233,168 @@ struct GIC_Base
     APTR gic_base_distributor;
     APTR gic_base_cpuif;
     u32 max_irqs;
+    BOOL live; // gic400_ensure_live() has brought the controller up
     struct Interrupt **handlers;
+    u8 *irq_flags; // GIC_IRQF_* per IRQ, cleared (but GIC_IRQF_DT) when the server is removed
+    u32 *overruns; // per-IRQ re-pend counts, allocated by SetIntOverrunDetect()
+    u32 *stamps;   // per-IRQ last acknowledge time, allocated by SetIntTimestamp()
     u32 handler_count;
+    volatile u8 pmr; // shadow of GICC_PMR, written before the register
+
+    struct GIC_StagedInt *staged; // BeginIntConfig() table, max_irqs entries
+    struct Task *config_owner;    // task holding the semaphore for a transaction
+    u32 staged_count;
+
+    struct MinList groups; // GIC_IntGroups from AddIntServerGroup()
+
+    u32 dt_gic_phandle;          // interrupt-parent value naming the GIC
+    struct GIC_DTInt *dt_index;  // interrupts of all GIC-attached nodes, tree order
+    u32 dt_count;
 
     struct Interrupt dispatcher_interrupt;
+    BOOL dispatcher_installed; // on INTB_EXTER while a server exists or a line is enabled or pending
+    struct GIC_Dispatch dispatch;
+
+    APTR systimer_base;    // BCM2835 system timer, NULL when not found
+    u32 timer_irq;         // interrupt of the compare channel we own
+    u8 timer_channel;      // compare channel used for the timer service
+    BOOL timer_installed;  // timer server registered in the handler table
+    struct MinList timers; // armed GICTimers sorted by deadline
+    struct Interrupt timer_interrupt;
+
+    struct GICTimer profile_timer; // periodic sampling tick
+    struct Interrupt profile_interrupt;
+    struct GICProfileSample *profile_buffer;
+    u32 profile_size; // samples the buffer holds
+    volatile u32 profile_count;
+    volatile u32 profile_dropped; // ticks lost to a full buffer
+    u32 profile_anchor;           // words from the server's frame to the exception frame, 0 until found
+    BOOL profile_running;
+
+    u32 *fair_counts; // per IRQ: window epoch << 16 | services in that window
+    u32 fair_window;  // dispatches per window
+    u32 fair_share;   // services per IRQ per window before demotion
+    u32 fair_dispatches;
+    u32 fair_epoch;
+    u32 fair_demotions;
+    u32 fair_restores;
+    u32 fair_demoted_count;
+    struct GIC_FairDemotion fair_demoted[GIC400_FAIR_MAX_DEMOTED];
+
+    BOOL warm_restart; // leave a GIC_WarmRecord behind on expunge
+    struct GIC_WarmRecord *warm_record; // accepted at LibInit(), written back at bring-up
+
+    struct GICTraceRecord *trace_buffer;
+    u32 trace_size; // records the buffer holds
+    volatile u32 trace_count;
+    volatile u32 trace_dropped; // dispatches lost to a full buffer
+
+    struct GIC_StagedInt *tuning; // LoadIntTuning() overrides, max_irqs entries
+
+    struct GIC_ClassEntry class_entries[GIC400_CLASS_MAX];
+    u32 class_count;
+    struct GICTimer class_timer; // periodic re-assignment
+    struct Interrupt class_interrupt;
+    BOOL class_running;
+
+    struct GIC_Budget *budgets; // per IRQ, allocated by SetIntBudget()
+    struct Interrupt budget_runner; // work server of deferred IRQs
+
+    struct GICWork *work_heads[GIC_WORK_LEVELS]; // LIFO per priority level, most urgent first
+    struct Interrupt work_softint;
+
+#ifdef GIC400_MMIO_STATS
+    struct GICMmioStats mmio_stats[GIC400_STAT_COUNT];
+    u8 mmio_scope; // GIC400_STAT_* currently charged for MMIO accesses
+#endif
+};
+
+/* Byte-wide register access. The GIC is little-endian, so byte n of a
+ * register word lives at address offset n and no swapping is needed.
+ */
+static inline u8 gic_mmio_read8(APTR addr)
+{
+    return *(volatile u8 *)addr;
+}
+
+static inline void gic_mmio_write8(u8 value, APTR addr)
+{
+    *(volatile u8 *)addr = value;
+}
+
+/* GIC register accessors. All GICD/GICC accesses go through these so that a
+ * GIC400_MMIO_STATS build can charge them to the current entry point. Both
+ * expect a gicBase in scope, as the register macros below already do.
+ */
+#ifdef GIC400_MMIO_STATS
+#define gic_read32(addr) (gicBase->mmio_stats[gicBase->mmio_scope].reads++, mmio_read32(addr))
+#define gic_write32(value, addr)                              \
+    do                                                        \
+    {                                                         \
+        gicBase->mmio_stats[gicBase->mmio_scope].writes++;    \
+        mmio_write32((value), (addr));                        \
+    } while (0)
+#define gic_read8(addr) (gicBase->mmio_stats[gicBase->mmio_scope].reads++, gic_mmio_read8(addr))
+#define gic_write8(value, addr)                               \
+    do                                                        \
+    {                                                         \
+        gicBase->mmio_stats[gicBase->mmio_scope].writes++;    \
+        gic_mmio_write8((value), (addr));                     \
+    } while (0)
+
+struct gic_mmio_scope
+{
+    struct GIC_Base *base;
+    u8 saved;
 };
 
+static inline struct gic_mmio_scope gic_mmio_scope_enter(struct GIC_Base *gicBase, u8 entry)
+{
+    struct gic_mmio_scope scope = {gicBase, 0};
+    if (gicBase)
+    {
+        scope.saved = gicBase->mmio_scope;
+        gicBase->mmio_scope = entry;
+        gicBase->mmio_stats[entry].calls++;
+    }
+    return scope;
+}
+
+static inline void gic_mmio_scope_leave(struct gic_mmio_scope *scope)
+{
+    if (scope->base)
+        scope->base->mmio_scope = scope->saved;
+}
+
+/* Charge MMIO accesses until the end of the enclosing block to entry. The
+ * previous entry is restored on every return path, so nested calls (an API
+ * used from a handler, the dispatcher interrupting a task) stay attributed.
+ */
+#define GIC_MMIO_SCOPE(entry) \
+    struct gic_mmio_scope gic_mmio_scope_ __attribute__((cleanup(gic_mmio_scope_leave))) = gic_mmio_scope_enter(gicBase, (entry))
+#else
+#define gic_read32(addr) mmio_read32(addr)
+#define gic_write32(value, addr) mmio_write32((value), (addr))
+#define gic_read8(addr) gic_mmio_read8(addr)
+#define gic_write8(value, addr) gic_mmio_write8((value), (addr))
+#define GIC_MMIO_SCOPE(entry) \
+    do                        \
+    {                         \
+    } while (0)
+#endif
+
+/* Per-IRQ flags (gicBase->irq_flags). Flags that change how the dispatcher
+ * services an IRQ must also be listed in GIC_IRQF_DISPATCH_MASK.
+ */
+#define GIC_IRQF_SOFT (1u << 0)     // line handed out by AllocSoftInt()
+#define GIC_IRQF_OVERRUN (1u << 1)  // sample ISPENDR around the handler call
+#define GIC_IRQF_REPENDED (1u << 2) // last service ended with the IRQ pending
+#define GIC_IRQF_DT (1u << 3)       // named by a device-tree node, kept across servers
+#define GIC_IRQF_STAMP (1u << 4)    // read the system timer at acknowledge, pass it in D2
+#define GIC_IRQF_CLASS (1u << 5)    // registered by latency class, server time measured
+#define GIC_IRQF_BUDGET (1u << 6)   // server time checked against its budget
+#define GIC_IRQF_DEFERRED (1u << 7) // masked at acknowledge, served from the work queue
+
 /* GIC Distributor and CPU interface identification helpers. */
 #define GICD_IIDR_PRODUCT_ID(value) (((value) >> 24) & 0xFF)
 #define GICD_IIDR_VARIANT(value) (((value) >> 16) & 0x0F)
@@ -126,6 +452,8 @@ struct GIC_Base
 #define GICD_ICACTIVER(n) (gicBase->gic_base_distributor + 0x380 + (n) * 4)  // Interrupt Clear-Active Registers
 #define GICD_IPRIORITYR(n) (gicBase->gic_base_distributor + 0x400 + (n) * 4) // Interrupt Priority Registers
 #define GICD_ITARGETSR(n) (gicBase->gic_base_distributor + 0x800 + (n) * 4)  // Interrupt Processor Targets Registers
+#define GICD_IPRIORITYR_BYTE(irq) (gicBase->gic_base_distributor + 0x400 + (irq)) // Byte-wide view of IPRIORITYR
+#define GICD_ITARGETSR_BYTE(irq) (gicBase->gic_base_distributor + 0x800 + (irq))  // Byte-wide view of ITARGETSR
 #define GICD_ICFGR(n) (gicBase->gic_base_distributor + 0xC00 + (n) * 4)      // Interrupt Configuration Registers
 #define GICD_SPISR(n) (gicBase->gic_base_distributor + 0xD04 + (n) * 4)      // Shared Peripheral Interrupt Status Registers
 #define GICD_COMPONENT_ID (gicBase->gic_base_distributor + 0xFF0)            // Component ID Register
@@ -134,6 +462,14 @@ struct GIC_Base
 // TODO CPENDSGIR(n)
 // TODO SPENDSGIR(n)
 
+/* BCM2835 system timer: free-running 1 MHz counter with four compare channels.
+ * Channels 0 and 2 belong to the VideoCore; the ARM side may use 1 and 3.
+ */
+#define SYSTIMER_CS (gicBase->systimer_base + 0x00)             // Control/Status (match flags, write 1 to clear)
+#define SYSTIMER_CLO (gicBase->systimer_base + 0x04)            // Counter Lower 32 bits
+#define SYSTIMER_CHI (gicBase->systimer_base + 0x08)            // Counter Higher 32 bits
+#define SYSTIMER_C(n) (gicBase->systimer_base + 0x0C + (n) * 4) // Compare channel n
+
 /* API function prototypes */
 LONG AddIntServerEx(ULONG irq asm("d0"), UBYTE priority asm("d1"), BOOL edge asm("d2"), struct Interrupt *interrupt asm("a1"), struct GIC_Base *gicBase asm("a6"));
 LONG RemIntServerEx(ULONG irq asm("d0"), struct Interrupt *interrupt asm("a1"), struct GIC_Base *gicBase asm("a6"));
@@ -156,19 +492,172 @@ LONG GetPriorityMask(struct GIC_Base *gicBase asm("a6"));
 LONG GetRunningPriority(struct GIC_Base *gicBase asm("a6"));
 LONG GetHighestPending(struct GIC_Base *gicBase asm("a6"));
 LONG GetControllerInfo(struct GICInfo *info asm("a1"), struct GIC_Base *gicBase asm("a6"));
+LONG GetMmioStats(ULONG entry asm("d0"), struct GICMmioStats *stats asm("a1"), struct GIC_Base *gicBase asm("a6"));
+LONG ResetMmioStats(struct GIC_Base *gicBase asm("a6"));
+LONG SetIntTargets(ULONG irq asm("d0"), UBYTE cpuMask asm("d1"), struct GIC_Base *gicBase asm("a6"));
+LONG StartTimer(struct GICTimer *timer asm("a0"), ULONG delay asm("d0"), ULONG period asm("d1"), struct GIC_Base *gicBase asm("a6"));
+LONG StopTimer(struct GICTimer *timer asm("a0"), struct GIC_Base *gicBase asm("a6"));
+LONG ReadTimerCounter(ULONG *high asm("a0"), ULONG *low asm("a1"), struct GIC_Base *gicBase asm("a6"));
+LONG AllocSoftInt(UBYTE priority asm("d0"), struct Interrupt *interrupt asm("a1"), struct GIC_Base *gicBase asm("a6"));
+LONG FreeSoftInt(ULONG irq asm("d0"), struct GIC_Base *gicBase asm("a6"));
+LONG RaiseSoftInt(ULONG irq asm("d0"), struct GIC_Base *gicBase asm("a6"));
+LONG SetIntOverrunDetect(ULONG irq asm("d0"), BOOL enable asm("d1"), struct GIC_Base *gicBase asm("a6"));
+LONG GetIntOverruns(ULONG irq asm("d0"), BOOL reset asm("d1"), struct GIC_Base *gicBase asm("a6"));
+LONG RaiseIntPriority(UBYTE level asm("d0"), struct GIC_Base *gicBase asm("a6"));
+LONG RestoreIntPriority(ULONG token asm("d0"), struct GIC_Base *gicBase asm("a6"));
+LONG BeginIntConfig(struct GIC_Base *gicBase asm("a6"));
+LONG StageIntConfig(const struct GICIntSetting *setting asm("a0"), struct GIC_Base *gicBase asm("a6"));
+LONG CommitIntConfig(struct GIC_Base *gicBase asm("a6"));
+LONG AbortIntConfig(struct GIC_Base *gicBase asm("a6"));
+LONG AddIntServerGroup(const ULONG *irqs asm("a0"), ULONG count asm("d0"), UBYTE priority asm("d1"), BOOL edge asm("d2"), struct Interrupt *interrupt asm("a1"), struct GIC_Base *gicBase asm("a6"));
+LONG RemIntServerGroup(struct Interrupt *interrupt asm("a1"), struct GIC_Base *gicBase asm("a6"));
+LONG FindDTInterrupt(CONST_STRPTR name asm("a0"), ULONG index asm("d0"), ULONG *flags asm("a1"), struct GIC_Base *gicBase asm("a6"));
+LONG AddIntServerDT(CONST_STRPTR name asm("a0"), ULONG index asm("d0"), UBYTE priority asm("d1"), struct Interrupt *interrupt asm("a1"), struct GIC_Base *gicBase asm("a6"));
+LONG ReplaceIntServerEx(ULONG irq asm("d0"), struct Interrupt *oldInterrupt asm("a0"), struct Interrupt *newInterrupt asm("a1"), struct GIC_Base *gicBase asm("a6"));
+LONG StartProfiler(ULONG samples asm("d0"), ULONG interval asm("d1"), struct GIC_Base *gicBase asm("a6"));
+LONG StopProfiler(ULONG *dropped asm("a0"), struct GIC_Base *gicBase asm("a6"));
+LONG DumpProfiler(struct GICProfileSample *buffer asm("a0"), ULONG max asm("d0"), struct GIC_Base *gicBase asm("a6"));
+struct GICIntQueue *CreateIntQueue(ULONG capacity asm("d0"), struct Task *task asm("a0"), ULONG signalMask asm("d1"), struct GIC_Base *gicBase asm("a6"));
+LONG DeleteIntQueue(struct GICIntQueue *queue asm("a0"), struct GIC_Base *gicBase asm("a6"));
+LONG PutIntQueue(struct GICIntQueue *queue asm("a0"), APTR item asm("a1"), struct GIC_Base *gicBase asm("a6"));
+LONG GetIntQueue(struct GICIntQueue *queue asm("a0"), APTR *items asm("a1"), ULONG max asm("d0"), struct GIC_Base *gicBase asm("a6"));
+LONG SetIntFairness(ULONG window asm("d0"), ULONG share asm("d1"), struct GIC_Base *gicBase asm("a6"));
+LONG GetIntFairness(struct GICFairnessInfo *info asm("a0"), struct GIC_Base *gicBase asm("a6"));
+LONG SetIntTimestamp(ULONG irq asm("d0"), BOOL enable asm("d1"), struct GIC_Base *gicBase asm("a6"));
+LONG GetIntTimestamp(ULONG irq asm("d0"), ULONG *stamp asm("a0"), struct GIC_Base *gicBase asm("a6"));
+LONG MeasureIntLatency(struct GICLatencyProbe *probe asm("a0"), struct GIC_Base *gicBase asm("a6"));
+LONG SetWarmRestart(BOOL enable asm("d0"), struct GIC_Base *gicBase asm("a6"));
+LONG StartIntTrace(ULONG records asm("d0"), struct GIC_Base *gicBase asm("a6"));
+LONG StopIntTrace(ULONG *dropped asm("a0"), struct GIC_Base *gicBase asm("a6"));
+LONG ReadIntTrace(struct GICTraceRecord *buffer asm("a0"), ULONG max asm("d0"), struct GIC_Base *gicBase asm("a6"));
+LONG LoadIntTuning(CONST_STRPTR path asm("a0"), struct GIC_Base *gicBase asm("a6"));
+LONG AddIntServerClass(ULONG irq asm("d0"), ULONG latency asm("d1"), BOOL edge asm("d2"), struct Interrupt *interrupt asm("a1"), struct GIC_Base *gicBase asm("a6"));
+LONG GetIntClassMap(struct GICClassInfo *info asm("a0"), ULONG max asm("d0"), struct GIC_Base *gicBase asm("a6"));
+struct GICPool *CreateIntPool(ULONG size asm("d0"), ULONG count asm("d1"), struct GIC_Base *gicBase asm("a6"));
+LONG DeleteIntPool(struct GICPool *pool asm("a0"), struct GIC_Base *gicBase asm("a6"));
+APTR AllocPoolObject(struct GICPool *pool asm("a0"), struct GIC_Base *gicBase asm("a6"));
+LONG FreePoolObject(struct GICPool *pool asm("a0"), APTR object asm("a1"), struct GIC_Base *gicBase asm("a6"));
+LONG AllocPoolObjects(struct GICPool *pool asm("a0"), APTR *objects asm("a1"), ULONG count asm("d0"), struct GIC_Base *gicBase asm("a6"));
+LONG FreePoolObjects(struct GICPool *pool asm("a0"), APTR *objects asm("a1"), ULONG count asm("d0"), struct GIC_Base *gicBase asm("a6"));
+LONG GetPoolStats(struct GICPool *pool asm("a0"), struct GICPoolStats *stats asm("a1"), struct GIC_Base *gicBase asm("a6"));
+LONG SetIntBudget(ULONG irq asm("d0"), ULONG budget asm("d1"), ULONG flags asm("d2"), struct GIC_Base *gicBase asm("a6"));
+LONG GetIntBudgets(struct GICBudgetInfo *info asm("a0"), ULONG max asm("d0"), struct GIC_Base *gicBase asm("a6"));
+LONG QueueWork(struct GICWork *work asm("a0"), ULONG irq asm("d0"), struct GIC_Base *gicBase asm("a6"));
 
 /* Internal function prototypes and macros */
 s32 gic400_init(struct GIC_Base *gicBase);
+s32 gic400_ensure_live(struct GIC_Base *gicBase);
 void gic400_shutdown(struct GIC_Base *gicBase);
+void gic400_install_dispatcher(struct GIC_Base *gicBase);
+s32 gic400_add_server(struct GIC_Base *gicBase, u32 irq, u8 priority, BOOL edge, struct Interrupt *interrupt);
+s32 gic400_rem_server(struct GIC_Base *gicBase, u32 irq, struct Interrupt *interrupt);
+ULONG gic400_dispatch(struct GIC_Base *gicBase, u32 iar);
+#ifdef GIC400_ASM_DISPATCHER
+ULONG gic400_exec_dispatcher_asm(void);
+#endif
+s32 gic400_timer_init(struct GIC_Base *gicBase);
+void gic400_timer_shutdown(struct GIC_Base *gicBase);
+void gic400_profile_shutdown(struct GIC_Base *gicBase);
+void gic400_fair_account(struct GIC_Base *gicBase, u32 irq);
+void gic400_fair_shutdown(struct GIC_Base *gicBase);
+BOOL gic400_warm_restore(struct GIC_Base *gicBase);
+void gic400_warm_apply(struct GIC_Base *gicBase);
+void gic400_warm_save(struct GIC_Base *gicBase);
+void gic400_trace_record(struct GIC_Base *gicBase, u32 irq, u32 arrival, BOOL handled);
+void gic400_trace_shutdown(struct GIC_Base *gicBase);
+void gic400_tuning_start(struct GIC_Base *gicBase);
+void gic400_tuning_shutdown(struct GIC_Base *gicBase);
+void gic400_class_account(struct GIC_Base *gicBase, u32 irq, u32 elapsed);
+void gic400_class_forget(struct GIC_Base *gicBase, u32 irq, struct Interrupt *interrupt);
+void gic400_class_replace(struct GIC_Base *gicBase, u32 irq, struct Interrupt *interrupt);
+void gic400_class_shutdown(struct GIC_Base *gicBase);
+void gic400_budget_account(struct GIC_Base *gicBase, u32 irq, u32 elapsed);
+void gic400_budget_defer(struct GIC_Base *gicBase, u32 irq);
+void gic400_budget_shutdown(struct GIC_Base *gicBase);
+void gic400_work_init(struct GIC_Base *gicBase);
+BOOL gic400_work_queue(struct GIC_Base *gicBase, struct GICWork *work, u32 irq, u8 priority);
+void gic400_config_shutdown(struct GIC_Base *gicBase);
+void gic400_group_shutdown(struct GIC_Base *gicBase);
+s32 gic400_dt_init(struct GIC_Base *gicBase);
+void gic400_dt_shutdown(struct GIC_Base *gicBase);
+const struct GIC_DTInt *gic400_dt_find(struct GIC_Base *gicBase, CONST_STRPTR name, u32 index);
+BOOL gic400_dt_compatible(APTR DeviceTreeBase, APTR key, const char *compatible);
+
+/* gic400_timer_now: Low 32 bits of the system timer counter (one MMIO read). */
+#define gic400_timer_now() gic_read32(SYSTIMER_CLO)
+
+/* gic400_call_interrupt_hint: Invoke interrupt server with Exec ABI.
+ * Args: interrupt - Exec interrupt entry; irq - source IRQ number (D0);
+ *  hint - extra argument passed in D1.
+ * Returns: void.
+ */
+static inline void gic400_call_interrupt_hint(struct Interrupt *interrupt, u32 irq, u32 hint)
+{
+    if (interrupt == NULL || interrupt->is_Code == NULL)
+        return;
+
+#ifdef GIC400_HOST
+    gic400_host_call(interrupt, irq, hint, 0);
+#else
+    __asm__ __volatile__(
+        "move.l %[sysbase],%%a6\n\t"
+        "move.l %[irq],%%d0\n\t"
+        "move.l %[hint],%%d1\n\t"
+        "move.l %[data],%%a1\n\t"
+        "jsr (%[code])\n\t"
+        :
+        : [code] "a"(interrupt->is_Code),
+          [data] "r"(interrupt->is_Data),
+          [irq] "r"(irq),
+          [hint] "r"(hint),
+          [sysbase] "r"((struct ExecBase *)EXEC_BASE_NAME)
+        : "d0", "d1", "a0", "a1", "a5", "a6");
+#endif
+}
+
+/* gic400_call_interrupt_stamp: Invoke interrupt server with Exec ABI and an
+ * acknowledge timestamp.
+ * Args: interrupt - Exec interrupt entry; irq - source IRQ number (D0);
+ *  hint - extra argument passed in D1; stamp - system timer value (D2).
+ * Returns: void.
+ */
+static inline void gic400_call_interrupt_stamp(struct Interrupt *interrupt, u32 irq, u32 hint, u32 stamp)
+{
+    if (interrupt == NULL || interrupt->is_Code == NULL)
+        return;
+
+#ifdef GIC400_HOST
+    gic400_host_call(interrupt, irq, hint, stamp);
+#else
+    __asm__ __volatile__(
+        "move.l %[sysbase],%%a6\n\t"
+        "move.l %[irq],%%d0\n\t"
+        "move.l %[hint],%%d1\n\t"
+        "move.l %[stamp],%%d2\n\t"
+        "move.l %[data],%%a1\n\t"
+        "jsr (%[code])\n\t"
+        :
+        : [code] "a"(interrupt->is_Code),
+          [data] "r"(interrupt->is_Data),
+          [irq] "r"(irq),
+          [hint] "r"(hint),
+          [stamp] "r"(stamp),
+          [sysbase] "r"((struct ExecBase *)EXEC_BASE_NAME)
+        : "d0", "d1", "d2", "a0", "a1", "a5", "a6");
+#endif
+}
+
+/* gic400_call_interrupt: Invoke interrupt server with Exec ABI (D1 = 0). */
+#define gic400_call_interrupt(interrupt, irq) gic400_call_interrupt_hint((interrupt), (irq), 0)
 
-#define gicc_set_ctlr(ctlr_value) mmio_write32((ctlr_value), GICC_CTLR)
-#define gicc_get_ctlr() mmio_read32(GICC_CTLR)
-#define gicc_set_priority_mask(priority_value) mmio_write32((priority_value), GICC_PMR)
-#define gicc_acknowledge_interrupt() mmio_read32(GICC_IAR)
-#define gicc_end_interrupt(irq_value) mmio_write32((irq_value), GICC_EOIR)
-#define gicc_deactivate_interrupt(irq_value) mmio_write32((irq_value), GICC_DIR)
-#define gicc_get_running_priority() (mmio_read32(GICC_RPR) & 0xFF)
-#define gicc_get_highest_pending() (mmio_read32(GICC_HPPIR) & 0x3FF)
+#define gicc_set_ctlr(ctlr_value) gic_write32((ctlr_value), GICC_CTLR)
+#define gicc_get_ctlr() gic_read32(GICC_CTLR)
+#define gicc_set_priority_mask(priority_value) gic_write32((priority_value), GICC_PMR)
+#define gicc_acknowledge_interrupt() gic_read32(GICC_IAR)
+#define gicc_end_interrupt(irq_value) gic_write32((irq_value), GICC_EOIR)
+#define gicc_deactivate_interrupt(irq_value) gic_write32((irq_value), GICC_DIR)
+#define gicc_get_running_priority() (gic_read32(GICC_RPR) & 0xFF)
+#define gicc_get_highest_pending() (gic_read32(GICC_HPPIR) & 0x3FF)
 
 /* Debug-print helpers (their callers are DEBUG_HIGH-guarded). */
 #ifdef DEBUG
@@ -198,7 +687,7 @@ static inline void gicc_get_priority_mask(struct GIC_Base *gicBase, u8 *priority
     if (!gicBase || !priority)
         return;
 
-    *priority = mmio_read32(GICC_PMR) & 0xFF;
+    *priority = gic_read32(GICC_PMR) & 0xFF;
 }
 
 #ifdef DEBUG
@@ -218,7 +707,10 @@ u8 gicd_get_priority(struct GIC_Base *gicBase, u32 irq);
 void gicd_set_priority(struct GIC_Base *gicBase, u32 irq, u8 priority);
 BOOL gicd_is_cpu_enabled(struct GIC_Base *gicBase, u32 irq, u8 cpu);
 void gicd_set_cpu(struct GIC_Base *gicBase, u32 irq, u8 cpu, BOOL enable);
+void gicd_set_targets(struct GIC_Base *gicBase, u32 irq, u8 mask);
+void gicd_unroute_all(struct GIC_Base *gicBase, u8 cpu);
 void gicd_set_trigger(struct GIC_Base *gicBase, u32 irq, BOOL edge);
+BOOL gicd_is_edge(struct GIC_Base *gicBase, u32 irq);
 void gicd_set_active(struct GIC_Base *gicBase, u32 irq);
 void gicd_clear_active(struct GIC_Base *gicBase, u32 irq);
 u8 gicd_get_cpu_mask(struct GIC_Base *gicBase, u32 irq);
@@ -3,6 +3,8 @@
 #define LIBRARIES_GIC400_H
 
 #include <exec/types.h>
+#include <exec/nodes.h>
+#include <exec/interrupts.h>
 
 /* Public GIC-400 API status codes. Functions return 0 on success or one of
  * these negative values on failure.
@@ -15,6 +17,11 @@
 #define GIC400_ERR_NOT_FOUND ((LONG)-6)
 #define GIC400_ERR_NO_MEMORY ((LONG)-7)
 #define GIC400_ERR_DEVTREE ((LONG)-8)
+#define GIC400_ERR_NOT_SUPPORTED ((LONG)-9)
+#define GIC400_ERR_NO_FREE_IRQ ((LONG)-10)
+#define GIC400_ERR_BUSY ((LONG)-11)
+#define GIC400_ERR_FULL ((LONG)-12)
+#define GIC400_ERR_TIMEOUT ((LONG)-13)
 
 struct GICInfo
 {
@@ -27,4 +34,292 @@ struct GICInfo
     UBYTE lspiCount;
 };
 
+/* MMIO accounting entry points for GetMmioStats(). Every GIC register access
+ * is attributed to the public call (or the dispatcher) that caused it.
+ */
+#define GIC400_STAT_INIT 0
+#define GIC400_STAT_DISPATCHER 1
+#define GIC400_STAT_ADDINTSERVEREX 2
+#define GIC400_STAT_REMINTSERVEREX 3
+#define GIC400_STAT_GETINTSTATUS 4
+#define GIC400_STAT_ENABLEINT 5
+#define GIC400_STAT_DISABLEINT 6
+#define GIC400_STAT_SETINTPRIORITY 7
+#define GIC400_STAT_GETINTPRIORITY 8
+#define GIC400_STAT_SETINTTRIGGER 9
+#define GIC400_STAT_ROUTEINT 10
+#define GIC400_STAT_QUERYINTROUTE 11
+#define GIC400_STAT_SETINTPENDING 12
+#define GIC400_STAT_CLEARINTPENDING 13
+#define GIC400_STAT_SETINTACTIVE 14
+#define GIC400_STAT_CLEARINTACTIVE 15
+#define GIC400_STAT_PRIORITYMASK 16
+#define GIC400_STAT_GETRUNNINGPRIORITY 17
+#define GIC400_STAT_GETHIGHESTPENDING 18
+#define GIC400_STAT_SETINTTARGETS 19
+#define GIC400_STAT_TIMER 20
+#define GIC400_STAT_SOFTINT 21
+#define GIC400_STAT_OVERRUN 22
+#define GIC400_STAT_CONFIG 23
+#define GIC400_STAT_GROUP 24
+#define GIC400_STAT_DEVTREE 25
+#define GIC400_STAT_REPLACEINTSERVER 26
+#define GIC400_STAT_PROFILER 27
+#define GIC400_STAT_QUEUE 28
+#define GIC400_STAT_FAIRNESS 29
+#define GIC400_STAT_TIMESTAMP 30
+#define GIC400_STAT_PROBE 31
+#define GIC400_STAT_WARM 32
+#define GIC400_STAT_TRACE 33
+#define GIC400_STAT_TUNING 34
+#define GIC400_STAT_CLASS 35
+#define GIC400_STAT_POOL 36
+#define GIC400_STAT_BUDGET 37
+#define GIC400_STAT_WORK 38
+#define GIC400_STAT_COUNT 39
+
+struct GICMmioStats
+{
+    ULONG calls;
+    ULONG reads;
+    ULONG writes;
+};
+
+/* High-resolution timer service (StartTimer/StopTimer). Delays, periods and
+ * ReadTimerCounter() values are in ticks of GIC400_TIMER_FREQUENCY.
+ * The interrupt's is_Code is called at interrupt level with is_Data in A1
+ * and the expired deadline (counter value) in D0.
+ */
+#define GIC400_TIMER_FREQUENCY 1000000UL
+/* Shortest period StartTimer() accepts for a periodic timer, in ticks. */
+#define GIC400_TIMER_MIN_PERIOD 20
+
+struct GICTimer
+{
+    struct MinNode node;         /* private */
+    struct Interrupt *interrupt; /* server called on expiry */
+    ULONG deadline;              /* private: counter value of the next expiry */
+    ULONG period;                /* private: reload in ticks, 0 for one-shot */
+    UBYTE armed;                 /* private */
+};
+
+/* Coalesced-edge detection (SetIntOverrunDetect). While enabled for an IRQ,
+ * its server is called with D1 = 1 when further edges may have been merged
+ * into this invocation, so the driver should drain its source completely;
+ * otherwise D1 = 0. GetIntOverruns() counts services that ended with the
+ * IRQ pending again.
+ */
+
+/* Acknowledge timestamps (SetIntTimestamp). While enabled for an IRQ, its
+ * server is called with D2 = low 32 bits of the 1 MHz system timer, read
+ * right after the interrupt was acknowledged. GetIntTimestamp() returns the
+ * value of the last acknowledge.
+ */
+
+/* Transactional configuration (BeginIntConfig/StageIntConfig/CommitIntConfig).
+ * Only the fields selected in flags are changed; staging the same IRQ again
+ * merges into the earlier setting.
+ */
+#define GIC400_CFGF_PRIORITY (1 << 0) /* set priority */
+#define GIC400_CFGF_TRIGGER (1 << 1)  /* set edge/level from edge */
+#define GIC400_CFGF_TARGETS (1 << 2)  /* set CPU target mask (SPIs only) */
+#define GIC400_CFGF_ENABLE (1 << 3)   /* enable or disable from enable */
+
+struct GICIntSetting
+{
+    ULONG irq;
+    UBYTE flags;    /* GIC400_CFGF_* */
+    UBYTE priority; /* GIC priority byte */
+    UBYTE cpuMask;  /* bit n routes to CPU n */
+    UBYTE edge;     /* TRUE for edge-triggered */
+    UBYTE enable;   /* TRUE to leave the IRQ enabled */
+};
+
+/* Grouped IRQ sets (AddIntServerGroup). The server is called once per burst
+ * with the acknowledged IRQ in D0 and a mask of the members that fired in
+ * D1, bit n standing for irqs[n] as passed at registration.
+ */
+#define GIC400_GROUP_MAX 32
+
+/* Device-tree trigger flags reported by FindDTInterrupt() (third cell of a
+ * GIC interrupt specifier).
+ */
+#define GIC400_DT_TRIGGER_EDGE_RISING 0x01
+#define GIC400_DT_TRIGGER_EDGE_FALLING 0x02
+#define GIC400_DT_TRIGGER_LEVEL_HIGH 0x04
+#define GIC400_DT_TRIGGER_LEVEL_LOW 0x08
+#define GIC400_DT_TRIGGER_EDGE (GIC400_DT_TRIGGER_EDGE_RISING | GIC400_DT_TRIGGER_EDGE_FALLING)
+
+/* PC-sampling profiler (StartProfiler/StopProfiler/DumpProfiler). One sample
+ * per timer tick: the program counter and status register of the code the
+ * level 6 interrupt interrupted, and the task that was running.
+ */
+#define GIC400_PROF_MAX 0x100000 /* samples per buffer */
+#define GIC400_PROF_NOFRAME 0x0001 /* exception frame not found, pc/sr invalid */
+#define GIC400_PROF_AMBIGUOUS 0x0002 /* several candidate frames (with NOFRAME) */
+
+struct GICProfileSample
+{
+    ULONG pc;    /* interrupted program counter */
+    APTR task;   /* running task */
+    UWORD sr;    /* interrupted status register */
+    UWORD flags; /* GIC400_PROF_* */
+};
+
+/* Interrupt-to-task handoff ring (CreateIntQueue). One interrupt server
+ * puts, one task gets; neither side locks. The task is signalled when the
+ * ring goes from empty to non-empty, so after a wakeup it must call
+ * GetIntQueue() until it returns 0.
+ */
+struct GICIntQueue; /* private */
+
+/* Fair-share priority demotion (SetIntFairness). An IRQ serviced more than
+ * share times within window dispatches is demoted one step until a window
+ * in which it stays within its share.
+ */
+#define GIC400_FAIR_MAX_DEMOTED 16
+
+struct GICFairnessInfo
+{
+    ULONG window;       /* dispatches per window, 0 when disabled */
+    ULONG share;        /* services per IRQ and window */
+    ULONG demotions;    /* total demotions since SetIntFairness() */
+    ULONG restores;     /* total restores since SetIntFairness() */
+    UWORD demotedCount; /* IRQs currently demoted */
+    UWORD demoted[GIC400_FAIR_MAX_DEMOTED];
+};
+
+/* Interrupt latency probe (MeasureIntLatency). Times are in microseconds of
+ * the system timer; entry runs from the ISPENDR write to the server's first
+ * instruction, exit from there until the raising task runs again (rest of
+ * the dispatcher, EOI and exception return).
+ */
+#define GIC400_PROBE_MAX 4096
+
+struct GICLatencyStats
+{
+    ULONG min;
+    ULONG mean;
+    ULONG p99;
+    ULONG max;
+};
+
+struct GICLatencyProbe
+{
+    ULONG iterations;             /* in: number of raises (1-GIC400_PROBE_MAX) */
+    UBYTE priority;               /* in: priority of the probe SPI (0-0x7f) */
+    UBYTE pad[3];
+    ULONG irq;                    /* out: SPI used */
+    struct GICLatencyStats entry; /* out: pend to server entry */
+    struct GICLatencyStats exit;  /* out: server entry to task resume */
+};
+
+/* Interrupt trace (StartIntTrace). One record per dispatched IRQ, in arrival
+ * order; times are 1 MHz system timer values, so inter-arrival times are the
+ * differences of consecutive arrival fields. Records are written big-endian
+ * as seen by the m68k, and a capture is simply an array of them.
+ */
+#define GIC400_TRACE_MAX 0x100000      /* records per trace buffer */
+#define GIC400_TRACE_UNHANDLED 0x0001 /* no server was registered */
+
+struct GICTraceRecord
+{
+    ULONG arrival;  /* timer value right after GICC_IAR was read */
+    ULONG duration; /* server call time, up to just before EOI */
+    UWORD irq;
+    UWORD flags;    /* GIC400_TRACE_* */
+};
+
+/* IRQ tuning profile (LoadIntTuning), read from GIC400_TUNING_FILE at
+ * startup. One IRQ per line, '#' starts a comment:
+ *
+ *   <irq> [priority=<n>] [trigger=edge|level] [targets=<mask>]
+ *
+ * where <irq> is an IRQ number, or a device-tree node path or compatible
+ * string with an optional ":<index>" into its "interrupts" property.
+ * Numbers may be given in decimal or with a 0x prefix. Listed settings
+ * override what drivers pass to AddIntServerEx() and friends.
+ */
+#define GIC400_TUNING_FILE "ENV:gic400.prefs"
+
+/* Latency-class registration (AddIntServerClass). Instead of a priority
+ * byte the driver states the latency it needs; the library orders all
+ * classed IRQs by that target and their measured service time and assigns
+ * the priorities, revisiting them as rates and service times change.
+ */
+#define GIC400_LATENCY_BULK 0 /* no latency requirement */
+#define GIC400_CLASS_MAX 32   /* classed IRQs at a time */
+
+struct GICClassInfo
+{
+    ULONG irq;
+    ULONG target;   /* requested latency in us, GIC400_LATENCY_BULK for none */
+    ULONG rate;     /* measured services per second */
+    ULONG service;  /* measured mean server time in us */
+    ULONG bound;    /* estimated worst-case latency in us, 0 for bulk */
+    UBYTE priority; /* assigned priority byte */
+    UBYTE met;      /* TRUE when bound is within target */
+    UWORD pad;
+};
+
+/* Interrupt-safe object pool (CreateIntPool). Created and deleted by a task;
+ * objects are taken and returned from any context, interrupt servers
+ * included, in constant time and without locks.
+ */
+#define GIC400_POOL_MAX 65535 /* objects per pool */
+
+struct GICPool; /* private */
+
+struct GICPoolStats
+{
+    ULONG size;      /* object size in bytes, rounded up */
+    ULONG count;     /* objects in the pool */
+    ULONG inUse;     /* objects currently allocated */
+    ULONG highWater; /* most objects ever allocated at once */
+    ULONG exhausted; /* allocations that found the pool empty */
+};
+
+/* Handler execution budgets (SetIntBudget). The dispatcher times the server
+ * of a budgeted IRQ; each run over budget is a violation and adds a strike,
+ * each run within budget takes one away. At GIC400_BUDGET_STRIKES the IRQ
+ * is flagged. With GIC400_BUDGETF_DEFER a flagged IRQ is also moved to
+ * deferred mode: the dispatcher masks it and acknowledges it, and its
+ * server runs from the deferred work queue, which unmasks it afterwards.
+ * The server then no longer holds level 6 or the GIC running priority.
+ */
+#define GIC400_BUDGET_STRIKES 4
+
+#define GIC400_BUDGETF_DEFER (1UL << 0) /* defer automatically once flagged */
+
+#define GIC400_BUDGET_FLAGGED (1 << 0)  /* repeatedly over budget */
+#define GIC400_BUDGET_DEFERRED (1 << 1) /* server runs from the work queue */
+
+struct GICBudgetInfo
+{
+    ULONG irq;
+    ULONG budget;     /* allowed server time in us */
+    ULONG runs;       /* timed server calls */
+    ULONG violations; /* calls over budget */
+    ULONG worst;      /* longest server time in us */
+    UWORD flags;      /* GIC400_BUDGETF_* */
+    UWORD state;      /* GIC400_BUDGET_* */
+};
+
+/* Deferred work queue (QueueWork). Interrupt servers queue preallocated
+ * items for follow-up work; a single soft interrupt runs everything
+ * queued, most urgent GIC priority first and in queueing order within a
+ * priority, so one wakeup serves all devices with work pending. The
+ * server is called with D0 = IRQ and A1 = is_Data. An item may be queued
+ * again once its server has been entered, and must not be freed while
+ * queued.
+ */
+struct GICWork
+{
+    struct GICWork *next;        /* private */
+    struct Interrupt *interrupt; /* server to run */
+    ULONG irq;                   /* private: IRQ the work was queued for */
+    UBYTE queued;                /* private */
+    UBYTE pad[3];
+};
+
 #endif /* LIBRARIES_GIC400_H */
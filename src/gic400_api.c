@@ -6,11 +6,34 @@
 #define __NOLIBBASE__
 #include <devtree.h>
 
+#ifdef GIC400_ASM_DISPATCHER
+#include <stddef.h>
+
+_Static_assert(offsetof(struct GIC_Dispatch, gicc_iar) == GIC_DISPATCH_IAR, "GIC_DISPATCH_IAR");
+_Static_assert(offsetof(struct GIC_Dispatch, gicc_eoir) == GIC_DISPATCH_EOIR, "GIC_DISPATCH_EOIR");
+_Static_assert(offsetof(struct GIC_Dispatch, max_irqs) == GIC_DISPATCH_MAX_IRQS, "GIC_DISPATCH_MAX_IRQS");
+_Static_assert(offsetof(struct GIC_Dispatch, handlers) == GIC_DISPATCH_HANDLERS, "GIC_DISPATCH_HANDLERS");
+_Static_assert(offsetof(struct GIC_Dispatch, irq_flags) == GIC_DISPATCH_FLAGS, "GIC_DISPATCH_FLAGS");
+_Static_assert(offsetof(struct GIC_Dispatch, base) == GIC_DISPATCH_BASE, "GIC_DISPATCH_BASE");
+_Static_assert(offsetof(struct GIC_Dispatch, hooks) == GIC_DISPATCH_HOOKS, "GIC_DISPATCH_HOOKS");
+_Static_assert(offsetof(struct Interrupt, is_Data) == GIC_IS_DATA, "GIC_IS_DATA");
+_Static_assert(offsetof(struct Interrupt, is_Code) == GIC_IS_CODE, "GIC_IS_CODE");
+_Static_assert((GIC_IRQF_DISPATCH_MASK & GIC_IRQF_OVERRUN) == GIC_IRQF_OVERRUN, "GIC_IRQF_DISPATCH_MASK");
+_Static_assert((GIC_IRQF_DISPATCH_MASK & GIC_IRQF_STAMP) == GIC_IRQF_STAMP, "GIC_IRQF_DISPATCH_MASK");
+_Static_assert((GIC_IRQF_DISPATCH_MASK & GIC_IRQF_CLASS) == GIC_IRQF_CLASS, "GIC_IRQF_DISPATCH_MASK");
+_Static_assert((GIC_IRQF_DISPATCH_MASK & GIC_IRQF_BUDGET) == GIC_IRQF_BUDGET, "GIC_IRQF_DISPATCH_MASK");
+_Static_assert((GIC_IRQF_DISPATCH_MASK & GIC_IRQF_DEFERRED) == GIC_IRQF_DEFERRED, "GIC_IRQF_DISPATCH_MASK");
+#endif
+
 static const char gic_dispatcher_name[] = "ARM GIC-400 dispatcher";
 
 /* forward declarations */
+#ifndef GIC400_ASM_DISPATCHER
 static ULONG gic400_exec_dispatcher(register struct GIC_Base *gicBase asm("a1"));
+#endif
 static void gic400_disable_irq(struct GIC_Base *gicBase, u32 irq);
+static BOOL gic400_lines_asserted(struct GIC_Base *gicBase);
+static void gic400_release_dispatcher(struct GIC_Base *gicBase);
 
 static s32 gic400_validate_irq(struct GIC_Base *gicBase, u32 irq)
 {
@@ -32,7 +55,7 @@ static s32 gic400_validate_irq(struct GIC_Base *gicBase, u32 irq)
         return GIC400_ERR_INVALID_IRQ;
     }
 
-    return 0;
+    return gic400_ensure_live(gicBase);
 }
 
 static s32 gic400_parse_devicetree(struct GIC_Base *gicBase)
@@ -52,6 +75,7 @@ static s32 gic400_parse_devicetree(struct GIC_Base *gicBase)
     }
 
     const u32 gic_phandle = DT_GetPropertyValueULONG(root_key, "interrupt-parent", 1, FALSE);
+    gicBase->dt_gic_phandle = gic_phandle;
 
     APTR gic_key = DT_FindByPHandle(root_key, gic_phandle);
     if (gic_key == NULL)
@@ -108,27 +132,78 @@ static s32 gic400_parse_devicetree(struct GIC_Base *gicBase)
     return 0;
 }
 
-/* gic400_init: Initialize GIC state and install dispatcher.
- * Args: base - physical base address shared with Emu68.
+/* gic400_init: Discover the controller; called from LibInit().
+ * Only locates the GIC and caches its ID registers, so opening the library
+ * to query it costs no allocation and no interrupt-off time. Everything
+ * else is left to gic400_ensure_live().
  * Returns: 0 on success, negative GIC400_ERR_* on failure.
  */
 s32 gic400_init(struct GIC_Base *gicBase)
 {
+    GIC_MMIO_SCOPE(GIC400_STAT_INIT);
     if (!gicBase)
         return GIC400_ERR_NOT_READY;
 
-    s32 ret = gic400_parse_devicetree(gicBase);
-    if (ret < 0)
-        return ret;
+    /* A record left by a previous instance replaces the device-tree lookup
+     * here and the SPI reset at bring-up */
+    gicBase->warm_record = NULL;
+    BOOL warm = gic400_warm_restore(gicBase);
+    if (!warm)
+    {
+        s32 ret = gic400_parse_devicetree(gicBase);
+        if (ret < 0)
+            return ret;
+    }
 
-    gicBase->gicd_iidr = mmio_read32(GICD_IIDR);
-    gicBase->gicd_typer = mmio_read32(GICD_TYPER);
-    gicBase->gicc_iidr = mmio_read32(GICC_IIDR);
+    gicBase->gicd_iidr = gic_read32(GICD_IIDR);
+    gicBase->gicd_typer = gic_read32(GICD_TYPER);
+    gicBase->gicc_iidr = gic_read32(GICC_IIDR);
 
     gicBase->max_irqs = (GICD_TYPER_IT_LINES_NUMBER(gicBase->gicd_typer) + 1) * 32;
 
+    gicBase->live = FALSE;
+    gicBase->pmr = 0x7F; // GICC_PMR is only written at bring-up or on request
     gicBase->handler_count = 0;
     gicBase->handlers = NULL;
+    gicBase->irq_flags = NULL;
+    gicBase->overruns = NULL;
+    gicBase->stamps = NULL;
+    gicBase->staged = NULL;
+    gicBase->dt_index = NULL;
+    gicBase->dt_count = 0;
+    gicBase->systimer_base = NULL;
+    gicBase->timer_installed = FALSE;
+    gicBase->dispatcher_installed = FALSE;
+    gicBase->dispatch.hooks = 0;
+    gicBase->profile_buffer = NULL;
+    gicBase->profile_count = 0;
+    gicBase->fair_counts = NULL;
+    gicBase->fair_demoted_count = 0;
+    gicBase->trace_buffer = NULL;
+    gicBase->tuning = NULL;
+    gicBase->class_count = 0;
+    gicBase->class_running = FALSE;
+    gicBase->budgets = NULL;
+    gic400_work_init(gicBase);
+    gicBase->trace_count = 0;
+    gicBase->warm_restart = warm; // keep the chain going once it was used
+    gicBase->profile_running = FALSE;
+    gicBase->config_owner = NULL;
+    gicBase->groups.mlh_Head = (struct MinNode *)&gicBase->groups.mlh_Tail;
+    gicBase->groups.mlh_Tail = NULL;
+    gicBase->groups.mlh_TailPred = (struct MinNode *)&gicBase->groups.mlh_Head;
+
+    return 0;
+}
+
+/* gic400_bring_up: Allocate the tables and enable the controller.
+ * Must be called with the library semaphore held.
+ * Returns: 0 on success, negative GIC400_ERR_* on failure.
+ */
+static s32 gic400_bring_up(struct GIC_Base *gicBase)
+{
+    GIC_MMIO_SCOPE(GIC400_STAT_INIT);
+
     u32 handler_bytes = gicBase->max_irqs * sizeof(struct Interrupt *);
     gicBase->handlers = AllocMem(handler_bytes, MEMF_CLEAR);
     if (!gicBase->handlers)
@@ -137,22 +212,38 @@ s32 gic400_init(struct GIC_Base *gicBase)
         return GIC400_ERR_NO_MEMORY;
     }
 
+    gicBase->irq_flags = AllocMem(gicBase->max_irqs, MEMF_CLEAR);
+    if (!gicBase->irq_flags)
+    {
+        Kprintf("[gic] %s: Failed to allocate IRQ flags (%lu bytes)\n", __func__, gicBase->max_irqs);
+        FreeMem(gicBase->handlers, handler_bytes);
+        gicBase->handlers = NULL;
+        return GIC400_ERR_NO_MEMORY;
+    }
+
+    /* Both are optional; the timer service looks itself up in the index */
+    gic400_dt_init(gicBase);
+    gic400_timer_init(gicBase);
+
 #ifdef DEBUG_HIGH
     gicc_print_info(gicBase->gicc_iidr);
     gicd_print_info(gicBase);
 #endif
 
+    BOOL warm = gicBase->warm_record != NULL;
+    if (warm)
+        gic400_warm_apply(gicBase);
+
     Disable();
 
     /* We're not sure what the state of the GIC-400 is.
      * So, to be on the safe side, we'll unroute all SPIs
-     * from CPU 0 before enabling the controller and distributor */
-    for (u32 irq = 0; irq < gicBase->max_irqs; irq++)
-    {
-        gicd_set_cpu(gicBase, irq, 0, FALSE);
-    }
+     * from CPU 0 before enabling the controller and distributor.
+     * After a warm restart the routing was restored from the record. */
+    if (!warm)
+        gicd_unroute_all(gicBase, 0);
 
-    gicc_set_priority_mask(0x7F); // allow all priorities
+    gicc_set_priority_mask(gicBase->pmr); // all priorities, unless raised before bring-up
 
     u32 ctlr = gicc_get_ctlr();
 
@@ -173,27 +264,79 @@ s32 gic400_init(struct GIC_Base *gicBase)
     gicBase->dispatcher_interrupt.is_Node.ln_Type = NT_INTERRUPT;
     gicBase->dispatcher_interrupt.is_Node.ln_Pri = 100;
     gicBase->dispatcher_interrupt.is_Node.ln_Name = (char *)gic_dispatcher_name;
+    gicBase->dispatch.gicc_iar = GICC_IAR;
+    gicBase->dispatch.gicc_eoir = GICC_EOIR;
+    gicBase->dispatch.max_irqs = gicBase->max_irqs;
+    gicBase->dispatch.handlers = gicBase->handlers;
+    gicBase->dispatch.irq_flags = gicBase->irq_flags;
+    gicBase->dispatch.base = gicBase;
+#ifdef GIC400_ASM_DISPATCHER
+    gicBase->dispatcher_interrupt.is_Data = &gicBase->dispatch;
+    gicBase->dispatcher_interrupt.is_Code = (APTR)gic400_exec_dispatcher_asm;
+#else
     gicBase->dispatcher_interrupt.is_Data = gicBase;
     gicBase->dispatcher_interrupt.is_Code = (APTR)gic400_exec_dispatcher;
-    AddIntServer(INTB_EXTER, &gicBase->dispatcher_interrupt);
-    KprintfH("[gic] dispatcher installed on INTB_EXTER\n");
+#endif
+    gicBase->dispatcher_installed = FALSE; // added with the first server
+    if (gic400_lines_asserted(gicBase))
+        gic400_install_dispatcher(gicBase); // restored or inherited lines can fire before any server exists
+    gicBase->live = TRUE;
     Enable();
 
+    KprintfH("[gic] %s: Controller up, %lu IRQs\n", __func__, gicBase->max_irqs);
+
+    gic400_tuning_start(gicBase); // the profile may name device-tree nodes
     return 0;
 }
 
+/* gic400_ensure_live: Bring the controller up on first use.
+ * Every entry point that touches the handler table, the CPU interface or
+ * the routing of an IRQ calls this first; the first such call does what
+ * LibInit() used to do eagerly, later ones cost a flag test. The first
+ * call must come from a task.
+ * Returns: 0 when the controller is up, negative GIC400_ERR_* on failure.
+ */
+s32 gic400_ensure_live(struct GIC_Base *gicBase)
+{
+    if (gicBase->live)
+        return 0;
+
+    ObtainSemaphore(&gicBase->semaphore);
+    s32 ret = gicBase->live ? 0 : gic400_bring_up(gicBase);
+    ReleaseSemaphore(&gicBase->semaphore);
+    return ret;
+}
+
 /* gic400_shutdown: Remove all handlers and dispatcher.
  * Args: none.
  * Returns: void.
  */
 void gic400_shutdown(struct GIC_Base *gicBase)
 {
+    GIC_MMIO_SCOPE(GIC400_STAT_INIT);
     if (!gicBase)
         return;
 
+    gic400_profile_shutdown(gicBase);
+    gic400_trace_shutdown(gicBase);
+    gic400_fair_shutdown(gicBase);
+    gic400_class_shutdown(gicBase);
+    gic400_warm_save(gicBase); // before any server is stripped
+    gic400_timer_shutdown(gicBase);
+    gic400_config_shutdown(gicBase);
+    gic400_group_shutdown(gicBase);
+    gic400_tuning_shutdown(gicBase);
+
+    if (!gicBase->live)
+        return; // never brought up, the controller is as we found it
+
     Disable();
 
-    RemIntServer(INTB_EXTER, &gicBase->dispatcher_interrupt);
+    if (gicBase->dispatcher_installed)
+    {
+        RemIntServer(INTB_EXTER, &gicBase->dispatcher_interrupt);
+        gicBase->dispatcher_installed = FALSE;
+    }
     gicd_disable(gicBase);
 
     for (u32 irq = 0; irq < gicBase->max_irqs; irq++)
@@ -202,13 +345,13 @@ void gic400_shutdown(struct GIC_Base *gicBase)
         {
             gic400_disable_irq(gicBase, irq);
             gicBase->handlers[irq] = NULL;
+            gicBase->irq_flags[irq] = 0;
             Kprintf("[gic] warning: removed handler for IRQ %ld during shutdown\n", irq);
         }
     }
     gicBase->handler_count = 0;
 
     Enable();
-    KprintfH("[gic] dispatcher removed from INTB_EXTER\n");
 
     if (gicBase->handlers)
     {
@@ -216,9 +359,32 @@ void gic400_shutdown(struct GIC_Base *gicBase)
         FreeMem(gicBase->handlers, handler_bytes);
         gicBase->handlers = NULL;
     }
+
+    if (gicBase->irq_flags)
+    {
+        FreeMem(gicBase->irq_flags, gicBase->max_irqs);
+        gicBase->irq_flags = NULL;
+    }
+
+    gic400_dt_shutdown(gicBase);
+
+    if (gicBase->overruns)
+    {
+        FreeMem(gicBase->overruns, gicBase->max_irqs * sizeof(u32));
+        gicBase->overruns = NULL;
+    }
+    if (gicBase->stamps)
+    {
+        FreeMem(gicBase->stamps, gicBase->max_irqs * sizeof(u32));
+        gicBase->stamps = NULL;
+    }
+    gic400_budget_shutdown(gicBase);
+
+    gicBase->live = FALSE;
 }
 
 /* gic400_enable_irq: Configure group 0 SPI and enable it.
+ * Settings from the tuning profile take precedence over the caller's.
  * Args:
  *  irq - interrupt number
  *  priority - priority byte to assign
@@ -226,16 +392,22 @@ void gic400_shutdown(struct GIC_Base *gicBase)
  */
 static void gic400_enable_irq(struct GIC_Base *gicBase, u32 irq, u8 priority, BOOL edge)
 {
+    u8 targets = 0x01; // CPU0 only
+    const struct GIC_StagedInt *tune = gicBase->tuning ? &gicBase->tuning[irq] : NULL;
+    if (tune && (tune->flags & GIC400_CFGF_PRIORITY))
+        priority = tune->priority;
+    if (tune && (tune->flags & GIC400_CFGF_TRIGGER))
+        edge = (tune->state & GIC_STAGED_EDGE) != 0;
+    if (tune && (tune->flags & GIC400_CFGF_TARGETS))
+        targets = tune->targets;
+
     Kprintf("[gic] Enabling IRQ %ld with priority %lu\n", irq, priority);
 
     gicd_disable_irq(gicBase, irq); // disable IRQ before configuration
 
     gicd_set_priority(gicBase, irq, priority); // set priority
-    gicd_set_cpu(gicBase, irq, 0, TRUE);       // route to CPU0
-    gicd_set_cpu(gicBase, irq, 1, FALSE);
-    gicd_set_cpu(gicBase, irq, 2, FALSE);
-    gicd_set_cpu(gicBase, irq, 3, FALSE);
-    gicd_set_trigger(gicBase, irq, edge); // set level-triggered
+    gicd_set_targets(gicBase, irq, targets);   // route as tuned, CPU0 by default
+    gicd_set_trigger(gicBase, irq, edge);      // set edge or level trigger
 
     gicd_enable_irq(gicBase, irq); // enable IRQ
 }
@@ -257,6 +429,7 @@ static void gic400_disable_irq(struct GIC_Base *gicBase, u32 irq)
  */
 LONG GetIntStatus(ULONG irq asm("d0"), BOOL *pending asm("a1"), BOOL *active asm("a2"), BOOL *enabled asm("a3"), struct GIC_Base *gicBase asm("a6"))
 {
+    GIC_MMIO_SCOPE(GIC400_STAT_GETINTSTATUS);
     LONG ret = gic400_validate_irq(gicBase, irq);
     if (ret < 0)
         return ret;
@@ -273,16 +446,21 @@ LONG GetIntStatus(ULONG irq asm("d0"), BOOL *pending asm("a1"), BOOL *active asm
 
 LONG EnableInt(ULONG irq asm("d0"), struct GIC_Base *gicBase asm("a6"))
 {
+    GIC_MMIO_SCOPE(GIC400_STAT_ENABLEINT);
     LONG ret = gic400_validate_irq(gicBase, irq);
     if (ret < 0)
         return ret;
 
+    Disable();
+    gic400_install_dispatcher(gicBase); // a serverless line must still be acknowledged
     gicd_enable_irq(gicBase, irq);
+    Enable();
     return 0;
 }
 
 LONG DisableInt(ULONG irq asm("d0"), struct GIC_Base *gicBase asm("a6"))
 {
+    GIC_MMIO_SCOPE(GIC400_STAT_DISABLEINT);
     LONG ret = gic400_validate_irq(gicBase, irq);
     if (ret < 0)
         return ret;
@@ -293,6 +471,7 @@ LONG DisableInt(ULONG irq asm("d0"), struct GIC_Base *gicBase asm("a6"))
 
 LONG SetIntPriority(ULONG irq asm("d0"), UBYTE priority asm("d1"), struct GIC_Base *gicBase asm("a6"))
 {
+    GIC_MMIO_SCOPE(GIC400_STAT_SETINTPRIORITY);
     LONG ret = gic400_validate_irq(gicBase, irq);
     if (ret < 0)
         return ret;
@@ -304,6 +483,7 @@ LONG SetIntPriority(ULONG irq asm("d0"), UBYTE priority asm("d1"), struct GIC_Ba
 /* GetIntPriority: Return the priority byte for an IRQ or a negative GIC400_ERR_*. */
 LONG GetIntPriority(ULONG irq asm("d0"), struct GIC_Base *gicBase asm("a6"))
 {
+    GIC_MMIO_SCOPE(GIC400_STAT_GETINTPRIORITY);
     LONG ret = gic400_validate_irq(gicBase, irq);
     if (ret < 0)
         return ret;
@@ -313,6 +493,7 @@ LONG GetIntPriority(ULONG irq asm("d0"), struct GIC_Base *gicBase asm("a6"))
 
 LONG SetIntTriggerEdge(ULONG irq asm("d0"), struct GIC_Base *gicBase asm("a6"))
 {
+    GIC_MMIO_SCOPE(GIC400_STAT_SETINTTRIGGER);
     LONG ret = gic400_validate_irq(gicBase, irq);
     if (ret < 0)
         return ret;
@@ -323,6 +504,7 @@ LONG SetIntTriggerEdge(ULONG irq asm("d0"), struct GIC_Base *gicBase asm("a6"))
 
 LONG SetIntTriggerLevel(ULONG irq asm("d0"), struct GIC_Base *gicBase asm("a6"))
 {
+    GIC_MMIO_SCOPE(GIC400_STAT_SETINTTRIGGER);
     LONG ret = gic400_validate_irq(gicBase, irq);
     if (ret < 0)
         return ret;
@@ -331,7 +513,15 @@ LONG SetIntTriggerLevel(ULONG irq asm("d0"), struct GIC_Base *gicBase asm("a6"))
     return 0;
 }
 
-static s32 gic400_validate_cpu_target(const char *caller, u32 irq, u8 cpu)
+/* gic400_validate_cpu_target: Check that irq may be (re)routed to cpu.
+ * SGIs are never routable. PPIs are private to each CPU: their target byte
+ * is read-only and names the CPU reading it, so only routing a PPI to that
+ * CPU is accepted (as a no-op) and unrouting is refused.
+ * Args: caller - for logging; irq - interrupt number; cpu - CPU index;
+ *       route - TRUE when adding cpu as a target, FALSE when removing it.
+ * Returns: 0 when allowed, negative GIC400_ERR_* otherwise.
+ */
+static s32 gic400_validate_cpu_target(struct GIC_Base *gicBase, const char *caller, u32 irq, u8 cpu, BOOL route)
 {
 #ifndef DEBUG
     (void)caller; /* only referenced by debug logging */
@@ -342,9 +532,15 @@ static s32 gic400_validate_cpu_target(const char *caller, u32 irq, u8 cpu)
         return GIC400_ERR_INVALID_ARGUMENT;
     }
 
-    if (irq < 32)
+    if (irq < 16)
     {
-        Kprintf("[gic] %s: IRQ %lu targets SGI/PPI and cannot be rerouted\n", caller, irq);
+        Kprintf("[gic] %s: IRQ %lu is an SGI and cannot be rerouted\n", caller, irq);
+        return GIC400_ERR_NOT_ROUTABLE;
+    }
+
+    if (irq < 32 && (!route || (gicd_get_cpu_mask(gicBase, irq) & (1u << cpu)) == 0))
+    {
+        Kprintf("[gic] %s: PPI %lu is private to its CPU and cannot be rerouted\n", caller, irq);
         return GIC400_ERR_NOT_ROUTABLE;
     }
 
@@ -353,10 +549,11 @@ static s32 gic400_validate_cpu_target(const char *caller, u32 irq, u8 cpu)
 
 LONG RouteIntToCpu(ULONG irq asm("d0"), UBYTE cpu asm("d1"), struct GIC_Base *gicBase asm("a6"))
 {
+    GIC_MMIO_SCOPE(GIC400_STAT_ROUTEINT);
     LONG ret = gic400_validate_irq(gicBase, irq);
     if (ret < 0)
         return ret;
-    ret = gic400_validate_cpu_target(__func__, irq, cpu);
+    ret = gic400_validate_cpu_target(gicBase, __func__, irq, cpu, TRUE);
     if (ret < 0)
         return ret;
 
@@ -366,10 +563,11 @@ LONG RouteIntToCpu(ULONG irq asm("d0"), UBYTE cpu asm("d1"), struct GIC_Base *gi
 
 LONG UnrouteIntFromCpu(ULONG irq asm("d0"), UBYTE cpu asm("d1"), struct GIC_Base *gicBase asm("a6"))
 {
+    GIC_MMIO_SCOPE(GIC400_STAT_ROUTEINT);
     LONG ret = gic400_validate_irq(gicBase, irq);
     if (ret < 0)
         return ret;
-    ret = gic400_validate_cpu_target(__func__, irq, cpu);
+    ret = gic400_validate_cpu_target(gicBase, __func__, irq, cpu, FALSE);
     if (ret < 0)
         return ret;
 
@@ -377,33 +575,62 @@ LONG UnrouteIntFromCpu(ULONG irq asm("d0"), UBYTE cpu asm("d1"), struct GIC_Base
     return 0;
 }
 
-/* QueryIntRoute: Return CPU target mask for an SPI or a negative GIC400_ERR_*. */
-LONG QueryIntRoute(ULONG irq asm("d0"), struct GIC_Base *gicBase asm("a6"))
+/* SetIntTargets: Replace the CPU target mask of an SPI with one byte store.
+ * For a PPI only its fixed, read-only mask is accepted.
+ * Args: irq - interrupt number; cpuMask - bit n routes the SPI to CPU n.
+ * Returns: 0 on success, negative GIC400_ERR_* on failure.
+ */
+LONG SetIntTargets(ULONG irq asm("d0"), UBYTE cpuMask asm("d1"), struct GIC_Base *gicBase asm("a6"))
 {
+    GIC_MMIO_SCOPE(GIC400_STAT_SETINTTARGETS);
     LONG ret = gic400_validate_irq(gicBase, irq);
     if (ret < 0)
         return ret;
-    if (irq < 32)
+    if (irq < 16 || (irq < 32 && gicd_get_cpu_mask(gicBase, irq) != cpuMask))
     {
         Kprintf("[gic] %s: IRQ %lu targets SGI/PPI and cannot be rerouted\n", __func__, irq);
         return GIC400_ERR_NOT_ROUTABLE;
     }
 
+    gicd_set_targets(gicBase, irq, cpuMask);
+    return 0;
+}
+
+/* QueryIntRoute: Return CPU target mask for a PPI/SPI or a negative GIC400_ERR_*.
+ * A PPI reports the (read-only) mask of the CPU it is private to.
+ */
+LONG QueryIntRoute(ULONG irq asm("d0"), struct GIC_Base *gicBase asm("a6"))
+{
+    GIC_MMIO_SCOPE(GIC400_STAT_QUERYINTROUTE);
+    LONG ret = gic400_validate_irq(gicBase, irq);
+    if (ret < 0)
+        return ret;
+    if (irq < 16)
+    {
+        Kprintf("[gic] %s: IRQ %lu is an SGI and has no CPU route\n", __func__, irq);
+        return GIC400_ERR_NOT_ROUTABLE;
+    }
+
     return (LONG)gicd_get_cpu_mask(gicBase, irq);
 }
 
 LONG SetIntPending(ULONG irq asm("d0"), struct GIC_Base *gicBase asm("a6"))
 {
+    GIC_MMIO_SCOPE(GIC400_STAT_SETINTPENDING);
     LONG ret = gic400_validate_irq(gicBase, irq);
     if (ret < 0)
         return ret;
 
+    Disable();
+    gic400_install_dispatcher(gicBase); // a serverless line must still be acknowledged
     gicd_set_pending(gicBase, irq);
+    Enable();
     return 0;
 }
 
 LONG ClearIntPending(ULONG irq asm("d0"), struct GIC_Base *gicBase asm("a6"))
 {
+    GIC_MMIO_SCOPE(GIC400_STAT_CLEARINTPENDING);
     LONG ret = gic400_validate_irq(gicBase, irq);
     if (ret < 0)
         return ret;
@@ -414,6 +641,7 @@ LONG ClearIntPending(ULONG irq asm("d0"), struct GIC_Base *gicBase asm("a6"))
 
 LONG SetIntActive(ULONG irq asm("d0"), struct GIC_Base *gicBase asm("a6"))
 {
+    GIC_MMIO_SCOPE(GIC400_STAT_SETINTACTIVE);
     LONG ret = gic400_validate_irq(gicBase, irq);
     if (ret < 0)
         return ret;
@@ -424,6 +652,7 @@ LONG SetIntActive(ULONG irq asm("d0"), struct GIC_Base *gicBase asm("a6"))
 
 LONG ClearIntActive(ULONG irq asm("d0"), struct GIC_Base *gicBase asm("a6"))
 {
+    GIC_MMIO_SCOPE(GIC400_STAT_CLEARINTACTIVE);
     LONG ret = gic400_validate_irq(gicBase, irq);
     if (ret < 0)
         return ret;
@@ -432,14 +661,152 @@ LONG ClearIntActive(ULONG irq asm("d0"), struct GIC_Base *gicBase asm("a6"))
     return 0;
 }
 
+/* SetIntOverrunDetect: Enable or disable coalesced-edge detection for an IRQ.
+ * The dispatcher then samples the pending bit before and after the server
+ * runs, passes the "possibly coalesced" hint in D1 and counts services that
+ * end with the IRQ pending again. Only edge-triggered IRQs qualify; a level
+ * IRQ's pending bit just follows its line.
+ * Args: irq - interrupt number; enable - TRUE to sample, FALSE to stop.
+ * Returns: 0 on success, negative GIC400_ERR_* on failure.
+ */
+LONG SetIntOverrunDetect(ULONG irq asm("d0"), BOOL enable asm("d1"), struct GIC_Base *gicBase asm("a6"))
+{
+    GIC_MMIO_SCOPE(GIC400_STAT_OVERRUN);
+    LONG ret = gic400_validate_irq(gicBase, irq);
+    if (ret < 0)
+        return ret;
+
+    if (!enable)
+    {
+        Disable();
+        gicBase->irq_flags[irq] &= (u8)~(GIC_IRQF_OVERRUN | GIC_IRQF_REPENDED);
+        Enable();
+        return 0;
+    }
+
+    if (!gicd_is_edge(gicBase, irq))
+    {
+        Kprintf("[gic] %s: IRQ %lu is level-triggered\n", __func__, irq);
+        return GIC400_ERR_INVALID_ARGUMENT;
+    }
+
+    ObtainSemaphore(&gicBase->semaphore);
+    if (!gicBase->overruns)
+    {
+        u32 bytes = gicBase->max_irqs * sizeof(u32);
+        gicBase->overruns = AllocMem(bytes, MEMF_CLEAR);
+        if (!gicBase->overruns)
+        {
+            ReleaseSemaphore(&gicBase->semaphore);
+            Kprintf("[gic] %s: Failed to allocate overrun counters (%lu bytes)\n", __func__, bytes);
+            return GIC400_ERR_NO_MEMORY;
+        }
+    }
+    ReleaseSemaphore(&gicBase->semaphore);
+
+    Disable();
+    gicBase->overruns[irq] = 0;
+    gicBase->irq_flags[irq] |= GIC_IRQF_OVERRUN;
+    Enable();
+    return 0;
+}
+
+/* GetIntOverruns: Read the coalesced-edge count of an IRQ.
+ * Args: irq - interrupt number; reset - TRUE to clear the count.
+ * Returns: count (saturating), or negative GIC400_ERR_* on failure.
+ */
+LONG GetIntOverruns(ULONG irq asm("d0"), BOOL reset asm("d1"), struct GIC_Base *gicBase asm("a6"))
+{
+    GIC_MMIO_SCOPE(GIC400_STAT_OVERRUN);
+    LONG ret = gic400_validate_irq(gicBase, irq);
+    if (ret < 0)
+        return ret;
+    if (!gicBase->overruns)
+        return 0;
+
+    Disable();
+    u32 count = gicBase->overruns[irq];
+    if (reset)
+        gicBase->overruns[irq] = 0;
+    Enable();
+
+    return count > 0x7FFFFFFF ? 0x7FFFFFFF : (LONG)count;
+}
+
+/* SetIntTimestamp: Enable or disable acknowledge timestamps for an IRQ.
+ * The dispatcher then reads the 1 MHz system timer right after GICC_IAR,
+ * passes the low 32 bits to the server in D2 and keeps them as the IRQ's
+ * last-fired time. Cleared when the server is removed.
+ * Args: irq - interrupt number; enable - TRUE to stamp, FALSE to stop.
+ * Returns: 0 on success, negative GIC400_ERR_* on failure.
+ */
+LONG SetIntTimestamp(ULONG irq asm("d0"), BOOL enable asm("d1"), struct GIC_Base *gicBase asm("a6"))
+{
+    GIC_MMIO_SCOPE(GIC400_STAT_TIMESTAMP);
+    LONG ret = gic400_validate_irq(gicBase, irq);
+    if (ret < 0)
+        return ret;
+
+    if (!enable)
+    {
+        Disable();
+        gicBase->irq_flags[irq] &= (u8)~GIC_IRQF_STAMP;
+        Enable();
+        return 0;
+    }
+
+    if (!gicBase->systimer_base)
+        return GIC400_ERR_NOT_SUPPORTED;
+
+    ObtainSemaphore(&gicBase->semaphore);
+    if (!gicBase->stamps)
+    {
+        u32 bytes = gicBase->max_irqs * sizeof(u32);
+        gicBase->stamps = AllocMem(bytes, MEMF_CLEAR);
+        if (!gicBase->stamps)
+        {
+            ReleaseSemaphore(&gicBase->semaphore);
+            Kprintf("[gic] %s: Failed to allocate timestamps (%lu bytes)\n", __func__, bytes);
+            return GIC400_ERR_NO_MEMORY;
+        }
+    }
+    ReleaseSemaphore(&gicBase->semaphore);
+
+    Disable();
+    gicBase->stamps[irq] = 0;
+    gicBase->irq_flags[irq] |= GIC_IRQF_STAMP;
+    Enable();
+    return 0;
+}
+
+/* GetIntTimestamp: Read the last acknowledge time of an IRQ.
+ * Args: irq - interrupt number; stamp - filled with the system timer value,
+ *  0 when the IRQ has not fired since SetIntTimestamp().
+ * Returns: 0 on success, negative GIC400_ERR_* on failure.
+ */
+LONG GetIntTimestamp(ULONG irq asm("d0"), ULONG *stamp asm("a0"), struct GIC_Base *gicBase asm("a6"))
+{
+    GIC_MMIO_SCOPE(GIC400_STAT_TIMESTAMP);
+    LONG ret = gic400_validate_irq(gicBase, irq);
+    if (ret < 0)
+        return ret;
+    if (!stamp)
+        return GIC400_ERR_INVALID_ARGUMENT;
+
+    *stamp = gicBase->stamps ? gicBase->stamps[irq] : 0;
+    return 0;
+}
+
 LONG SetPriorityMask(UBYTE mask asm("d0"), struct GIC_Base *gicBase asm("a6"))
 {
+    GIC_MMIO_SCOPE(GIC400_STAT_PRIORITYMASK);
     if (!gicBase)
     {
         Kprintf("[gic] %s: NULL GIC base\n", __func__);
         return GIC400_ERR_NOT_READY;
     }
 
+    gicBase->pmr = mask;
     gicc_set_priority_mask(mask);
     return 0;
 }
@@ -447,6 +814,7 @@ LONG SetPriorityMask(UBYTE mask asm("d0"), struct GIC_Base *gicBase asm("a6"))
 /* GetPriorityMask: Return current CPU interface priority mask or a negative GIC400_ERR_*. */
 LONG GetPriorityMask(struct GIC_Base *gicBase asm("a6"))
 {
+    GIC_MMIO_SCOPE(GIC400_STAT_PRIORITYMASK);
     if (!gicBase)
     {
         Kprintf("[gic] %s: NULL GIC base\n", __func__);
@@ -458,9 +826,55 @@ LONG GetPriorityMask(struct GIC_Base *gicBase asm("a6"))
     return (LONG)mask;
 }
 
+/* RaiseIntPriority: Block GIC interrupts with priority value >= level.
+ * Nestable like splx(): GICC_PMR only ever moves towards higher priority,
+ * and the previous mask is returned for RestoreIntPriority(). Interrupts
+ * above the level, and everything outside the GIC, stay live. Safe from
+ * interrupt context as long as raise/restore pairs nest; the shadow is
+ * updated before the register so a preempting pair restores our level.
+ * Costs one PMR write, none when the mask is already tighter.
+ * Args: level - GIC priority byte; only values below it are delivered.
+ * Returns: token (previous mask), or negative GIC400_ERR_* on failure.
+ */
+LONG RaiseIntPriority(UBYTE level asm("d0"), struct GIC_Base *gicBase asm("a6"))
+{
+    GIC_MMIO_SCOPE(GIC400_STAT_PRIORITYMASK);
+    if (!gicBase)
+        return GIC400_ERR_NOT_READY;
+
+    u8 old = gicBase->pmr;
+    if (level < old)
+    {
+        gicBase->pmr = level;
+        gicc_set_priority_mask(level);
+    }
+    return (LONG)old;
+}
+
+/* RestoreIntPriority: Leave a RaiseIntPriority() section.
+ * Args: token - value returned by the matching RaiseIntPriority().
+ * Returns: 0 on success, negative GIC400_ERR_* on failure.
+ */
+LONG RestoreIntPriority(ULONG token asm("d0"), struct GIC_Base *gicBase asm("a6"))
+{
+    GIC_MMIO_SCOPE(GIC400_STAT_PRIORITYMASK);
+    if (!gicBase)
+        return GIC400_ERR_NOT_READY;
+    if (token > 0xFF)
+        return GIC400_ERR_INVALID_ARGUMENT;
+
+    if ((u8)token != gicBase->pmr)
+    {
+        gicBase->pmr = (u8)token;
+        gicc_set_priority_mask(token);
+    }
+    return 0;
+}
+
 /* GetRunningPriority: Return the currently running priority or a negative GIC400_ERR_*. */
 LONG GetRunningPriority(struct GIC_Base *gicBase asm("a6"))
 {
+    GIC_MMIO_SCOPE(GIC400_STAT_GETRUNNINGPRIORITY);
     if (!gicBase)
     {
         Kprintf("[gic] %s: NULL GIC base\n", __func__);
@@ -473,6 +887,7 @@ LONG GetRunningPriority(struct GIC_Base *gicBase asm("a6"))
 /* GetHighestPending: Return IRQID of highest priority pending interrupt or a negative GIC400_ERR_*. */
 LONG GetHighestPending(struct GIC_Base *gicBase asm("a6"))
 {
+    GIC_MMIO_SCOPE(GIC400_STAT_GETHIGHESTPENDING);
     if (!gicBase)
     {
         Kprintf("[gic] %s: NULL GIC base\n", __func__);
@@ -508,41 +923,95 @@ LONG GetControllerInfo(struct GICInfo *info asm("a1"), struct GIC_Base *gicBase
     return 0;
 }
 
-/* gic400_call_interrupt: Invoke interrupt server with Exec ABI.
- * Args: interrupt - Exec interrupt entry; irq - source IRQ number.
- * Returns: void.
+/* GetMmioStats: Copy the MMIO access counters charged to one entry point.
+ * Args: entry - GIC400_STAT_* index; stats - output counters.
+ * Returns: 0 on success, GIC400_ERR_NOT_SUPPORTED unless built with GIC400_MMIO_STATS.
  */
-static inline void gic400_call_interrupt(struct Interrupt *interrupt, u32 irq)
+LONG GetMmioStats(ULONG entry asm("d0"), struct GICMmioStats *stats asm("a1"), struct GIC_Base *gicBase asm("a6"))
 {
-    if (interrupt == NULL || interrupt->is_Code == NULL)
-        return;
+    if (!gicBase)
+    {
+        Kprintf("[gic] %s: NULL GIC base\n", __func__);
+        return GIC400_ERR_NOT_READY;
+    }
+    if (!stats || entry >= GIC400_STAT_COUNT)
+    {
+        Kprintf("[gic] %s: invalid entry %lu or NULL stats pointer\n", __func__, entry);
+        return GIC400_ERR_INVALID_ARGUMENT;
+    }
 
-    __asm__ __volatile__(
-        "move.l %[sysbase],%%a6\n\t"
-        "move.l %[irq],%%d0\n\t"
-        "move.l %[data],%%a1\n\t"
-        "jsr (%[code])\n\t"
-        :
-        : [code] "a"(interrupt->is_Code),
-          [data] "r"(interrupt->is_Data),
-          [irq] "r"(irq),
-          [sysbase] "r"((struct ExecBase *)EXEC_BASE_NAME)
-        : "d0", "d1", "a0", "a1", "a5", "a6");
+#ifdef GIC400_MMIO_STATS
+    Disable();
+    *stats = gicBase->mmio_stats[entry];
+    Enable();
+    return 0;
+#else
+    return GIC400_ERR_NOT_SUPPORTED;
+#endif
 }
 
-/* gic400_exec_dispatcher: Exec interrupt server for INTB_EXTER hook.
- * Args: none.
- * Returns: void.
+/* ResetMmioStats: Zero all MMIO access counters.
+ * Returns: 0 on success, GIC400_ERR_NOT_SUPPORTED unless built with GIC400_MMIO_STATS.
  */
-static ULONG gic400_exec_dispatcher(register struct GIC_Base *gicBase asm("a1"))
+LONG ResetMmioStats(struct GIC_Base *gicBase asm("a6"))
 {
     if (!gicBase)
     {
-        KprintfH("[gic] %s: NULL GIC base\n", __func__);
-        return 0;
+        Kprintf("[gic] %s: NULL GIC base\n", __func__);
+        return GIC400_ERR_NOT_READY;
     }
 
-    u32 iar = gicc_acknowledge_interrupt();
+#ifdef GIC400_MMIO_STATS
+    Disable();
+    for (u32 entry = 0; entry < GIC400_STAT_COUNT; entry++)
+    {
+        gicBase->mmio_stats[entry].calls = 0;
+        gicBase->mmio_stats[entry].reads = 0;
+        gicBase->mmio_stats[entry].writes = 0;
+    }
+    Enable();
+    return 0;
+#else
+    return GIC400_ERR_NOT_SUPPORTED;
+#endif
+}
+
+/* gic400_service_overrun: Call a server with coalesced-edge detection.
+ * An edge arriving while the IRQ is active only sets its pending bit again,
+ * and any further edges merge into that bit. The hint is set when such an
+ * edge is already pending on entry or ended the previous service.
+ * Args: irq - acknowledged interrupt; interrupt - its server; stamp -
+ *  acknowledge timestamp passed in D2.
+ * Returns: void.
+ */
+static void gic400_service_overrun(struct GIC_Base *gicBase, u32 irq, struct Interrupt *interrupt, u32 stamp)
+{
+    BOOL hint = (gicBase->irq_flags[irq] & GIC_IRQF_REPENDED) || gicd_is_pending(gicBase, irq);
+
+    gic400_call_interrupt_stamp(interrupt, irq, hint ? 1 : 0, stamp);
+
+    // the server may have turned detection off or been removed meanwhile
+    if (!(gicBase->irq_flags[irq] & GIC_IRQF_OVERRUN))
+        return;
+
+    if (gicd_is_pending(gicBase, irq))
+    {
+        gicBase->irq_flags[irq] |= GIC_IRQF_REPENDED;
+        if (gicBase->overruns[irq] != 0xFFFFFFFF)
+            gicBase->overruns[irq]++;
+    }
+    else
+        gicBase->irq_flags[irq] &= (u8)~GIC_IRQF_REPENDED;
+}
+
+/* gic400_dispatch: Service one acknowledged interrupt and signal its end.
+ * Also the slow path of the assembly dispatcher, which keeps the same
+ * semantics for IRQs it does not handle itself.
+ * Args: iar - value read from GICC_IAR.
+ * Returns: 1 when an interrupt was serviced, 0 for a spurious one.
+ */
+ULONG gic400_dispatch(struct GIC_Base *gicBase, u32 iar)
+{
     u32 irq = iar & 0x3FF;
 
     if (irq == 0x3FF || irq == 0x3FE)
@@ -557,18 +1026,115 @@ static ULONG gic400_exec_dispatcher(register struct GIC_Base *gicBase asm("a1"))
         return 1;
     }
 
+    u32 hooks = gicBase->dispatch.hooks;
+    u8 timed = gicBase->irq_flags[irq] & (GIC_IRQF_STAMP | GIC_IRQF_CLASS | GIC_IRQF_BUDGET);
+    u32 stamp = 0;
+    if (timed || (hooks & GIC_HOOK_TRACE))
+        stamp = gic400_timer_now();
+    if (timed & GIC_IRQF_STAMP)
+        gicBase->stamps[irq] = stamp;
+
+    if (hooks & GIC_HOOK_FAIR)
+        gic400_fair_account(gicBase, irq);
+
     struct Interrupt *interrupt = gicBase->handlers[irq];
     if (interrupt)
     {
         KprintfH("[gic] Invoking handler for IRQ %ld\n", irq);
-        gic400_call_interrupt(interrupt, irq);
+        u8 flags = gicBase->irq_flags[irq];
+        if (flags & GIC_IRQF_DEFERRED)
+            gic400_budget_defer(gicBase, irq);
+        else if (flags & GIC_IRQF_OVERRUN)
+            gic400_service_overrun(gicBase, irq, interrupt, stamp);
+        else if (flags & GIC_IRQF_STAMP)
+            gic400_call_interrupt_stamp(interrupt, irq, 0, stamp);
+        else
+            gic400_call_interrupt(interrupt, irq);
+
+        if ((timed & (GIC_IRQF_CLASS | GIC_IRQF_BUDGET)) && !(flags & GIC_IRQF_DEFERRED))
+        {
+            u32 elapsed = gic400_timer_now() - stamp;
+            if (timed & GIC_IRQF_CLASS)
+                gic400_class_account(gicBase, irq, elapsed);
+            if (timed & GIC_IRQF_BUDGET)
+                gic400_budget_account(gicBase, irq, elapsed);
+        }
     }
 
+    if (hooks & GIC_HOOK_TRACE)
+        gic400_trace_record(gicBase, irq, stamp, interrupt != NULL);
+
     gicc_end_interrupt(iar);
     return 1;
 }
 
-/* AddIntServerEx: Register interrupt server for given SPI.
+#ifndef GIC400_ASM_DISPATCHER
+/* gic400_exec_dispatcher: Exec interrupt server for INTB_EXTER hook.
+ * Args: none.
+ * Returns: void.
+ */
+static ULONG gic400_exec_dispatcher(register struct GIC_Base *gicBase asm("a1"))
+{
+    GIC_MMIO_SCOPE(GIC400_STAT_DISPATCHER);
+    if (!gicBase)
+    {
+        KprintfH("[gic] %s: NULL GIC base\n", __func__);
+        return 0;
+    }
+    return gic400_dispatch(gicBase, gicc_acknowledge_interrupt());
+}
+#endif
+
+/* gic400_lines_asserted: Check whether the GIC can still raise level 6.
+ * Args: none.
+ * Returns: TRUE when any PPI or SPI is enabled or any IRQ is pending.
+ */
+static BOOL gic400_lines_asserted(struct GIC_Base *gicBase)
+{
+    for (u32 reg_index = 0; reg_index < (gicBase->max_irqs >> 5); reg_index++)
+    {
+        u32 enabled = gic_read32(GICD_ISENABLER(reg_index));
+        if (reg_index == 0)
+            enabled &= 0xFFFF0000; // SGI enables read as one on GIC-400
+        if (enabled || gic_read32(GICD_ISPENDR(reg_index)))
+            return TRUE;
+    }
+    return FALSE;
+}
+
+/* gic400_install_dispatcher: Hook the dispatcher into INTB_EXTER.
+ * Called with interrupts disabled whenever a line may be asserted: a server
+ * is registered, or a line is enabled or made pending by EnableInt(),
+ * SetIntPending() or CommitIntConfig(). Until then level 6 interrupts pay
+ * nothing for the GIC.
+ */
+void gic400_install_dispatcher(struct GIC_Base *gicBase)
+{
+    if (gicBase->dispatcher_installed)
+        return;
+
+    AddIntServer(INTB_EXTER, &gicBase->dispatcher_interrupt);
+    gicBase->dispatcher_installed = TRUE;
+    KprintfH("[gic] dispatcher installed on INTB_EXTER\n");
+}
+
+/* gic400_release_dispatcher: Unhook the dispatcher once the GIC is quiet.
+ * Called with interrupts disabled when the last server goes away. The hook
+ * stays while any line is still enabled or pending, since nothing else
+ * would acknowledge it and level 6 would fire forever.
+ */
+static void gic400_release_dispatcher(struct GIC_Base *gicBase)
+{
+    if (!gicBase->dispatcher_installed || gicBase->handler_count > 0 || gic400_lines_asserted(gicBase))
+        return;
+
+    RemIntServer(INTB_EXTER, &gicBase->dispatcher_interrupt);
+    gicBase->dispatcher_installed = FALSE;
+    KprintfH("[gic] dispatcher removed from INTB_EXTER\n");
+}
+
+/* gic400_add_server: Register interrupt server for given IRQ and enable it.
+ * Shared by AddIntServerEx() and the library's own services.
  * Args:
  *  irq - interrupt number
  *  priority - priority byte to assign (0-0x7f)
@@ -576,7 +1142,7 @@ static ULONG gic400_exec_dispatcher(register struct GIC_Base *gicBase asm("a1"))
  *  interrupt - Exec interrupt descriptor
  * Returns: 0 on success, negative GIC400_ERR_* on failure.
  */
-LONG AddIntServerEx(ULONG irq asm("d0"), UBYTE priority asm("d1"), BOOL edge asm("d2"), struct Interrupt *interrupt asm("a1"), struct GIC_Base *gicBase asm("a6"))
+s32 gic400_add_server(struct GIC_Base *gicBase, u32 irq, u8 priority, BOOL edge, struct Interrupt *interrupt)
 {
     if (!gicBase)
         return GIC400_ERR_NOT_READY;
@@ -585,7 +1151,7 @@ LONG AddIntServerEx(ULONG irq asm("d0"), UBYTE priority asm("d1"), BOOL edge asm
         Kprintf("[gic] Invalid interrupt server for IRQ %ld\n", irq);
         return GIC400_ERR_INVALID_ARGUMENT;
     }
-    LONG ret = gic400_validate_irq(gicBase, irq);
+    s32 ret = gic400_validate_irq(gicBase, irq);
     if (ret < 0)
         return ret;
 
@@ -607,18 +1173,19 @@ LONG AddIntServerEx(ULONG irq asm("d0"), UBYTE priority asm("d1"), BOOL edge asm
     }
 
     gicBase->handlers[irq] = interrupt;
-    gicBase->handler_count++;
+    if (gicBase->handler_count++ == 0)
+        gic400_install_dispatcher(gicBase);
     gic400_enable_irq(gicBase, irq, priority, edge);
 
     Enable();
     return 0;
 }
 
-/* RemIntServerEx: Remove interrupt server for given SPI.
+/* gic400_rem_server: Remove interrupt server for given IRQ and disable it.
  * Args: irq - interrupt number; interrupt - handler to remove.
  * Returns: 0 on success, negative GIC400_ERR_* on failure.
  */
-LONG RemIntServerEx(ULONG irq asm("d0"), struct Interrupt *interrupt asm("a1"), struct GIC_Base *gicBase asm("a6"))
+s32 gic400_rem_server(struct GIC_Base *gicBase, u32 irq, struct Interrupt *interrupt)
 {
     if (!gicBase)
         return GIC400_ERR_NOT_READY;
@@ -627,7 +1194,7 @@ LONG RemIntServerEx(ULONG irq asm("d0"), struct Interrupt *interrupt asm("a1"),
         Kprintf("[gic] Invalid interrupt server for IRQ %ld\n", irq);
         return GIC400_ERR_INVALID_ARGUMENT;
     }
-    LONG ret = gic400_validate_irq(gicBase, irq);
+    s32 ret = gic400_validate_irq(gicBase, irq);
     if (ret < 0)
         return ret;
 
@@ -650,8 +1217,87 @@ LONG RemIntServerEx(ULONG irq asm("d0"), struct Interrupt *interrupt asm("a1"),
     gic400_disable_irq(gicBase, irq);
 
     gicBase->handlers[irq] = NULL;
+    gicBase->irq_flags[irq] &= GIC_IRQF_DT;
+    gic400_class_forget(gicBase, irq, interrupt);
     if (gicBase->handler_count > 0)
         gicBase->handler_count--;
+    gic400_release_dispatcher(gicBase);
+
+    Enable();
+    return 0;
+}
+
+/* AddIntServerEx: Register interrupt server for given SPI.
+ * Args:
+ *  irq - interrupt number
+ *  priority - priority byte to assign (0-0x7f)
+ *  edge - TRUE for edge-triggered, FALSE for level-triggered
+ *  interrupt - Exec interrupt descriptor
+ * Returns: 0 on success, negative GIC400_ERR_* on failure.
+ */
+LONG AddIntServerEx(ULONG irq asm("d0"), UBYTE priority asm("d1"), BOOL edge asm("d2"), struct Interrupt *interrupt asm("a1"), struct GIC_Base *gicBase asm("a6"))
+{
+    GIC_MMIO_SCOPE(GIC400_STAT_ADDINTSERVEREX);
+    return gic400_add_server(gicBase, irq, priority, edge, interrupt);
+}
+
+/* RemIntServerEx: Remove interrupt server for given SPI.
+ * Args: irq - interrupt number; interrupt - handler to remove.
+ * Returns: 0 on success, negative GIC400_ERR_* on failure.
+ */
+LONG RemIntServerEx(ULONG irq asm("d0"), struct Interrupt *interrupt asm("a1"), struct GIC_Base *gicBase asm("a6"))
+{
+    GIC_MMIO_SCOPE(GIC400_STAT_REMINTSERVEREX);
+    return gic400_rem_server(gicBase, irq, interrupt);
+}
+
+/* ReplaceIntServerEx: Swap the server of a registered IRQ in place.
+ * The handler table entry is replaced with a single pointer store under
+ * Disable(); priority, trigger, routing and enable state are left alone, so
+ * no interrupt is lost. Servers only run from the level 6 dispatcher, which
+ * cannot preempt itself, so once this returns the old server is not running.
+ * The one exception is a call from inside the old server: the IRQ is then
+ * still active and the swap is refused.
+ * Args: irq - interrupt number; oldInterrupt - current server;
+ *  newInterrupt - server to install.
+ * Returns: 0 on success, negative GIC400_ERR_* on failure.
+ */
+LONG ReplaceIntServerEx(ULONG irq asm("d0"), struct Interrupt *oldInterrupt asm("a0"), struct Interrupt *newInterrupt asm("a1"), struct GIC_Base *gicBase asm("a6"))
+{
+    GIC_MMIO_SCOPE(GIC400_STAT_REPLACEINTSERVER);
+    s32 ret = gic400_validate_irq(gicBase, irq);
+    if (ret < 0)
+        return ret;
+    if (!oldInterrupt || !newInterrupt || !newInterrupt->is_Code)
+    {
+        Kprintf("[gic] Invalid interrupt server for IRQ %ld\n", irq);
+        return GIC400_ERR_INVALID_ARGUMENT;
+    }
+
+    Disable();
+
+    struct Interrupt *current = gicBase->handlers[irq];
+    if (!current)
+    {
+        Enable();
+        Kprintf("[gic] No handler registered for IRQ %ld\n", irq);
+        return GIC400_ERR_NOT_FOUND;
+    }
+    if (current != oldInterrupt)
+    {
+        Enable();
+        Kprintf("[gic] IRQ %ld registered with a different server\n", irq);
+        return GIC400_ERR_INVALID_ARGUMENT;
+    }
+    if (gicd_is_active(gicBase, irq))
+    {
+        Enable();
+        Kprintf("[gic] IRQ %ld is being serviced, cannot replace its server\n", irq);
+        return GIC400_ERR_BUSY;
+    }
+
+    gicBase->handlers[irq] = newInterrupt;
+    gic400_class_replace(gicBase, irq, newInterrupt);
 
     Enable();
     return 0;
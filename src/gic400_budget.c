@@ -0,0 +1,207 @@
+// SPDX-License-Identifier: MPL-2.0 OR GPL-2.0+
+#include <exec/memory.h>
+#include <gic400_private.h>
+
+static const char gic_budget_name[] = "ARM GIC-400 deferred server";
+
+/* gic400_budget_charge: Record one timed server call.
+ * Args: elapsed - server time in us.
+ * Returns: TRUE when the call was over budget.
+ */
+static BOOL gic400_budget_charge(struct GIC_Budget *budget, u32 elapsed)
+{
+    budget->runs++;
+    if (elapsed > budget->worst)
+        budget->worst = elapsed;
+    if (elapsed <= budget->budget)
+        return FALSE;
+
+    budget->violations++;
+    return TRUE;
+}
+
+/* gic400_budget_account: Check one server call against the IRQ's budget.
+ * Called from the dispatcher after the server returned. Flags the IRQ at
+ * GIC400_BUDGET_STRIKES and, if the driver opted in, switches it to
+ * deferred mode from its next acknowledge on.
+ * Args: irq - serviced IRQ; elapsed - time since acknowledge, us.
+ * Returns: void.
+ */
+void gic400_budget_account(struct GIC_Base *gicBase, u32 irq, u32 elapsed)
+{
+    struct GIC_Budget *budget = &gicBase->budgets[irq];
+    if (!gic400_budget_charge(budget, elapsed))
+    {
+        if (budget->strikes > 0)
+            budget->strikes--;
+        return;
+    }
+
+    if (budget->strikes < GIC400_BUDGET_STRIKES)
+        budget->strikes++;
+    if (budget->strikes < GIC400_BUDGET_STRIKES || (budget->state & GIC400_BUDGET_FLAGGED))
+        return;
+
+    budget->state |= GIC400_BUDGET_FLAGGED;
+    if (budget->flags & GIC400_BUDGETF_DEFER)
+    {
+        budget->state |= GIC400_BUDGET_DEFERRED;
+        gicBase->irq_flags[irq] |= GIC_IRQF_DEFERRED;
+    }
+    KprintfH("[gic] IRQ %ld over its %lu us budget (%lu us)\n", irq, budget->budget, elapsed);
+}
+
+/* gic400_budget_defer: Hand an acknowledged deferred IRQ to the work queue.
+ * Called from the dispatcher in place of the server; the work runs at the
+ * IRQ's own priority. The IRQ stays masked until its server has run, so a
+ * level-triggered source is not taken again in the meantime and the work
+ * item cannot be queued twice; a new edge stays pending in the distributor.
+ * Returns: void.
+ */
+void gic400_budget_defer(struct GIC_Base *gicBase, u32 irq)
+{
+    gicd_disable_irq(gicBase, irq);
+    gic400_work_queue(gicBase, &gicBase->budgets[irq].work, irq, gicd_get_priority(gicBase, irq));
+}
+
+/* gic400_budget_server: Run the server of one deferred IRQ and unmask it.
+ * The IRQ is only unmasked while it is still deferred; a server removed or
+ * a budget reset in the meantime already left the line as it should be.
+ * Args: irq - deferred IRQ; gicBase - library base (is_Data).
+ */
+static ULONG gic400_budget_server(register u32 irq asm("d0"), register struct GIC_Base *gicBase asm("a1"))
+{
+    struct Interrupt *interrupt = gicBase->handlers[irq];
+    if (!interrupt || !(gicBase->irq_flags[irq] & GIC_IRQF_DEFERRED))
+        return 0;
+
+    u32 start = gic400_timer_now();
+    gic400_call_interrupt(interrupt, irq);
+    u32 elapsed = gic400_timer_now() - start;
+
+    Disable();
+    if (gicBase->irq_flags[irq] & GIC_IRQF_DEFERRED)
+    {
+        gic400_budget_charge(&gicBase->budgets[irq], elapsed);
+        gicd_enable_irq(gicBase, irq);
+    }
+    Enable();
+    return 0;
+}
+
+/* SetIntBudget: Set the execution budget of an IRQ's server.
+ * Any change resets the IRQ's counters and strikes and returns it from
+ * deferred mode to the dispatcher. Cleared when the server is removed.
+ * Args:
+ *  irq - interrupt number
+ *  budget - allowed server time in us, 0 to stop checking
+ *  flags - GIC400_BUDGETF_*
+ * Returns: 0 on success, negative GIC400_ERR_* on failure.
+ */
+LONG SetIntBudget(ULONG irq asm("d0"), ULONG budget asm("d1"), ULONG flags asm("d2"), struct GIC_Base *gicBase asm("a6"))
+{
+    GIC_MMIO_SCOPE(GIC400_STAT_BUDGET);
+    if (!gicBase)
+        return GIC400_ERR_NOT_READY;
+    if (irq >= gicBase->max_irqs)
+        return GIC400_ERR_INVALID_IRQ;
+    LONG ret = gic400_ensure_live(gicBase);
+    if (ret < 0)
+        return ret;
+    if (flags & ~GIC400_BUDGETF_DEFER)
+        return GIC400_ERR_INVALID_ARGUMENT;
+    if (budget != 0 && !gicBase->systimer_base)
+        return GIC400_ERR_NOT_SUPPORTED;
+
+    ObtainSemaphore(&gicBase->semaphore);
+    if (budget != 0 && !gicBase->budgets)
+    {
+        u32 bytes = gicBase->max_irqs * sizeof(struct GIC_Budget);
+        struct GIC_Budget *budgets = AllocMem(bytes, MEMF_CLEAR);
+        if (!budgets)
+        {
+            ReleaseSemaphore(&gicBase->semaphore);
+            Kprintf("[gic] %s: Failed to allocate budgets (%lu bytes)\n", __func__, bytes);
+            return GIC400_ERR_NO_MEMORY;
+        }
+
+        gicBase->budget_runner.is_Node.ln_Type = NT_INTERRUPT;
+        gicBase->budget_runner.is_Node.ln_Name = (char *)gic_budget_name;
+        gicBase->budget_runner.is_Data = gicBase;
+        gicBase->budget_runner.is_Code = (APTR)gic400_budget_server;
+        for (u32 i = 0; i < gicBase->max_irqs; i++)
+            budgets[i].work.interrupt = &gicBase->budget_runner;
+        gicBase->budgets = budgets;
+    }
+    ReleaseSemaphore(&gicBase->semaphore);
+
+    if (!gicBase->budgets)
+        return 0; // nothing was ever budgeted
+
+    Disable();
+    u8 old = gicBase->irq_flags[irq];
+    gicBase->irq_flags[irq] &= (u8)~(GIC_IRQF_BUDGET | GIC_IRQF_DEFERRED);
+    if ((old & GIC_IRQF_DEFERRED) && gicBase->handlers[irq])
+        gicd_enable_irq(gicBase, irq); // queued work no longer unmasks it
+
+    struct GIC_Budget *entry = &gicBase->budgets[irq];
+    entry->budget = budget;
+    entry->runs = 0;
+    entry->violations = 0;
+    entry->worst = 0;
+    entry->flags = (u8)flags;
+    entry->state = 0;
+    entry->strikes = 0;
+    if (budget != 0)
+        gicBase->irq_flags[irq] |= GIC_IRQF_BUDGET;
+    Enable();
+
+    KprintfH("[gic] %s: IRQ %lu, %lu us\n", __func__, irq, budget);
+    return 0;
+}
+
+/* GetIntBudgets: Report every budgeted IRQ, in IRQ order.
+ * Args: info - destination; max - its size in entries.
+ * Returns: number of entries copied, or negative GIC400_ERR_* on failure.
+ */
+LONG GetIntBudgets(struct GICBudgetInfo *info asm("a0"), ULONG max asm("d0"), struct GIC_Base *gicBase asm("a6"))
+{
+    GIC_MMIO_SCOPE(GIC400_STAT_BUDGET);
+    if (!gicBase)
+        return GIC400_ERR_NOT_READY;
+    if (!info)
+        return GIC400_ERR_INVALID_ARGUMENT;
+    if (!gicBase->budgets)
+        return 0;
+
+    u32 count = 0;
+    for (u32 irq = 0; irq < gicBase->max_irqs && count < max; irq++)
+    {
+        if (!(gicBase->irq_flags[irq] & GIC_IRQF_BUDGET))
+            continue;
+
+        Disable();
+        const struct GIC_Budget *entry = &gicBase->budgets[irq];
+        info[count].irq = irq;
+        info[count].budget = entry->budget;
+        info[count].runs = entry->runs;
+        info[count].violations = entry->violations;
+        info[count].worst = entry->worst;
+        info[count].flags = entry->flags;
+        info[count].state = entry->state;
+        Enable();
+        count++;
+    }
+
+    return (LONG)count;
+}
+
+/* gic400_budget_shutdown: Free the budget tables. */
+void gic400_budget_shutdown(struct GIC_Base *gicBase)
+{
+    if (gicBase->budgets)
+    {
+        FreeMem(gicBase->budgets, gicBase->max_irqs * sizeof(struct GIC_Budget));
+        gicBase->budgets = NULL;
+    }
+}
@@ -0,0 +1,315 @@
+// SPDX-License-Identifier: MPL-2.0 OR GPL-2.0+
+#include <gic400_private.h>
+
+static const char gic_class_name[] = "ARM GIC-400 latency classes";
+
+/* Re-assignment period in timer ticks (us). */
+#define GIC400_CLASS_PERIOD 100000
+#define GIC400_CLASS_PER_SECOND (1000000 / GIC400_CLASS_PERIOD)
+
+/* Priority bytes handed out. Steps of 0x10 keep the non-secure LSB clear
+ * (see gicd_set_priority()) and survive any implemented priority width;
+ * 0x7F and above would fall to the default PMR.
+ */
+#define GIC400_CLASS_FIRST 0x10
+#define GIC400_CLASS_LAST 0x60
+#define GIC400_CLASS_BULK 0x70
+#define GIC400_CLASS_STEP 0x10
+
+/* Rates above this are clipped so the bound arithmetic stays in 32 bits. */
+#define GIC400_CLASS_MAX_RATE 65535
+
+/* gic400_class_before: Order two entries for priority assignment.
+ * Tighter targets first, bulk last; equal targets by shorter service time.
+ * Returns: TRUE when a must be more urgent than b.
+ */
+static BOOL gic400_class_before(const struct GIC_ClassEntry *a, const struct GIC_ClassEntry *b)
+{
+    u32 ta = a->target == GIC400_LATENCY_BULK ? ~0u : a->target;
+    u32 tb = b->target == GIC400_LATENCY_BULK ? ~0u : b->target;
+    if (ta != tb)
+        return ta < tb;
+    return a->service < b->service;
+}
+
+/* gic400_class_assign: Assign priorities to every classed IRQ.
+ * Entries are ranked by gic400_class_before() and each change of rank key
+ * moves to the next priority step, so a shorter server among equal
+ * targets is not queued behind a longer one. The worst-case latency of
+ * each IRQ is then estimated as its own service time plus, for every IRQ
+ * at the same or a more urgent priority, the services it can issue within
+ * the target at its measured rate. Only changed priorities are written.
+ * Must be called with interrupts disabled or from the timer server.
+ * Returns: void.
+ */
+static void gic400_class_assign(struct GIC_Base *gicBase)
+{
+    u32 count = gicBase->class_count;
+    u8 order[GIC400_CLASS_MAX];
+
+    for (u32 i = 0; i < count; i++)
+    {
+        u32 j = i;
+        while (j > 0 && gic400_class_before(&gicBase->class_entries[i], &gicBase->class_entries[order[j - 1]]))
+        {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = (u8)i;
+    }
+
+    u8 level = GIC400_CLASS_FIRST;
+    for (u32 k = 0; k < count; k++)
+    {
+        struct GIC_ClassEntry *entry = &gicBase->class_entries[order[k]];
+        u8 priority;
+        if (entry->target == GIC400_LATENCY_BULK)
+            priority = GIC400_CLASS_BULK;
+        else
+        {
+            if (k > 0 && gic400_class_before(&gicBase->class_entries[order[k - 1]], entry) && level < GIC400_CLASS_LAST)
+                level += GIC400_CLASS_STEP;
+            priority = level;
+        }
+
+        if (priority != entry->priority)
+        {
+            gicd_set_priority(gicBase, entry->irq, priority);
+            entry->priority = priority;
+        }
+    }
+
+    for (u32 i = 0; i < count; i++)
+    {
+        struct GIC_ClassEntry *entry = &gicBase->class_entries[i];
+        if (entry->target == GIC400_LATENCY_BULK)
+        {
+            entry->bound = 0;
+            entry->met = TRUE;
+            continue;
+        }
+
+        u32 bound = entry->service;
+        for (u32 j = 0; j < count; j++)
+        {
+            const struct GIC_ClassEntry *other = &gicBase->class_entries[j];
+            if (j == i || other->priority > entry->priority)
+                continue;
+            u32 hits = 1 + ((entry->target >> 4) * other->rate) / (1000000 >> 4);
+            bound += hits * other->service;
+        }
+        entry->bound = bound;
+        entry->met = bound <= entry->target;
+    }
+}
+
+/* gic400_class_server: Fold the last period's measurements and re-assign.
+ * Stops its own timer once the last classed server has been removed.
+ * Args: gicBase - library base (is_Data).
+ */
+static ULONG gic400_class_server(register struct GIC_Base *gicBase asm("a1"))
+{
+    if (gicBase->class_count == 0)
+    {
+        StopTimer(&gicBase->class_timer, gicBase);
+        gicBase->class_running = FALSE;
+        return 0;
+    }
+
+    for (u32 i = 0; i < gicBase->class_count; i++)
+    {
+        struct GIC_ClassEntry *entry = &gicBase->class_entries[i];
+        u32 services = entry->count;
+        u32 busy = entry->busy;
+        entry->count = 0;
+        entry->busy = 0;
+
+        u32 rate = services * GIC400_CLASS_PER_SECOND;
+        entry->rate = rate > GIC400_CLASS_MAX_RATE ? GIC400_CLASS_MAX_RATE : rate;
+        if (services)
+            entry->service = busy / services;
+    }
+
+    gic400_class_assign(gicBase);
+    return 0;
+}
+
+/* gic400_class_account: Charge one service to a classed IRQ.
+ * Called from the dispatcher after the server returned.
+ * Args: irq - serviced IRQ; elapsed - time since acknowledge, us.
+ * Returns: void.
+ */
+void gic400_class_account(struct GIC_Base *gicBase, u32 irq, u32 elapsed)
+{
+    for (u32 i = 0; i < gicBase->class_count; i++)
+    {
+        struct GIC_ClassEntry *entry = &gicBase->class_entries[i];
+        if (entry->irq == irq)
+        {
+            entry->count++;
+            entry->busy += elapsed;
+            return;
+        }
+    }
+}
+
+/* gic400_class_forget: Drop the entry of a server being removed.
+ * Called from gic400_rem_server() with interrupts disabled; the remaining
+ * entries are re-ranked at once. The timer stops itself once no entry is
+ * left.
+ * Args: irq - interrupt number; interrupt - server going away.
+ * Returns: void.
+ */
+void gic400_class_forget(struct GIC_Base *gicBase, u32 irq, struct Interrupt *interrupt)
+{
+    for (u32 i = 0; i < gicBase->class_count; i++)
+    {
+        if (gicBase->class_entries[i].irq != irq || gicBase->class_entries[i].interrupt != interrupt)
+            continue;
+
+        gicBase->class_entries[i] = gicBase->class_entries[--gicBase->class_count];
+        gic400_class_assign(gicBase);
+        return;
+    }
+}
+
+/* gic400_class_replace: Follow a server swapped by ReplaceIntServerEx().
+ * The IRQ keeps its class, measurements and priority.
+ * Must be called with interrupts disabled.
+ * Args: irq - interrupt number; interrupt - newly installed server.
+ * Returns: void.
+ */
+void gic400_class_replace(struct GIC_Base *gicBase, u32 irq, struct Interrupt *interrupt)
+{
+    for (u32 i = 0; i < gicBase->class_count; i++)
+    {
+        if (gicBase->class_entries[i].irq == irq)
+        {
+            gicBase->class_entries[i].interrupt = interrupt;
+            return;
+        }
+    }
+}
+
+/* AddIntServerClass: Register an interrupt server by latency requirement.
+ * Like AddIntServerEx(), but the priority is chosen by the library from the
+ * targets of all classed IRQs and, when the system timer is available,
+ * revised every 100 ms from their measured rates and service times.
+ * Args:
+ *  irq - interrupt number
+ *  latency - required latency in us, or GIC400_LATENCY_BULK
+ *  edge - TRUE for edge-triggered, FALSE for level-triggered
+ *  interrupt - Exec interrupt descriptor
+ * Returns: 0 on success, negative GIC400_ERR_* on failure.
+ */
+LONG AddIntServerClass(ULONG irq asm("d0"), ULONG latency asm("d1"), BOOL edge asm("d2"), struct Interrupt *interrupt asm("a1"), struct GIC_Base *gicBase asm("a6"))
+{
+    GIC_MMIO_SCOPE(GIC400_STAT_CLASS);
+    if (!gicBase)
+        return GIC400_ERR_NOT_READY;
+    if (irq >= gicBase->max_irqs)
+        return GIC400_ERR_INVALID_IRQ;
+    s32 ret = gic400_ensure_live(gicBase);
+    if (ret < 0)
+        return ret;
+
+    ObtainSemaphore(&gicBase->semaphore);
+
+    for (u32 i = 0; i < gicBase->class_count; i++)
+    {
+        if (gicBase->class_entries[i].irq == irq)
+        {
+            ReleaseSemaphore(&gicBase->semaphore);
+            Kprintf("[gic] IRQ %ld is already registered\n", irq);
+            return GIC400_ERR_ALREADY_REGISTERED;
+        }
+    }
+    if (gicBase->class_count >= GIC400_CLASS_MAX)
+    {
+        ReleaseSemaphore(&gicBase->semaphore);
+        Kprintf("[gic] %s: No room for IRQ %lu\n", __func__, irq);
+        return GIC400_ERR_FULL;
+    }
+
+    ret = gic400_add_server(gicBase, irq, GIC400_CLASS_BULK, edge, interrupt);
+    if (ret < 0)
+    {
+        ReleaseSemaphore(&gicBase->semaphore);
+        return ret;
+    }
+
+    struct GIC_ClassEntry entry = {0};
+    entry.irq = (u16)irq;
+    entry.priority = gicd_get_priority(gicBase, irq); // the tuning profile may have won
+    entry.target = latency;
+    entry.interrupt = interrupt;
+
+    Disable();
+    gicBase->class_entries[gicBase->class_count++] = entry;
+    if (gicBase->systimer_base)
+        gicBase->irq_flags[irq] |= GIC_IRQF_CLASS;
+    gic400_class_assign(gicBase);
+    Enable();
+
+    if (gicBase->systimer_base && !gicBase->class_running)
+    {
+        gicBase->class_interrupt.is_Node.ln_Type = NT_INTERRUPT;
+        gicBase->class_interrupt.is_Node.ln_Name = (char *)gic_class_name;
+        gicBase->class_interrupt.is_Data = gicBase;
+        gicBase->class_interrupt.is_Code = (APTR)gic400_class_server;
+        gicBase->class_timer.interrupt = &gicBase->class_interrupt;
+        gicBase->class_timer.armed = FALSE;
+        if (StartTimer(&gicBase->class_timer, GIC400_CLASS_PERIOD, GIC400_CLASS_PERIOD, gicBase) == 0)
+            gicBase->class_running = TRUE;
+    }
+
+    ReleaseSemaphore(&gicBase->semaphore);
+
+    KprintfH("[gic] %s: IRQ %lu, target %lu us\n", __func__, irq, latency);
+    return 0;
+}
+
+/* GetIntClassMap: Report the classed IRQs and the priorities they got.
+ * Args: info - destination; max - its size in entries.
+ * Returns: number of entries copied, or negative GIC400_ERR_* on failure.
+ */
+LONG GetIntClassMap(struct GICClassInfo *info asm("a0"), ULONG max asm("d0"), struct GIC_Base *gicBase asm("a6"))
+{
+    GIC_MMIO_SCOPE(GIC400_STAT_CLASS);
+    if (!gicBase)
+        return GIC400_ERR_NOT_READY;
+    if (!info)
+        return GIC400_ERR_INVALID_ARGUMENT;
+
+    Disable();
+
+    u32 count = gicBase->class_count;
+    if (count > max)
+        count = max;
+    for (u32 i = 0; i < count; i++)
+    {
+        const struct GIC_ClassEntry *entry = &gicBase->class_entries[i];
+        info[i].irq = entry->irq;
+        info[i].target = entry->target;
+        info[i].rate = entry->rate;
+        info[i].service = entry->service;
+        info[i].bound = entry->bound;
+        info[i].priority = entry->priority;
+        info[i].met = entry->met;
+        info[i].pad = 0;
+    }
+    Enable();
+
+    return (LONG)count;
+}
+
+/* gic400_class_shutdown: Stop re-assigning and forget every class. */
+void gic400_class_shutdown(struct GIC_Base *gicBase)
+{
+    if (gicBase->class_running)
+    {
+        StopTimer(&gicBase->class_timer, gicBase);
+        gicBase->class_running = FALSE;
+    }
+    gicBase->class_count = 0;
+}
@@ -0,0 +1,317 @@
+// SPDX-License-Identifier: MPL-2.0 OR GPL-2.0+
+#include <exec/memory.h>
+#include <gic400_private.h>
+
+#define GIC400_CFGF_ALL (GIC400_CFGF_PRIORITY | GIC400_CFGF_TRIGGER | GIC400_CFGF_TARGETS | GIC400_CFGF_ENABLE)
+
+/* gic400_config_owned: Check that the calling task has a transaction open.
+ * Returns: 0 when it has, negative GIC400_ERR_* otherwise.
+ */
+static s32 gic400_config_owned(struct GIC_Base *gicBase, const char *caller)
+{
+    if (!gicBase)
+        return GIC400_ERR_NOT_READY;
+    if (gicBase->config_owner == NULL || gicBase->config_owner != FindTask(NULL))
+    {
+        Kprintf("[gic] %s: no configuration transaction open\n", caller);
+        return GIC400_ERR_INVALID_ARGUMENT;
+    }
+    return 0;
+}
+
+/* gic400_config_finish: Clear the staging table and end the transaction. */
+static void gic400_config_finish(struct GIC_Base *gicBase)
+{
+    for (u32 irq = 0; irq < gicBase->max_irqs && gicBase->staged_count > 0; irq++)
+    {
+        if (gicBase->staged[irq].flags)
+        {
+            gicBase->staged[irq].flags = 0;
+            gicBase->staged_count--;
+        }
+    }
+    gicBase->staged_count = 0;
+    gicBase->config_owner = NULL;
+    ReleaseSemaphore(&gicBase->semaphore);
+}
+
+/* gic400_commit_bytes: Write staged IPRIORITYR or ITARGETSR bytes of four IRQs.
+ * A fully staged register is written with one 32-bit store, otherwise each
+ * staged byte is stored on its own; neither needs a read.
+ * Args: irq - first IRQ of the register; flag - GIC400_CFGF_PRIORITY or
+ *  GIC400_CFGF_TARGETS.
+ * Returns: void.
+ */
+static void gic400_commit_bytes(struct GIC_Base *gicBase, u32 irq, u8 flag)
+{
+    struct GIC_StagedInt *staged = &gicBase->staged[irq];
+    u32 value = 0;
+    u32 count = 0;
+
+    for (u32 i = 0; i < 4; i++)
+    {
+        if (staged[i].flags & flag)
+        {
+            u8 byte = flag == GIC400_CFGF_TARGETS ? staged[i].targets : staged[i].priority;
+            value |= (u32)byte << (i * 8);
+            count++;
+        }
+    }
+
+    if (count == 0)
+        return;
+
+    if (count == 4)
+    {
+        if (flag == GIC400_CFGF_TARGETS)
+            gic_write32(value, GICD_ITARGETSR(irq >> 2));
+        else
+            gic_write32(value, GICD_IPRIORITYR(irq >> 2));
+        return;
+    }
+
+    for (u32 i = 0; i < 4; i++)
+    {
+        if (!(staged[i].flags & flag))
+            continue;
+        if (flag == GIC400_CFGF_TARGETS)
+            gic_write8(staged[i].targets, GICD_ITARGETSR_BYTE(irq + i));
+        else
+            gic_write8(staged[i].priority, GICD_IPRIORITYR_BYTE(irq + i));
+    }
+}
+
+/* gic400_commit_trigger: Apply staged trigger modes of 16 IRQs.
+ * One ICFGR read and write, skipped when none of them is staged.
+ * Args: irq - first IRQ of the ICFGR register.
+ * Returns: void.
+ */
+static void gic400_commit_trigger(struct GIC_Base *gicBase, u32 irq)
+{
+    u32 set = 0;
+    u32 clear = 0;
+
+    for (u32 i = 0; i < 16; i++)
+    {
+        struct GIC_StagedInt *staged = &gicBase->staged[irq + i];
+        if (!(staged->flags & GIC400_CFGF_TRIGGER))
+            continue;
+        if (staged->state & GIC_STAGED_EDGE)
+            set |= (u32)2 << (i * 2); // 10b for edge-triggered
+        else
+            clear |= (u32)2 << (i * 2); // 00b for level-triggered
+    }
+
+    if ((set | clear) == 0)
+        return;
+
+    u32 reg = gic_read32(GICD_ICFGR(irq >> 4));
+    gic_write32((reg & ~clear) | set, GICD_ICFGR(irq >> 4));
+}
+
+/* BeginIntConfig: Open a configuration transaction for the calling task.
+ * Holds the library semaphore until CommitIntConfig() or AbortIntConfig(),
+ * so other tasks starting a transaction wait for this one.
+ * Returns: 0 on success, negative GIC400_ERR_* on failure.
+ */
+LONG BeginIntConfig(struct GIC_Base *gicBase asm("a6"))
+{
+    GIC_MMIO_SCOPE(GIC400_STAT_CONFIG);
+    if (!gicBase)
+        return GIC400_ERR_NOT_READY;
+    LONG ret = gic400_ensure_live(gicBase);
+    if (ret < 0)
+        return ret;
+
+    ObtainSemaphore(&gicBase->semaphore);
+
+    if (gicBase->config_owner)
+    {
+        ReleaseSemaphore(&gicBase->semaphore);
+        Kprintf("[gic] %s: transaction already open\n", __func__);
+        return GIC400_ERR_BUSY;
+    }
+
+    if (!gicBase->staged)
+    {
+        u32 bytes = gicBase->max_irqs * sizeof(struct GIC_StagedInt);
+        gicBase->staged = AllocMem(bytes, MEMF_CLEAR);
+        if (!gicBase->staged)
+        {
+            ReleaseSemaphore(&gicBase->semaphore);
+            Kprintf("[gic] %s: Failed to allocate staging table (%lu bytes)\n", __func__, bytes);
+            return GIC400_ERR_NO_MEMORY;
+        }
+    }
+
+    gicBase->config_owner = FindTask(NULL);
+    gicBase->staged_count = 0;
+    return 0;
+}
+
+/* StageIntConfig: Record settings for one IRQ in the open transaction.
+ * Nothing is written to the GIC until CommitIntConfig().
+ * Args: setting - IRQ and the GIC400_CFGF_* fields to change.
+ * Returns: 0 on success, negative GIC400_ERR_* on failure.
+ */
+LONG StageIntConfig(const struct GICIntSetting *setting asm("a0"), struct GIC_Base *gicBase asm("a6"))
+{
+    GIC_MMIO_SCOPE(GIC400_STAT_CONFIG);
+    s32 ret = gic400_config_owned(gicBase, __func__);
+    if (ret < 0)
+        return ret;
+
+    if (!setting || setting->flags == 0 || (setting->flags & ~GIC400_CFGF_ALL))
+        return GIC400_ERR_INVALID_ARGUMENT;
+
+    u32 irq = setting->irq;
+    if (irq >= gicBase->max_irqs)
+    {
+        Kprintf("[gic] %s: IRQ %lu is out of range (max %lu)\n", __func__, irq, gicBase->max_irqs);
+        return GIC400_ERR_INVALID_IRQ;
+    }
+    if ((setting->flags & GIC400_CFGF_TARGETS) && irq < 32)
+    {
+        Kprintf("[gic] %s: IRQ %lu targets are read-only\n", __func__, irq);
+        return GIC400_ERR_NOT_ROUTABLE;
+    }
+    if ((setting->flags & GIC400_CFGF_TRIGGER) && irq < 16 && !setting->edge)
+    {
+        Kprintf("[gic] %s: SGI %lu is always edge-triggered\n", __func__, irq);
+        return GIC400_ERR_INVALID_ARGUMENT;
+    }
+
+    struct GIC_StagedInt *staged = &gicBase->staged[irq];
+    if (staged->flags == 0)
+        gicBase->staged_count++;
+    staged->flags |= setting->flags;
+
+    if (setting->flags & GIC400_CFGF_PRIORITY)
+        staged->priority = setting->priority;
+    if (setting->flags & GIC400_CFGF_TARGETS)
+        staged->targets = setting->cpuMask;
+    if (setting->flags & GIC400_CFGF_TRIGGER)
+    {
+        if (setting->edge)
+            staged->state |= GIC_STAGED_EDGE;
+        else
+            staged->state &= (u8)~GIC_STAGED_EDGE;
+    }
+    if (setting->flags & GIC400_CFGF_ENABLE)
+    {
+        if (setting->enable)
+            staged->state |= GIC_STAGED_ENABLE;
+        else
+            staged->state &= (u8)~GIC_STAGED_ENABLE;
+    }
+
+    return 0;
+}
+
+/* CommitIntConfig: Apply every staged setting and end the transaction.
+ * Works one ISENABLER word (32 IRQs) at a time: the staged lines that are
+ * enabled are masked with one ICENABLER write, the IPRIORITYR, ITARGETSR
+ * and ICFGR words are written once each, then one ISENABLER write turns on
+ * the lines that end up enabled. No staged IRQ is live in between.
+ * Returns: number of IRQs configured, or negative GIC400_ERR_* on failure.
+ */
+LONG CommitIntConfig(struct GIC_Base *gicBase asm("a6"))
+{
+    GIC_MMIO_SCOPE(GIC400_STAT_CONFIG);
+    s32 ret = gic400_config_owned(gicBase, __func__);
+    if (ret < 0)
+        return ret;
+
+    LONG committed = (LONG)gicBase->staged_count;
+
+    Disable();
+
+    for (u32 reg_index = 0; reg_index < (gicBase->max_irqs >> 5) && gicBase->staged_count > 0; reg_index++)
+    {
+        u32 base = reg_index << 5;
+        u32 touched = 0;
+        u32 on = 0;
+        u32 off = 0;
+
+        for (u32 bit = 0; bit < 32; bit++)
+        {
+            struct GIC_StagedInt *staged = &gicBase->staged[base + bit];
+            if (staged->flags == 0)
+                continue;
+            touched |= (u32)1 << bit;
+            if (staged->flags & GIC400_CFGF_ENABLE)
+            {
+                if (staged->state & GIC_STAGED_ENABLE)
+                    on |= (u32)1 << bit;
+                else
+                    off |= (u32)1 << bit;
+            }
+        }
+
+        if (touched == 0)
+            continue;
+
+        u32 enabled = gic_read32(GICD_ISENABLER(reg_index)) & touched;
+        if (enabled)
+            gic_write32(enabled, GICD_ICENABLER(reg_index));
+
+        for (u32 irq = base; irq < base + 32; irq += 4)
+        {
+            gic400_commit_bytes(gicBase, irq, GIC400_CFGF_PRIORITY);
+            if (irq >= 32)
+                gic400_commit_bytes(gicBase, irq, GIC400_CFGF_TARGETS);
+        }
+        gic400_commit_trigger(gicBase, base);
+        gic400_commit_trigger(gicBase, base + 16);
+
+        enabled = (enabled & ~off) | on;
+        if (on)
+            gic400_install_dispatcher(gicBase); // a serverless line must still be acknowledged
+        if (enabled)
+            gic_write32(enabled, GICD_ISENABLER(reg_index));
+
+        for (u32 bit = 0; bit < 32; bit++)
+        {
+            if (gicBase->staged[base + bit].flags)
+            {
+                gicBase->staged[base + bit].flags = 0;
+                gicBase->staged_count--;
+            }
+        }
+    }
+
+    Enable();
+
+    KprintfH("[gic] %s: %ld IRQs configured\n", __func__, committed);
+    gic400_config_finish(gicBase);
+    return committed;
+}
+
+/* AbortIntConfig: Drop every staged setting and end the transaction.
+ * Returns: 0 on success, negative GIC400_ERR_* on failure.
+ */
+LONG AbortIntConfig(struct GIC_Base *gicBase asm("a6"))
+{
+    GIC_MMIO_SCOPE(GIC400_STAT_CONFIG);
+    s32 ret = gic400_config_owned(gicBase, __func__);
+    if (ret < 0)
+        return ret;
+
+    gic400_config_finish(gicBase);
+    return 0;
+}
+
+/* gic400_config_shutdown: Free the staging table.
+ * Args: none.
+ * Returns: void.
+ */
+void gic400_config_shutdown(struct GIC_Base *gicBase)
+{
+    if (gicBase->staged)
+    {
+        FreeMem(gicBase->staged, gicBase->max_irqs * sizeof(struct GIC_StagedInt));
+        gicBase->staged = NULL;
+    }
+    gicBase->config_owner = NULL;
+    gicBase->staged_count = 0;
+}
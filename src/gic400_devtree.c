@@ -0,0 +1,265 @@
+// SPDX-License-Identifier: MPL-2.0 OR GPL-2.0+
+#include <exec/memory.h>
+#include <gic400_private.h>
+
+#define __NOLIBBASE__
+#include <devtree.h>
+
+/* gic400_dt_compatible: Check a node's compatible string list.
+ * Args: DeviceTreeBase - open resource; key - node; compatible - string to find.
+ * Returns: TRUE when any entry of the node's "compatible" matches.
+ */
+BOOL gic400_dt_compatible(APTR DeviceTreeBase, APTR key, const char *compatible)
+{
+    APTR prop = DT_FindProperty(key, (CONST_STRPTR) "compatible");
+    if (prop == NULL)
+        return FALSE;
+
+    const char *entry = DT_GetPropValue(prop);
+    const char *end = entry + DT_GetPropLen(prop);
+    while (entry < end)
+    {
+        const char *a = entry;
+        const char *b = compatible;
+        while (*a && *a == *b)
+        {
+            a++;
+            b++;
+        }
+        if (*a == *b)
+            return TRUE;
+
+        while (entry < end && *entry)
+            entry++;
+        entry++;
+    }
+    return FALSE;
+}
+
+/* gic400_dt_interrupt_parent: Find the interrupt-parent governing a node.
+ * The property is inherited, so walk up until a node carries one.
+ * Returns: phandle, or 0 when no node on the path has one.
+ */
+static u32 gic400_dt_interrupt_parent(APTR DeviceTreeBase, APTR key)
+{
+    for (; key != NULL; key = DT_GetParent(key))
+    {
+        APTR prop = DT_FindProperty(key, (CONST_STRPTR) "interrupt-parent");
+        if (prop != NULL)
+        {
+            const u32 *value = DT_GetPropValue(prop);
+            return value ? *value : 0;
+        }
+    }
+    return 0;
+}
+
+/* gic400_dt_scan: Decode the GIC interrupt specifiers of every node.
+ * Walks the tree depth-first from the root without recursion. Only nodes
+ * whose (inherited) interrupt-parent is the GIC are decoded; SPIs are
+ * offset by 32, PPIs by 16.
+ * Args: root - root key; out - entries to fill, or NULL to only count.
+ * Returns: number of entries.
+ */
+static u32 gic400_dt_scan(struct GIC_Base *gicBase, APTR DeviceTreeBase, APTR root, struct GIC_DTInt *out)
+{
+    u32 count = 0;
+    APTR key = DT_GetChild(root, NULL);
+
+    while (key != NULL)
+    {
+        APTR prop = DT_FindProperty(key, (CONST_STRPTR) "interrupts");
+        if (prop != NULL && gic400_dt_interrupt_parent(DeviceTreeBase, key) == gicBase->dt_gic_phandle)
+        {
+            const u32 *cells = DT_GetPropValue(prop);
+            u32 specifiers = DT_GetPropLen(prop) / (3 * sizeof(u32));
+            for (u32 index = 0; cells != NULL && index < specifiers && index <= 0xFF; index++, cells += 3)
+            {
+                u32 irq = cells[1] + (cells[0] == 0 ? 32 : 16);
+                if (cells[0] > 1 || irq >= gicBase->max_irqs)
+                    continue;
+
+                if (out)
+                {
+                    out[count].key = key;
+                    out[count].irq = (u16)irq;
+                    out[count].index = (u8)index;
+                    out[count].flags = (u8)(cells[2] & 0x0F);
+                }
+                count++;
+            }
+        }
+
+        /* children first, then siblings, then the parents' siblings */
+        APTR next = DT_GetChild(key, NULL);
+        while (next == NULL && key != root)
+        {
+            APTR parent = DT_GetParent(key);
+            next = DT_GetChild(parent, key);
+            key = parent;
+        }
+        key = next;
+    }
+
+    return count;
+}
+
+/* gic400_dt_init: Build the device-tree interrupt index.
+ * Every IRQ named in the index is marked GIC_IRQF_DT so the software
+ * interrupt pool leaves it alone. A missing index is not fatal.
+ * Returns: 0 on success, negative GIC400_ERR_* on failure.
+ */
+s32 gic400_dt_init(struct GIC_Base *gicBase)
+{
+    gicBase->dt_index = NULL;
+    gicBase->dt_count = 0;
+
+    APTR DeviceTreeBase = OpenResource((CONST_STRPTR) "devicetree.resource");
+    if (DeviceTreeBase == NULL)
+        return GIC400_ERR_DEVTREE;
+
+    APTR root_key = DT_OpenKey((CONST_STRPTR) "/");
+    if (root_key == NULL)
+        return GIC400_ERR_DEVTREE;
+
+    u32 count = gic400_dt_scan(gicBase, DeviceTreeBase, root_key, NULL);
+    if (count == 0)
+    {
+        DT_CloseKey(root_key);
+        return 0;
+    }
+
+    u32 bytes = count * sizeof(struct GIC_DTInt);
+    struct GIC_DTInt *index = AllocMem(bytes, MEMF_CLEAR);
+    if (index == NULL)
+    {
+        DT_CloseKey(root_key);
+        Kprintf("[gic] %s: Failed to allocate interrupt index (%lu bytes)\n", __func__, bytes);
+        return GIC400_ERR_NO_MEMORY;
+    }
+
+    gic400_dt_scan(gicBase, DeviceTreeBase, root_key, index);
+    DT_CloseKey(root_key);
+
+    for (u32 i = 0; i < count; i++)
+        gicBase->irq_flags[index[i].irq] |= GIC_IRQF_DT;
+
+    gicBase->dt_index = index;
+    gicBase->dt_count = count;
+    KprintfH("[gic] %s: %lu device-tree interrupts indexed\n", __func__, count);
+    return 0;
+}
+
+/* gic400_dt_shutdown: Free the device-tree interrupt index. */
+void gic400_dt_shutdown(struct GIC_Base *gicBase)
+{
+    if (gicBase->dt_index)
+    {
+        FreeMem(gicBase->dt_index, gicBase->dt_count * sizeof(struct GIC_DTInt));
+        gicBase->dt_index = NULL;
+        gicBase->dt_count = 0;
+    }
+}
+
+/* gic400_dt_find: Look up a node's interrupt in the index.
+ * Args: name - absolute node path ("/soc/...") or a compatible string, which
+ *  selects the first matching node; index - specifier within "interrupts".
+ * Returns: index entry, or NULL when there is none.
+ */
+const struct GIC_DTInt *gic400_dt_find(struct GIC_Base *gicBase, CONST_STRPTR name, u32 index)
+{
+    if (name == NULL || gicBase->dt_count == 0)
+        return NULL;
+
+    APTR DeviceTreeBase = OpenResource((CONST_STRPTR) "devicetree.resource");
+    if (DeviceTreeBase == NULL)
+        return NULL;
+
+    APTR key = NULL;
+    if (name[0] == '/')
+    {
+        key = DT_OpenKey(name);
+        if (key == NULL)
+            return NULL;
+    }
+
+    const struct GIC_DTInt *found = NULL;
+    APTR checked = NULL;
+    BOOL match = FALSE;
+    for (u32 i = 0; i < gicBase->dt_count && found == NULL; i++)
+    {
+        const struct GIC_DTInt *entry = &gicBase->dt_index[i];
+        if (entry->key != checked)
+        {
+            checked = entry->key;
+            match = key ? entry->key == key : gic400_dt_compatible(DeviceTreeBase, entry->key, (const char *)name);
+        }
+        if (match && entry->index == index)
+            found = entry;
+    }
+
+    if (key)
+        DT_CloseKey(key);
+    return found;
+}
+
+/* FindDTInterrupt: Resolve a device-tree interrupt specifier to an IRQ.
+ * Args:
+ *  name - absolute node path or compatible string
+ *  index - specifier within the node's "interrupts" property
+ *  flags - optional output for the GIC400_DT_TRIGGER_* bits
+ * Returns: IRQ number, or negative GIC400_ERR_* on failure.
+ */
+LONG FindDTInterrupt(CONST_STRPTR name asm("a0"), ULONG index asm("d0"), ULONG *flags asm("a1"), struct GIC_Base *gicBase asm("a6"))
+{
+    GIC_MMIO_SCOPE(GIC400_STAT_DEVTREE);
+    if (!gicBase)
+        return GIC400_ERR_NOT_READY;
+    if (!name)
+        return GIC400_ERR_INVALID_ARGUMENT;
+    LONG ret = gic400_ensure_live(gicBase);
+    if (ret < 0)
+        return ret;
+
+    const struct GIC_DTInt *entry = gic400_dt_find(gicBase, name, index);
+    if (entry == NULL)
+        return GIC400_ERR_NOT_FOUND;
+
+    if (flags)
+        *flags = entry->flags;
+    return (LONG)entry->irq;
+}
+
+/* AddIntServerDT: Register interrupt server for a device-tree interrupt.
+ * The trigger mode comes from the specifier's flags cell.
+ * Args:
+ *  name - absolute node path or compatible string
+ *  index - specifier within the node's "interrupts" property
+ *  priority - priority byte to assign (0-0x7f)
+ *  interrupt - Exec interrupt descriptor
+ * Returns: IRQ number on success, negative GIC400_ERR_* on failure.
+ */
+LONG AddIntServerDT(CONST_STRPTR name asm("a0"), ULONG index asm("d0"), UBYTE priority asm("d1"), struct Interrupt *interrupt asm("a1"), struct GIC_Base *gicBase asm("a6"))
+{
+    GIC_MMIO_SCOPE(GIC400_STAT_DEVTREE);
+    if (!gicBase)
+        return GIC400_ERR_NOT_READY;
+    if (!name)
+        return GIC400_ERR_INVALID_ARGUMENT;
+    LONG ret = gic400_ensure_live(gicBase);
+    if (ret < 0)
+        return ret;
+
+    const struct GIC_DTInt *entry = gic400_dt_find(gicBase, name, index);
+    if (entry == NULL)
+    {
+        Kprintf("[gic] %s: No interrupt %lu for %s\n", __func__, index, name);
+        return GIC400_ERR_NOT_FOUND;
+    }
+
+    BOOL edge = (entry->flags & GIC400_DT_TRIGGER_EDGE) != 0;
+    ret = gic400_add_server(gicBase, entry->irq, priority, edge, interrupt);
+    if (ret < 0)
+        return ret;
+    return (LONG)entry->irq;
+}
@@ -26,9 +26,9 @@ void gicd_print_info(struct GIC_Base *gicBase)
 void gicd_enable(struct GIC_Base *gicBase)
 {
     // set enable bit in GICD_CTLR
-    u32 reg = mmio_read32(GICD_CTLR);
+    u32 reg = gic_read32(GICD_CTLR);
     reg |= 1;
-    mmio_write32(reg, GICD_CTLR);
+    gic_write32(reg, GICD_CTLR);
 }
 
 /* gicd_disable_group: Disable forwarding of pending interrupts from the Distributor to the CPU interface
@@ -36,9 +36,9 @@ void gicd_enable(struct GIC_Base *gicBase)
 void gicd_disable(struct GIC_Base *gicBase)
 {
     // clear enable bit in GICD_CTLR
-    u32 reg = mmio_read32(GICD_CTLR);
+    u32 reg = gic_read32(GICD_CTLR);
     reg &= ~1u;
-    mmio_write32(reg, GICD_CTLR);
+    gic_write32(reg, GICD_CTLR);
 }
 
 /* gicd_is_enabled: Check enable bit for an IRQ in ISENABLER.
@@ -50,7 +50,7 @@ BOOL gicd_is_enabled(struct GIC_Base *gicBase, u32 irq)
     // read enabled status from GICD_ISENABLER
     u32 reg_index = irq >> 5;
     u32 bit_offset = irq & 0x1F;
-    u32 reg = mmio_read32(GICD_ISENABLER(reg_index));
+    u32 reg = gic_read32(GICD_ISENABLER(reg_index));
     return (reg & ((u32)1 << bit_offset)) != 0;
 }
 
@@ -63,7 +63,7 @@ void gicd_enable_irq(struct GIC_Base *gicBase, u32 irq)
     // set enable bit in GICD_ISENABLER
     u32 reg_index = irq >> 5;
     u32 bit_offset = irq & 0x1F;
-    mmio_write32((u32)1 << bit_offset, GICD_ISENABLER(reg_index));
+    gic_write32((u32)1 << bit_offset, GICD_ISENABLER(reg_index));
 }
 
 /* gicd_disable_irq: Clear enable bit for an IRQ via ICENABLER.
@@ -75,7 +75,7 @@ void gicd_disable_irq(struct GIC_Base *gicBase, u32 irq)
     // set disable bit in GICD_ICENABLER
     u32 reg_index = irq >> 5;
     u32 bit_offset = irq & 0x1F;
-    mmio_write32((u32)1 << bit_offset, GICD_ICENABLER(reg_index));
+    gic_write32((u32)1 << bit_offset, GICD_ICENABLER(reg_index));
 }
 
 /* gicd_is_pending: Check pending bit for an IRQ in ISPENDR.
@@ -87,7 +87,7 @@ BOOL gicd_is_pending(struct GIC_Base *gicBase, u32 irq)
     // read pending status from GICD_ISPENDR
     u32 reg_index = irq >> 5;
     u32 bit_offset = irq & 0x1F;
-    u32 reg = mmio_read32(GICD_ISPENDR(reg_index));
+    u32 reg = gic_read32(GICD_ISPENDR(reg_index));
     return (reg & ((u32)1 << bit_offset)) != 0;
 }
 
@@ -100,7 +100,7 @@ void gicd_set_pending(struct GIC_Base *gicBase, u32 irq)
     // set pending bit in GICD_ISPENDR
     u32 reg_index = irq >> 5;
     u32 bit_offset = irq & 0x1F;
-    mmio_write32((u32)1 << bit_offset, GICD_ISPENDR(reg_index));
+    gic_write32((u32)1 << bit_offset, GICD_ISPENDR(reg_index));
 }
 
 /* gicd_clear_pending: Clear pending bit for an IRQ in ISPENDR.
@@ -112,7 +112,7 @@ void gicd_clear_pending(struct GIC_Base *gicBase, u32 irq)
     // clear pending bit in GICD_ICPENDR
     u32 reg_index = irq >> 5;
     u32 bit_offset = irq & 0x1F;
-    mmio_write32((u32)1 << bit_offset, GICD_ICPENDR(reg_index));
+    gic_write32((u32)1 << bit_offset, GICD_ICPENDR(reg_index));
 }
 
 /* gicd_get_irq_status: Report SPI active status from SPISR.
@@ -128,7 +128,7 @@ BOOL gicd_get_irq_status(struct GIC_Base *gicBase, u32 irq)
     u32 spi_irq = irq - 32;
     u32 reg_index = spi_irq >> 5;
     u32 bit_offset = spi_irq & 0x1F;
-    u32 reg = mmio_read32(GICD_SPISR(reg_index));
+    u32 reg = gic_read32(GICD_SPISR(reg_index));
     return (reg & ((u32)1 << bit_offset)) != 0;
 }
 
@@ -141,7 +141,7 @@ BOOL gicd_is_active(struct GIC_Base *gicBase, u32 irq)
     // read active status from GICD_ISACTIVER
     u32 reg_index = irq >> 5;
     u32 bit_offset = irq & 0x1F;
-    u32 reg = mmio_read32(GICD_ISACTIVER(reg_index));
+    u32 reg = gic_read32(GICD_ISACTIVER(reg_index));
     return (reg & ((u32)1 << bit_offset)) != 0;
 }
 
@@ -149,14 +149,14 @@ void gicd_set_active(struct GIC_Base *gicBase, u32 irq)
 {
     u32 reg_index = irq >> 5;
     u32 bit_offset = irq & 0x1F;
-    mmio_write32((u32)1 << bit_offset, GICD_ISACTIVER(reg_index));
+    gic_write32((u32)1 << bit_offset, GICD_ISACTIVER(reg_index));
 }
 
 void gicd_clear_active(struct GIC_Base *gicBase, u32 irq)
 {
     u32 reg_index = irq >> 5;
     u32 bit_offset = irq & 0x1F;
-    mmio_write32((u32)1 << bit_offset, GICD_ICACTIVER(reg_index));
+    gic_write32((u32)1 << bit_offset, GICD_ICACTIVER(reg_index));
 }
 
 /* gicd_get_priority: Fetch per-IRQ priority value.
@@ -165,27 +165,21 @@ void gicd_clear_active(struct GIC_Base *gicBase, u32 irq)
  */
 u8 gicd_get_priority(struct GIC_Base *gicBase, u32 irq)
 {
-    // read priority from GICD_IPRIORITYR
-    u32 reg_index = irq >> 2;
-    u32 byte_offset = irq & 0x03;
-    u32 reg = mmio_read32(GICD_IPRIORITYR(reg_index));
-    return (reg >> (byte_offset * 8)) & 0xFF;
+    // read priority byte from GICD_IPRIORITYR
+    return gic_read8(GICD_IPRIORITYR_BYTE(irq));
 }
 
 /* gicd_set_priority: Program per-IRQ priority value.
  * Note that in non-secure mode the LSB is always 0.
+ * IPRIORITYR is byte-accessible, so this is a single store that cannot
+ * clobber a neighbouring IRQ configured concurrently.
  * Args: irq - interrupt number; priority - byte to store.
  * Returns: void.
  */
 void gicd_set_priority(struct GIC_Base *gicBase, u32 irq, u8 priority)
 {
-    // write priority to GICD_IPRIORITYR
-    u32 reg_index = irq >> 2;
-    u32 byte_offset = irq & 0x03;
-    u32 reg = mmio_read32(GICD_IPRIORITYR(reg_index));
-    reg &= ~((u32)0xFF << (byte_offset * 8));
-    reg |= ((u32)priority & 0xFF) << (byte_offset * 8);
-    mmio_write32(reg, GICD_IPRIORITYR(reg_index));
+    // write priority byte to GICD_IPRIORITYR
+    gic_write8(priority, GICD_IPRIORITYR_BYTE(irq));
 }
 
 /* gicd_is_cpu_enabled: Check CPU target bit for an IRQ.
@@ -195,45 +189,64 @@ void gicd_set_priority(struct GIC_Base *gicBase, u32 irq, u8 priority)
 BOOL gicd_is_cpu_enabled(struct GIC_Base *gicBase, u32 irq, u8 cpu)
 {
     // read target from GICD_ITARGETSR and check if cpu bit is set
-    if (irq < 32)
-        return FALSE; // SGI and PPI are not handled here
+    if (irq < 16)
+        return FALSE; // SGIs are not handled here, PPIs report their own CPU
 
-    u32 reg_index = irq >> 2;
-    u32 byte_offset = irq & 0x03;
-    u32 reg = mmio_read32(GICD_ITARGETSR(reg_index));
-    u8 target = (reg >> (byte_offset * 8)) & 0xFF;
+    u8 target = gic_read8(GICD_ITARGETSR_BYTE(irq));
     return (target & ((u8)1 << cpu)) != 0;
 }
 
 u8 gicd_get_cpu_mask(struct GIC_Base *gicBase, u32 irq)
 {
-    u32 reg_index = irq >> 2;
-    u32 byte_offset = irq & 0x03;
-    u32 reg = mmio_read32(GICD_ITARGETSR(reg_index));
-    return (u8)((reg >> (byte_offset * 8)) & 0xFF);
+    return gic_read8(GICD_ITARGETSR_BYTE(irq));
 }
 
 /* gicd_set_cpu: Set or clear CPU target bit for an IRQ.
+ * Only the IRQ's own ITARGETSR byte is read and rewritten.
  * Args: irq - interrupt number; cpu - CPU index; enable - TRUE to set.
  * Returns: void.
  */
 void gicd_set_cpu(struct GIC_Base *gicBase, u32 irq, u8 cpu, BOOL enable)
 {
-    // write target to GICD_ITARGETSR
+    // write target byte to GICD_ITARGETSR
     if (irq < 32)
-        return; // SGI and PPI are not handled here
+        return; // SGI and PPI targets are read-only
 
-    u32 reg_index = irq >> 2;
-    u32 byte_offset = irq & 0x03;
-    u32 reg = mmio_read32(GICD_ITARGETSR(reg_index));
-    u8 target = (reg >> (byte_offset * 8)) & 0xFFu;
+    u8 target = gic_read8(GICD_ITARGETSR_BYTE(irq));
     if (enable)
         target |= (u8)(1u << cpu);
     else
         target &= (u8)~(1u << cpu);
-    reg &= ~(0xFFu << (byte_offset * 8));
-    reg |= (u32)target << (byte_offset * 8);
-    mmio_write32(reg, GICD_ITARGETSR(reg_index));
+    gic_write8(target, GICD_ITARGETSR_BYTE(irq));
+}
+
+/* gicd_set_targets: Replace the whole CPU target mask of an IRQ.
+ * Args: irq - interrupt number; mask - bit n routes to CPU n.
+ * Returns: void.
+ */
+void gicd_set_targets(struct GIC_Base *gicBase, u32 irq, u8 mask)
+{
+    // write target byte to GICD_ITARGETSR
+    if (irq < 32)
+        return; // SGI and PPI targets are read-only
+
+    gic_write8(mask, GICD_ITARGETSR_BYTE(irq));
+}
+
+/* gicd_unroute_all: Clear one CPU's target bit for every SPI.
+ * Works a full ITARGETSR word (four SPIs) per read/write pair.
+ * Args: cpu - CPU index.
+ * Returns: void.
+ */
+void gicd_unroute_all(struct GIC_Base *gicBase, u8 cpu)
+{
+    u32 clear = 0x01010101u << cpu;
+    for (u32 reg_index = 32 / 4; reg_index < gicBase->max_irqs / 4; reg_index++)
+    {
+        u32 reg = gic_read32(GICD_ITARGETSR(reg_index));
+        if (reg & clear)
+            gic_write32(reg & ~clear, GICD_ITARGETSR(reg_index));
+    }
 }
 
 /* gicd_set_trigger: Configure trigger mode for an IRQ.
@@ -248,17 +261,32 @@ void gicd_set_trigger(struct GIC_Base *gicBase, u32 irq, BOOL edge)
 
     u32 reg_index = irq >> 4;
     u32 bit_offset = (irq & 0x0F) * 2;
-    u32 reg = mmio_read32(GICD_ICFGR(reg_index));
+    u32 reg = gic_read32(GICD_ICFGR(reg_index));
     if (edge)
         reg |= (u32)2 << bit_offset; // 10b for edge-triggered
     else
         reg &= ~((u32)2 << bit_offset); // 00b for level-triggered
-    mmio_write32(reg, GICD_ICFGR(reg_index));
+    gic_write32(reg, GICD_ICFGR(reg_index));
 
-    reg = mmio_read32(GICD_ICFGR(reg_index));
+    reg = gic_read32(GICD_ICFGR(reg_index));
     BOOL is_edge = ((reg >> bit_offset) & 0x02) != 0;
     if (is_edge != edge)
     {
         Kprintf("[gic] Failed to set GICD IRQ %lu trigger to %s\n", irq, edge ? "edge" : "level");
     }
 }
+
+/* gicd_is_edge: Read back the trigger mode of an IRQ.
+ * Args: irq - interrupt number.
+ * Returns: TRUE when edge-triggered (always for SGIs), otherwise FALSE.
+ */
+BOOL gicd_is_edge(struct GIC_Base *gicBase, u32 irq)
+{
+    // read trigger mode from GICD_ICFGR
+    if (irq < 16)
+        return TRUE; // SGIs are always edge-triggered
+
+    u32 reg_index = irq >> 4;
+    u32 bit_offset = (irq & 0x0F) * 2;
+    return ((gic_read32(GICD_ICFGR(reg_index)) >> bit_offset) & 0x02) != 0;
+}
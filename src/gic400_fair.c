@@ -0,0 +1,218 @@
+// SPDX-License-Identifier: MPL-2.0 OR GPL-2.0+
+#include <exec/memory.h>
+#include <gic400_private.h>
+
+/* How far one demotion moves an IRQ, and the lowest priority it moves it to
+ * (0x7F would fall to the default PMR and mask the line).
+ */
+#define GIC400_FAIR_STEP 0x10
+#define GIC400_FAIR_FLOOR 0x70
+
+/* gic400_fair_demote: Drop an IRQ that exceeded its share by one step.
+ * Called from the dispatcher; nothing happens when the IRQ is demoted
+ * already, is at the floor, or the demotion table is full.
+ * Args: irq - IRQ that exceeded its share.
+ * Returns: void.
+ */
+static void gic400_fair_demote(struct GIC_Base *gicBase, u32 irq)
+{
+    u32 count = gicBase->fair_demoted_count;
+    for (u32 i = 0; i < count; i++)
+    {
+        if (gicBase->fair_demoted[i].irq == irq)
+            return;
+    }
+    if (count >= GIC400_FAIR_MAX_DEMOTED)
+        return;
+
+    u8 saved = gicd_get_priority(gicBase, irq);
+    if (saved >= GIC400_FAIR_FLOOR)
+        return;
+    u8 demoted = saved + GIC400_FAIR_STEP;
+    if (demoted > GIC400_FAIR_FLOOR)
+        demoted = GIC400_FAIR_FLOOR;
+
+    gicd_set_priority(gicBase, irq, demoted);
+    gicBase->fair_demoted[count].irq = (u16)irq;
+    gicBase->fair_demoted[count].saved = saved;
+    gicBase->fair_demoted[count].demoted = demoted;
+    gicBase->fair_demoted_count = count + 1;
+    gicBase->fair_demotions++;
+}
+
+/* gic400_fair_restore: Put a demoted IRQ back to its saved priority.
+ * A priority changed by someone else since the demotion is left alone.
+ * Args: entry - demotion table entry.
+ * Returns: void.
+ */
+static void gic400_fair_restore(struct GIC_Base *gicBase, const struct GIC_FairDemotion *entry)
+{
+    if (gicd_get_priority(gicBase, entry->irq) == entry->demoted)
+    {
+        gicd_set_priority(gicBase, entry->irq, entry->saved);
+        gicBase->fair_restores++;
+    }
+}
+
+/* gic400_fair_rotate: Close the current window.
+ * Every demoted IRQ that stayed within its share is restored, then a new
+ * window starts; bumping the epoch resets all counts at once.
+ * Returns: void.
+ */
+static void gic400_fair_rotate(struct GIC_Base *gicBase)
+{
+    u32 epoch = gicBase->fair_epoch;
+    u32 i = 0;
+
+    while (i < gicBase->fair_demoted_count)
+    {
+        struct GIC_FairDemotion *entry = &gicBase->fair_demoted[i];
+        u32 counted = gicBase->fair_counts[entry->irq];
+        u32 count = (counted >> 16) == epoch ? counted & 0xFFFF : 0;
+
+        if (count > gicBase->fair_share)
+        {
+            i++;
+            continue;
+        }
+
+        gic400_fair_restore(gicBase, entry);
+        *entry = gicBase->fair_demoted[--gicBase->fair_demoted_count];
+    }
+
+    gicBase->fair_epoch = (epoch + 1) & 0xFFFF;
+    gicBase->fair_dispatches = 0;
+}
+
+/* gic400_fair_account: Count one dispatch of an IRQ (GIC_HOOK_FAIR).
+ * Called from the dispatcher before the handler runs. The IRQ is demoted on
+ * the first service beyond its share, and every window dispatches the
+ * window is closed.
+ * Args: irq - acknowledged IRQ.
+ * Returns: void.
+ */
+void gic400_fair_account(struct GIC_Base *gicBase, u32 irq)
+{
+    u32 epoch = gicBase->fair_epoch;
+    u32 counted = gicBase->fair_counts[irq];
+    u32 count = (counted >> 16) == epoch ? (counted & 0xFFFF) + 1 : 1;
+    if (count > 0xFFFF)
+        count = 0xFFFF;
+    gicBase->fair_counts[irq] = (epoch << 16) | count;
+
+    if (count == gicBase->fair_share + 1)
+        gic400_fair_demote(gicBase, irq);
+
+    if (++gicBase->fair_dispatches >= gicBase->fair_window)
+        gic400_fair_rotate(gicBase);
+}
+
+/* gic400_fair_stop: Turn the policy off and restore every demoted IRQ.
+ * Must be called with interrupts disabled.
+ */
+static void gic400_fair_stop(struct GIC_Base *gicBase)
+{
+    gicBase->dispatch.hooks &= ~GIC_HOOK_FAIR;
+    for (u32 i = 0; i < gicBase->fair_demoted_count; i++)
+        gic400_fair_restore(gicBase, &gicBase->fair_demoted[i]);
+    gicBase->fair_demoted_count = 0;
+    gicBase->fair_window = 0;
+    gicBase->fair_share = 0;
+}
+
+/* SetIntFairness: Configure fair-share demotion of IRQs flooding the GIC.
+ * Among equal-priority pending IRQs the GIC always picks the lowest ID, so
+ * a busy low-numbered device can starve its neighbours. With the policy on,
+ * an IRQ serviced more than share times within window dispatches is
+ * demoted one priority step until a window in which it stays within its
+ * share. Windows are counted in dispatches, so demotions made before the
+ * system went quiet are undone in the first window after it gets busy.
+ * Any change restores all current demotions and resets the counters.
+ * Args:
+ *  window - dispatches per window, 0 to turn the policy off
+ *  share - services per IRQ and window (1 to window-1)
+ * Returns: 0 on success, negative GIC400_ERR_* on failure.
+ */
+LONG SetIntFairness(ULONG window asm("d0"), ULONG share asm("d1"), struct GIC_Base *gicBase asm("a6"))
+{
+    GIC_MMIO_SCOPE(GIC400_STAT_FAIRNESS);
+    if (!gicBase)
+        return GIC400_ERR_NOT_READY;
+    if (window != 0 && (share == 0 || share >= window || share >= 0xFFFF))
+        return GIC400_ERR_INVALID_ARGUMENT;
+    LONG ret = gic400_ensure_live(gicBase);
+    if (ret < 0)
+        return ret;
+
+    ObtainSemaphore(&gicBase->semaphore);
+
+    if (window != 0 && !gicBase->fair_counts)
+    {
+        u32 bytes = gicBase->max_irqs * sizeof(u32);
+        gicBase->fair_counts = AllocMem(bytes, MEMF_CLEAR);
+        if (!gicBase->fair_counts)
+        {
+            ReleaseSemaphore(&gicBase->semaphore);
+            Kprintf("[gic] %s: Failed to allocate service counts (%lu bytes)\n", __func__, bytes);
+            return GIC400_ERR_NO_MEMORY;
+        }
+    }
+
+    Disable();
+    gic400_fair_stop(gicBase);
+    gicBase->fair_demotions = 0;
+    gicBase->fair_restores = 0;
+    if (window != 0)
+    {
+        gicBase->fair_window = window;
+        gicBase->fair_share = share;
+        gicBase->fair_dispatches = 0;
+        gicBase->fair_epoch = (gicBase->fair_epoch + 1) & 0xFFFF;
+        gicBase->dispatch.hooks |= GIC_HOOK_FAIR;
+    }
+    Enable();
+
+    ReleaseSemaphore(&gicBase->semaphore);
+
+    KprintfH("[gic] %s: window %lu, share %lu\n", __func__, window, share);
+    return 0;
+}
+
+/* GetIntFairness: Report the fairness policy and the IRQs it has demoted.
+ * Args: info - filled with the settings, counters and demoted IRQs.
+ * Returns: 0 on success, negative GIC400_ERR_* on failure.
+ */
+LONG GetIntFairness(struct GICFairnessInfo *info asm("a0"), struct GIC_Base *gicBase asm("a6"))
+{
+    GIC_MMIO_SCOPE(GIC400_STAT_FAIRNESS);
+    if (!gicBase)
+        return GIC400_ERR_NOT_READY;
+    if (!info)
+        return GIC400_ERR_INVALID_ARGUMENT;
+
+    Disable();
+    info->window = gicBase->fair_window;
+    info->share = gicBase->fair_share;
+    info->demotions = gicBase->fair_demotions;
+    info->restores = gicBase->fair_restores;
+    info->demotedCount = (UWORD)gicBase->fair_demoted_count;
+    for (u32 i = 0; i < gicBase->fair_demoted_count; i++)
+        info->demoted[i] = gicBase->fair_demoted[i].irq;
+    Enable();
+
+    return 0;
+}
+
+/* gic400_fair_shutdown: Turn the policy off and free the service counts. */
+void gic400_fair_shutdown(struct GIC_Base *gicBase)
+{
+    Disable();
+    gic400_fair_stop(gicBase);
+    Enable();
+
+    if (gicBase->fair_counts)
+    {
+        FreeMem(gicBase->fair_counts, gicBase->max_irqs * sizeof(u32));
+        gicBase->fair_counts = NULL;
+    }
+}
@@ -0,0 +1,203 @@
+// SPDX-License-Identifier: MPL-2.0 OR GPL-2.0+
+#include <exec/memory.h>
+#include <gic400_private.h>
+
+static const char gic_group_name[] = "ARM GIC-400 IRQ group";
+
+/* gic400_group_server: Member server shared by every IRQ of a group.
+ * The dispatcher acknowledged one member; the other pending members are
+ * collected from ISPENDR (one read per run of members in the same 32-IRQ
+ * block) and their pending state cleared with one ICPENDR write, so the
+ * caller's server runs once for the whole burst. Only the acknowledged IRQ
+ * is active and receives the dispatcher's EOI.
+ * Args: irq - acknowledged member; group - is_Data.
+ */
+static ULONG gic400_group_server(register u32 irq asm("d0"), register struct GIC_IntGroup *group asm("a1"))
+{
+    struct GIC_Base *gicBase = group->base;
+    u32 mask = 0;
+    u32 reg_index = ~0u;
+    u32 pending = 0;
+    u32 clear = 0;
+
+    for (u32 i = 0; i < group->count; i++)
+    {
+        u32 member = group->irqs[i];
+        if (member == irq)
+        {
+            mask |= (u32)1 << i;
+            continue;
+        }
+
+        if ((member >> 5) != reg_index)
+        {
+            if (clear)
+                gic_write32(clear, GICD_ICPENDR(reg_index));
+            reg_index = member >> 5;
+            pending = gic_read32(GICD_ISPENDR(reg_index));
+            clear = 0;
+        }
+
+        u32 bit = (u32)1 << (member & 0x1F);
+        if (pending & bit)
+        {
+            mask |= (u32)1 << i;
+            clear |= bit;
+        }
+    }
+    if (clear)
+        gic_write32(clear, GICD_ICPENDR(reg_index));
+
+    gic400_call_interrupt_hint(group->interrupt, irq, mask);
+    return 0;
+}
+
+/* gic400_group_find: Look up the group registered for a caller's server.
+ * Must be called with the semaphore held.
+ * Returns: group, or NULL when there is none.
+ */
+static struct GIC_IntGroup *gic400_group_find(struct GIC_Base *gicBase, struct Interrupt *interrupt)
+{
+    for (struct MinNode *node = gicBase->groups.mlh_Head; node->mln_Succ != NULL; node = node->mln_Succ)
+    {
+        struct GIC_IntGroup *group = (struct GIC_IntGroup *)node;
+        if (group->interrupt == interrupt)
+            return group;
+    }
+    return NULL;
+}
+
+/* gic400_group_free: Remove every member server and free the group.
+ * Args: registered - number of members registered so far.
+ * Returns: void.
+ */
+static void gic400_group_free(struct GIC_Base *gicBase, struct GIC_IntGroup *group, u32 registered)
+{
+    for (u32 i = 0; i < registered; i++)
+        gic400_rem_server(gicBase, group->irqs[i], &group->server);
+    FreeMem(group, sizeof(struct GIC_IntGroup) + group->count * sizeof(u32));
+}
+
+/* AddIntServerGroup: Register one server for a set of related IRQs.
+ * Every member is configured like AddIntServerEx() and routed to the group
+ * server, which calls the caller's server once per burst with the
+ * acknowledged IRQ in D0 and the mask of members that fired in D1.
+ * Args:
+ *  irqs - member IRQ numbers; bit n of the mask stands for irqs[n]
+ *  count - number of members (1-GIC400_GROUP_MAX)
+ *  priority - priority byte to assign to all members (0-0x7f)
+ *  edge - TRUE for edge-triggered, FALSE for level-triggered
+ *  interrupt - Exec interrupt descriptor
+ * Returns: 0 on success, negative GIC400_ERR_* on failure.
+ */
+LONG AddIntServerGroup(const ULONG *irqs asm("a0"), ULONG count asm("d0"), UBYTE priority asm("d1"), BOOL edge asm("d2"), struct Interrupt *interrupt asm("a1"), struct GIC_Base *gicBase asm("a6"))
+{
+    GIC_MMIO_SCOPE(GIC400_STAT_GROUP);
+    if (!gicBase)
+        return GIC400_ERR_NOT_READY;
+    if (!irqs || count == 0 || count > GIC400_GROUP_MAX || !interrupt || !interrupt->is_Code)
+    {
+        Kprintf("[gic] %s: Invalid IRQ group\n", __func__);
+        return GIC400_ERR_INVALID_ARGUMENT;
+    }
+    for (u32 i = 0; i < count; i++)
+    {
+        for (u32 j = 0; j < i; j++)
+        {
+            if (irqs[i] == irqs[j])
+            {
+                Kprintf("[gic] %s: IRQ %lu listed twice\n", __func__, irqs[i]);
+                return GIC400_ERR_INVALID_ARGUMENT;
+            }
+        }
+    }
+
+    u32 bytes = sizeof(struct GIC_IntGroup) + count * sizeof(u32);
+    struct GIC_IntGroup *group = AllocMem(bytes, MEMF_CLEAR);
+    if (!group)
+    {
+        Kprintf("[gic] %s: Failed to allocate IRQ group (%lu bytes)\n", __func__, bytes);
+        return GIC400_ERR_NO_MEMORY;
+    }
+
+    group->server.is_Node.ln_Type = NT_INTERRUPT;
+    group->server.is_Node.ln_Name = (char *)gic_group_name;
+    group->server.is_Data = group;
+    group->server.is_Code = (APTR)gic400_group_server;
+    group->interrupt = interrupt;
+    group->base = gicBase;
+    group->count = count;
+    for (u32 i = 0; i < count; i++)
+        group->irqs[i] = irqs[i];
+
+    ObtainSemaphore(&gicBase->semaphore);
+
+    if (gic400_group_find(gicBase, interrupt))
+    {
+        ReleaseSemaphore(&gicBase->semaphore);
+        FreeMem(group, bytes);
+        Kprintf("[gic] %s: Server already registered for a group\n", __func__);
+        return GIC400_ERR_ALREADY_REGISTERED;
+    }
+
+    for (u32 i = 0; i < count; i++)
+    {
+        s32 ret = gic400_add_server(gicBase, group->irqs[i], priority, edge, &group->server);
+        if (ret < 0)
+        {
+            gic400_group_free(gicBase, group, i);
+            ReleaseSemaphore(&gicBase->semaphore);
+            return ret;
+        }
+    }
+
+    AddTail((struct List *)&gicBase->groups, (struct Node *)&group->node);
+    ReleaseSemaphore(&gicBase->semaphore);
+
+    KprintfH("[gic] %s: %lu IRQs grouped for %08lx\n", __func__, count, interrupt);
+    return 0;
+}
+
+/* RemIntServerGroup: Remove a server registered with AddIntServerGroup().
+ * Args: interrupt - the server passed at registration.
+ * Returns: 0 on success, negative GIC400_ERR_* on failure.
+ */
+LONG RemIntServerGroup(struct Interrupt *interrupt asm("a1"), struct GIC_Base *gicBase asm("a6"))
+{
+    GIC_MMIO_SCOPE(GIC400_STAT_GROUP);
+    if (!gicBase)
+        return GIC400_ERR_NOT_READY;
+    if (!interrupt)
+        return GIC400_ERR_INVALID_ARGUMENT;
+
+    ObtainSemaphore(&gicBase->semaphore);
+
+    struct GIC_IntGroup *group = gic400_group_find(gicBase, interrupt);
+    if (!group)
+    {
+        ReleaseSemaphore(&gicBase->semaphore);
+        Kprintf("[gic] %s: No group registered for %08lx\n", __func__, interrupt);
+        return GIC400_ERR_NOT_FOUND;
+    }
+
+    Remove((struct Node *)&group->node);
+    gic400_group_free(gicBase, group, group->count);
+
+    ReleaseSemaphore(&gicBase->semaphore);
+    return 0;
+}
+
+/* gic400_group_shutdown: Remove every group still registered.
+ * Args: none.
+ * Returns: void.
+ */
+void gic400_group_shutdown(struct GIC_Base *gicBase)
+{
+    while (gicBase->groups.mlh_Head->mln_Succ != NULL)
+    {
+        struct GIC_IntGroup *group = (struct GIC_IntGroup *)gicBase->groups.mlh_Head;
+        Remove((struct Node *)&group->node);
+        Kprintf("[gic] warning: removed IRQ group for %08lx during shutdown\n", group->interrupt);
+        gic400_group_free(gicBase, group, group->count);
+    }
+}
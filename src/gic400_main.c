@@ -129,6 +129,57 @@ static const APTR funcTable[] = {
     (APTR)GetRunningPriority,
     (APTR)GetHighestPending,
     (APTR)GetControllerInfo,
+    (APTR)GetMmioStats,
+    (APTR)ResetMmioStats,
+    (APTR)SetIntTargets,
+    (APTR)StartTimer,
+    (APTR)StopTimer,
+    (APTR)ReadTimerCounter,
+    (APTR)AllocSoftInt,
+    (APTR)FreeSoftInt,
+    (APTR)RaiseSoftInt,
+    (APTR)SetIntOverrunDetect,
+    (APTR)GetIntOverruns,
+    (APTR)RaiseIntPriority,
+    (APTR)RestoreIntPriority,
+    (APTR)BeginIntConfig,
+    (APTR)StageIntConfig,
+    (APTR)CommitIntConfig,
+    (APTR)AbortIntConfig,
+    (APTR)AddIntServerGroup,
+    (APTR)RemIntServerGroup,
+    (APTR)FindDTInterrupt,
+    (APTR)AddIntServerDT,
+    (APTR)ReplaceIntServerEx,
+    (APTR)StartProfiler,
+    (APTR)StopProfiler,
+    (APTR)DumpProfiler,
+    (APTR)CreateIntQueue,
+    (APTR)DeleteIntQueue,
+    (APTR)PutIntQueue,
+    (APTR)GetIntQueue,
+    (APTR)SetIntFairness,
+    (APTR)GetIntFairness,
+    (APTR)SetIntTimestamp,
+    (APTR)GetIntTimestamp,
+    (APTR)MeasureIntLatency,
+    (APTR)SetWarmRestart,
+    (APTR)StartIntTrace,
+    (APTR)StopIntTrace,
+    (APTR)ReadIntTrace,
+    (APTR)LoadIntTuning,
+    (APTR)AddIntServerClass,
+    (APTR)GetIntClassMap,
+    (APTR)CreateIntPool,
+    (APTR)DeleteIntPool,
+    (APTR)AllocPoolObject,
+    (APTR)FreePoolObject,
+    (APTR)AllocPoolObjects,
+    (APTR)FreePoolObjects,
+    (APTR)GetPoolStats,
+    (APTR)SetIntBudget,
+    (APTR)GetIntBudgets,
+    (APTR)QueueWork,
     (APTR)-1};
 
 static const APTR initTable[4] = {
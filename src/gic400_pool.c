@@ -0,0 +1,254 @@
+// SPDX-License-Identifier: MPL-2.0 OR GPL-2.0+
+#include <exec/memory.h>
+#include <gic400_private.h>
+
+/* gic400_pool_cas: Replace the free-list head if it is still expected.
+ * Args: expected - head value read before; updated with the current value
+ *  on failure.
+ * Returns: TRUE when head was replaced.
+ */
+static inline BOOL gic400_pool_cas(struct GIC_Pool *pool, u32 *expected, u32 desired)
+{
+    return __atomic_compare_exchange_n(&pool->head, expected, desired, FALSE, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+
+/* gic400_pool_index: Map an object pointer back to its index.
+ * Returns: index, or GIC_POOL_NIL when the pointer is not one of ours.
+ */
+static u32 gic400_pool_index(const struct GIC_Pool *pool, APTR object)
+{
+    u32 offset = (u32)((u8 *)object - pool->objects);
+    if ((u8 *)object < pool->objects || offset >= pool->count * pool->size || offset % pool->size != 0)
+        return GIC_POOL_NIL;
+    return offset / pool->size;
+}
+
+/* gic400_pool_taken: Account for objects leaving the pool. */
+static void gic400_pool_taken(struct GIC_Pool *pool, u32 count)
+{
+    u32 in_use = __atomic_add_fetch(&pool->in_use, count, __ATOMIC_RELAXED);
+    u32 high = pool->high_water;
+    while (in_use > high && !__atomic_compare_exchange_n(&pool->high_water, &high, in_use, FALSE, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        ;
+}
+
+/* gic400_pool_pop: Take up to count objects off the free list at once.
+ * Walks count links from the head and swings the head past them; any
+ * concurrent change bumps the tag and makes the swap fail and retry.
+ * Args: objects - receives the objects; count - how many are wanted.
+ * Returns: number of objects taken.
+ */
+static u32 gic400_pool_pop(struct GIC_Pool *pool, APTR *objects, u32 count)
+{
+    u32 old = pool->head;
+    u32 taken;
+    u32 index;
+
+    do
+    {
+        taken = 0;
+        index = old & 0xFFFF;
+        while (taken < count && index != GIC_POOL_NIL)
+        {
+            objects[taken++] = pool->objects + index * pool->size;
+            index = pool->next[index];
+        }
+        if (taken == 0)
+            break;
+    } while (!gic400_pool_cas(pool, &old, ((old + 0x10000) & 0xFFFF0000) | index));
+
+    if (taken < count)
+        __atomic_add_fetch(&pool->exhausted, 1, __ATOMIC_RELAXED);
+    if (taken)
+        gic400_pool_taken(pool, taken);
+    return taken;
+}
+
+/* gic400_pool_push: Return a chain of objects to the free list at once.
+ * Args: first/last - chain already linked through next[].
+ * Returns: void.
+ */
+static void gic400_pool_push(struct GIC_Pool *pool, u32 first, u32 last, u32 count)
+{
+    u32 old = pool->head;
+    do
+    {
+        pool->next[last] = (u16)(old & 0xFFFF);
+    } while (!gic400_pool_cas(pool, &old, ((old + 0x10000) & 0xFFFF0000) | first));
+
+    __atomic_sub_fetch(&pool->in_use, count, __ATOMIC_RELAXED);
+}
+
+/* CreateIntPool: Allocate a pool of fixed-size objects.
+ * All memory is allocated here; the pool never grows. The free list and
+ * the first object start on a 64-byte line.
+ * Args: size - object size in bytes (rounded up to 4); count - number of
+ *  objects (1-GIC400_POOL_MAX).
+ * Returns: pool, or NULL on failure.
+ */
+struct GICPool *CreateIntPool(ULONG size asm("d0"), ULONG count asm("d1"), struct GIC_Base *gicBase asm("a6"))
+{
+    GIC_MMIO_SCOPE(GIC400_STAT_POOL);
+    if (!gicBase)
+        return NULL;
+    if (size == 0 || size > 0x10000 || count == 0 || count > GIC400_POOL_MAX)
+    {
+        Kprintf("[gic] %s: Invalid pool of %lu x %lu bytes\n", __func__, count, size);
+        return NULL;
+    }
+
+    u32 stride = (size + 3) & ~3u;
+    u32 header = (sizeof(struct GIC_Pool) + count * sizeof(u16) + GIC_QUEUE_LINE - 1) & ~(u32)(GIC_QUEUE_LINE - 1);
+    if (count > (0xFFFFFFFFu - header - GIC_QUEUE_LINE) / stride)
+    {
+        Kprintf("[gic] %s: Pool of %lu x %lu bytes is too large\n", __func__, count, size);
+        return NULL;
+    }
+    u32 bytes = GIC_QUEUE_LINE - 1 + header + count * stride;
+    APTR raw = AllocMem(bytes, MEMF_PUBLIC | MEMF_CLEAR);
+    if (!raw)
+    {
+        Kprintf("[gic] %s: Failed to allocate pool (%lu bytes)\n", __func__, bytes);
+        return NULL;
+    }
+
+    struct GIC_Pool *pool = (struct GIC_Pool *)(((u32)raw + GIC_QUEUE_LINE - 1) & ~(u32)(GIC_QUEUE_LINE - 1));
+    pool->raw = raw;
+    pool->bytes = bytes;
+    pool->size = stride;
+    pool->count = count;
+    pool->objects = (u8 *)pool + header;
+
+    for (u32 i = 0; i < count; i++)
+        pool->next[i] = (u16)(i + 1 < count ? i + 1 : GIC_POOL_NIL);
+    pool->head = 0;
+
+    return (struct GICPool *)pool;
+}
+
+/* DeleteIntPool: Free a pool; no object may be in use any more.
+ * Returns: 0 on success, negative GIC400_ERR_* on failure.
+ */
+LONG DeleteIntPool(struct GICPool *pool asm("a0"), struct GIC_Base *gicBase asm("a6"))
+{
+    GIC_MMIO_SCOPE(GIC400_STAT_POOL);
+    if (!gicBase)
+        return GIC400_ERR_NOT_READY;
+    if (!pool)
+        return GIC400_ERR_INVALID_ARGUMENT;
+
+    struct GIC_Pool *p = (struct GIC_Pool *)pool;
+    if (p->in_use)
+    {
+        Kprintf("[gic] %s: %lu objects still in use\n", __func__, p->in_use);
+        return GIC400_ERR_BUSY;
+    }
+
+    FreeMem(p->raw, p->bytes);
+    return 0;
+}
+
+/* AllocPoolObject: Take one object; callable from interrupt servers.
+ * The object's contents are whatever its last user left.
+ * Returns: object, or NULL when the pool is exhausted.
+ */
+APTR AllocPoolObject(struct GICPool *pool asm("a0"), struct GIC_Base *gicBase asm("a6"))
+{
+    GIC_MMIO_SCOPE(GIC400_STAT_POOL);
+    (void)gicBase;
+    if (!pool)
+        return NULL;
+
+    APTR object = NULL;
+    gic400_pool_pop((struct GIC_Pool *)pool, &object, 1);
+    return object;
+}
+
+/* FreePoolObject: Return one object; callable from interrupt servers.
+ * Returns: 0 on success, negative GIC400_ERR_* on failure.
+ */
+LONG FreePoolObject(struct GICPool *pool asm("a0"), APTR object asm("a1"), struct GIC_Base *gicBase asm("a6"))
+{
+    GIC_MMIO_SCOPE(GIC400_STAT_POOL);
+    (void)gicBase;
+    struct GIC_Pool *p = (struct GIC_Pool *)pool;
+    if (!p)
+        return GIC400_ERR_INVALID_ARGUMENT;
+
+    u32 index = gic400_pool_index(p, object);
+    if (index == GIC_POOL_NIL)
+        return GIC400_ERR_INVALID_ARGUMENT;
+
+    gic400_pool_push(p, index, index, 1);
+    return 0;
+}
+
+/* AllocPoolObjects: Take up to count objects with a single list update.
+ * Args: objects - receives the objects; count - how many are wanted.
+ * Returns: number of objects taken (fewer when the pool runs out), or
+ *  negative GIC400_ERR_* on failure.
+ */
+LONG AllocPoolObjects(struct GICPool *pool asm("a0"), APTR *objects asm("a1"), ULONG count asm("d0"), struct GIC_Base *gicBase asm("a6"))
+{
+    GIC_MMIO_SCOPE(GIC400_STAT_POOL);
+    (void)gicBase;
+    if (!pool || !objects)
+        return GIC400_ERR_INVALID_ARGUMENT;
+    if (count == 0)
+        return 0;
+
+    return (LONG)gic400_pool_pop((struct GIC_Pool *)pool, objects, count);
+}
+
+/* FreePoolObjects: Return count objects with a single list update.
+ * Every pointer is checked before any object is returned.
+ * Returns: 0 on success, negative GIC400_ERR_* on failure.
+ */
+LONG FreePoolObjects(struct GICPool *pool asm("a0"), APTR *objects asm("a1"), ULONG count asm("d0"), struct GIC_Base *gicBase asm("a6"))
+{
+    GIC_MMIO_SCOPE(GIC400_STAT_POOL);
+    (void)gicBase;
+    struct GIC_Pool *p = (struct GIC_Pool *)pool;
+    if (!p || !objects)
+        return GIC400_ERR_INVALID_ARGUMENT;
+    if (count == 0)
+        return 0;
+
+    for (u32 i = 0; i < count; i++)
+    {
+        if (gic400_pool_index(p, objects[i]) == GIC_POOL_NIL)
+            return GIC400_ERR_INVALID_ARGUMENT;
+    }
+
+    /* the objects are ours until pushed, so their links are free to set */
+    u32 first = gic400_pool_index(p, objects[0]);
+    u32 last = first;
+    for (u32 i = 1; i < count; i++)
+    {
+        u32 index = gic400_pool_index(p, objects[i]);
+        p->next[last] = (u16)index;
+        last = index;
+    }
+
+    gic400_pool_push(p, first, last, count);
+    return 0;
+}
+
+/* GetPoolStats: Read a pool's size and usage counters.
+ * Returns: 0 on success, negative GIC400_ERR_* on failure.
+ */
+LONG GetPoolStats(struct GICPool *pool asm("a0"), struct GICPoolStats *stats asm("a1"), struct GIC_Base *gicBase asm("a6"))
+{
+    GIC_MMIO_SCOPE(GIC400_STAT_POOL);
+    (void)gicBase;
+    struct GIC_Pool *p = (struct GIC_Pool *)pool;
+    if (!p || !stats)
+        return GIC400_ERR_INVALID_ARGUMENT;
+
+    stats->size = p->size;
+    stats->count = p->count;
+    stats->inUse = p->in_use;
+    stats->highWater = p->high_water;
+    stats->exhausted = p->exhausted;
+    return 0;
+}
@@ -0,0 +1,152 @@
+// SPDX-License-Identifier: MPL-2.0 OR GPL-2.0+
+#include <exec/memory.h>
+#include <gic400_private.h>
+
+static const char gic_probe_name[] = "ARM GIC-400 latency probe";
+
+/* How long one raise may take to reach the server, in timer ticks (us). */
+#define GIC400_PROBE_TIMEOUT 100000
+
+/* Probe state shared with the server; lives on the caller's stack. */
+struct GIC_Probe
+{
+    struct Interrupt server;
+    struct GIC_Base *base;
+    volatile u32 entered; // set by the server
+    volatile u32 stamp;   // timer value at server entry
+};
+
+/* gic400_probe_server: Record the time the dispatcher reached us.
+ * Args: probe - is_Data.
+ */
+static ULONG gic400_probe_server(register struct GIC_Probe *probe asm("a1"))
+{
+    struct GIC_Base *gicBase = probe->base;
+    probe->stamp = gic400_timer_now();
+    probe->entered = 1;
+    return 0;
+}
+
+/* gic400_probe_stats: Summarise one set of samples.
+ * Sorts the samples in place (Shell sort, no recursion or extra memory);
+ * p99 is the nearest-rank 99th percentile.
+ * Args: samples - latencies; count - number of samples; stats - output.
+ * Returns: void.
+ */
+static void gic400_probe_stats(u32 *samples, u32 count, struct GICLatencyStats *stats)
+{
+    u32 gap = 1;
+    while (gap < count / 3)
+        gap = gap * 3 + 1;
+
+    for (; gap > 0; gap /= 3)
+    {
+        for (u32 i = gap; i < count; i++)
+        {
+            u32 value = samples[i];
+            u32 j = i;
+            while (j >= gap && samples[j - gap] > value)
+            {
+                samples[j] = samples[j - gap];
+                j -= gap;
+            }
+            samples[j] = value;
+        }
+    }
+
+    u32 sum = 0;
+    for (u32 i = 0; i < count; i++)
+        sum += samples[i];
+
+    stats->min = samples[0];
+    stats->mean = sum / count;
+    stats->p99 = samples[(count * 99 + 99) / 100 - 1];
+    stats->max = samples[count - 1];
+}
+
+/* MeasureIntLatency: Time the library's own interrupt path.
+ * Reserves an unused SPI as a software interrupt at the requested priority
+ * and raises it iterations times through ISPENDR, busy-waiting for each
+ * service. The result reflects the current GICC_PMR, running priority and
+ * the load of other servers, so it can be repeated at several priorities.
+ * Args: probe - iterations and priority in, statistics out.
+ * Returns: 0 on success, negative GIC400_ERR_* on failure; GIC400_ERR_TIMEOUT
+ *  when a raise was not serviced (e.g. the priority is masked).
+ */
+LONG MeasureIntLatency(struct GICLatencyProbe *probe asm("a0"), struct GIC_Base *gicBase asm("a6"))
+{
+    GIC_MMIO_SCOPE(GIC400_STAT_PROBE);
+    if (!gicBase)
+        return GIC400_ERR_NOT_READY;
+    if (!probe || probe->iterations == 0 || probe->iterations > GIC400_PROBE_MAX)
+        return GIC400_ERR_INVALID_ARGUMENT;
+    LONG ret = gic400_ensure_live(gicBase);
+    if (ret < 0)
+        return ret;
+    if (!gicBase->systimer_base)
+        return GIC400_ERR_NOT_SUPPORTED;
+
+    u32 count = probe->iterations;
+    u32 bytes = 2 * count * sizeof(u32);
+    u32 *entry = AllocMem(bytes, MEMF_ANY);
+    if (!entry)
+    {
+        Kprintf("[gic] %s: Failed to allocate samples (%lu bytes)\n", __func__, bytes);
+        return GIC400_ERR_NO_MEMORY;
+    }
+    u32 *resume = entry + count;
+
+    struct GIC_Probe state;
+    state.server.is_Node.ln_Type = NT_INTERRUPT;
+    state.server.is_Node.ln_Pri = 0;
+    state.server.is_Node.ln_Name = (char *)gic_probe_name;
+    state.server.is_Data = &state;
+    state.server.is_Code = (APTR)gic400_probe_server;
+    state.base = gicBase;
+
+    LONG irq = AllocSoftInt(probe->priority, &state.server, gicBase);
+    if (irq < 0)
+    {
+        FreeMem(entry, bytes);
+        return irq;
+    }
+
+    ret = 0;
+    for (u32 i = 0; i < count; i++)
+    {
+        state.entered = 0;
+        u32 raised = gic400_timer_now();
+        gicd_set_pending(gicBase, (u32)irq);
+
+        while (!state.entered)
+        {
+            if (gic400_timer_now() - raised > GIC400_PROBE_TIMEOUT)
+                break;
+        }
+        u32 resumed = gic400_timer_now();
+
+        if (!state.entered)
+        {
+            Kprintf("[gic] %s: IRQ %ld at priority 0x%02lx not serviced\n", __func__, irq, (u32)probe->priority);
+            ret = GIC400_ERR_TIMEOUT;
+            break;
+        }
+
+        entry[i] = state.stamp - raised;
+        resume[i] = resumed - state.stamp;
+    }
+
+    FreeSoftInt((ULONG)irq, gicBase);
+
+    if (ret == 0)
+    {
+        probe->irq = (ULONG)irq;
+        gic400_probe_stats(entry, count, &probe->entry);
+        gic400_probe_stats(resume, count, &probe->exit);
+        KprintfH("[gic] %s: %lu raises, entry %lu/%lu/%lu/%lu us\n", __func__, count,
+                 probe->entry.min, probe->entry.mean, probe->entry.p99, probe->entry.max);
+    }
+
+    FreeMem(entry, bytes);
+    return ret;
+}
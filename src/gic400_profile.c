@@ -0,0 +1,225 @@
+// SPDX-License-Identifier: MPL-2.0 OR GPL-2.0+
+#include <exec/memory.h>
+#include <gic400_private.h>
+
+static const char gic_profile_name[] = "ARM GIC-400 profiler";
+
+/* How far up the supervisor stack to look for the level 6 exception frame. */
+#define GIC400_PROFILE_SCAN 1024
+/* Format/vector word of a format 0 frame for the level 6 autovector (0x78). */
+#define GIC400_PROFILE_FRAME 0x0078
+
+/* gic400_profile_plausible: Check a candidate level 6 exception frame.
+ * Args: p - candidate format/vector word, below it PC and SR.
+ * Returns: TRUE when the word matches and the SR above it is plausible:
+ *  interrupt mask below 6, unused bits clear, and an even PC.
+ */
+static BOOL gic400_profile_plausible(const UWORD *p)
+{
+    if (*p != GIC400_PROFILE_FRAME)
+        return FALSE;
+
+    UWORD sr = p[-3];
+    ULONG pc = ((ULONG)p[-2] << 16) | p[-1];
+    return (sr & 0x0700) < 0x0600 && (sr & 0x08E0) == 0 && (pc & 1) == 0;
+}
+
+/* gic400_profile_frame: Find the interrupted PC and SR on the stack.
+ * The sampling server is always called the same number of words below the
+ * level 6 exception frame (SR, PC, format/vector), so once found the frame
+ * is looked for at that distance from the server's own frame first. Until
+ * then, or when the word there no longer matches, the stack above is
+ * scanned; a hit is only used, and becomes the anchor, when it is the only
+ * plausible frame in range, as data that looks like a frame cannot be told
+ * from the real one.
+ * Args: frame - the server's frame address; sample - filled with pc/sr, or
+ *  flagged GIC400_PROF_NOFRAME (and GIC400_PROF_AMBIGUOUS for several
+ *  candidates).
+ * Returns: void.
+ */
+static void gic400_profile_frame(struct GIC_Base *gicBase, const UWORD *frame, struct GICProfileSample *sample)
+{
+    const UWORD *found = NULL;
+    u32 anchor = gicBase->profile_anchor;
+
+    if (anchor != 0 && gic400_profile_plausible(frame + anchor))
+        found = frame + anchor;
+    else
+    {
+        u32 candidates = 0;
+        for (u32 offset = 3; offset < GIC400_PROFILE_SCAN / sizeof(UWORD); offset++)
+        {
+            if (!gic400_profile_plausible(frame + offset))
+                continue;
+            if (candidates++ == 0)
+                anchor = offset;
+        }
+
+        if (candidates == 1)
+        {
+            found = frame + anchor;
+            gicBase->profile_anchor = anchor;
+        }
+        sample->flags = candidates > 1 ? GIC400_PROF_NOFRAME | GIC400_PROF_AMBIGUOUS : GIC400_PROF_NOFRAME;
+    }
+
+    if (!found)
+    {
+        sample->pc = 0;
+        sample->sr = 0;
+        return;
+    }
+
+    sample->pc = ((ULONG)found[-2] << 16) | found[-1];
+    sample->sr = found[-3];
+    sample->flags = 0;
+}
+
+/* gic400_profile_server: Record one sample per profiler tick.
+ * Args: gicBase - library base (is_Data).
+ */
+static ULONG gic400_profile_server(register struct GIC_Base *gicBase asm("a1"))
+{
+    const UWORD *frame = (const UWORD *)__builtin_frame_address(0);
+    u32 count = gicBase->profile_count;
+    if (count >= gicBase->profile_size)
+    {
+        gicBase->profile_dropped++;
+        return 0;
+    }
+
+    struct GICProfileSample *sample = &gicBase->profile_buffer[count];
+    gic400_profile_frame(gicBase, frame, sample);
+    sample->task = FindTask(NULL);
+    gicBase->profile_count = count + 1;
+    return 0;
+}
+
+/* StartProfiler: Start sampling the interrupted PC on a periodic timer.
+ * The sample buffer is allocated here, so sampling itself never allocates;
+ * samples are kept until the next StartProfiler() or library expunge.
+ * Args: samples - buffer size in samples (1-GIC400_PROF_MAX); interval -
+ *  sampling period in GIC400_TIMER_FREQUENCY ticks.
+ * Returns: 0 on success, negative GIC400_ERR_* on failure.
+ */
+LONG StartProfiler(ULONG samples asm("d0"), ULONG interval asm("d1"), struct GIC_Base *gicBase asm("a6"))
+{
+    GIC_MMIO_SCOPE(GIC400_STAT_PROFILER);
+    if (!gicBase)
+        return GIC400_ERR_NOT_READY;
+    if (samples == 0 || samples > GIC400_PROF_MAX || interval == 0)
+        return GIC400_ERR_INVALID_ARGUMENT;
+    LONG ret = gic400_ensure_live(gicBase);
+    if (ret < 0)
+        return ret;
+    if (!gicBase->systimer_base)
+        return GIC400_ERR_NOT_SUPPORTED;
+
+    ObtainSemaphore(&gicBase->semaphore);
+
+    if (gicBase->profile_running)
+    {
+        ReleaseSemaphore(&gicBase->semaphore);
+        return GIC400_ERR_BUSY;
+    }
+
+    if (gicBase->profile_buffer && gicBase->profile_size != samples)
+    {
+        FreeMem(gicBase->profile_buffer, gicBase->profile_size * sizeof(struct GICProfileSample));
+        gicBase->profile_buffer = NULL;
+    }
+    if (!gicBase->profile_buffer)
+    {
+        u32 bytes = samples * sizeof(struct GICProfileSample);
+        gicBase->profile_buffer = AllocMem(bytes, MEMF_CLEAR);
+        if (!gicBase->profile_buffer)
+        {
+            ReleaseSemaphore(&gicBase->semaphore);
+            Kprintf("[gic] %s: Failed to allocate sample buffer (%lu bytes)\n", __func__, bytes);
+            return GIC400_ERR_NO_MEMORY;
+        }
+        gicBase->profile_size = samples;
+    }
+    gicBase->profile_count = 0;
+    gicBase->profile_dropped = 0;
+    gicBase->profile_anchor = 0;
+
+    gicBase->profile_interrupt.is_Node.ln_Type = NT_INTERRUPT;
+    gicBase->profile_interrupt.is_Node.ln_Name = (char *)gic_profile_name;
+    gicBase->profile_interrupt.is_Data = gicBase;
+    gicBase->profile_interrupt.is_Code = (APTR)gic400_profile_server;
+    gicBase->profile_timer.interrupt = &gicBase->profile_interrupt;
+    gicBase->profile_timer.armed = FALSE;
+
+    ret = StartTimer(&gicBase->profile_timer, interval, interval, gicBase);
+    if (ret == 0)
+        gicBase->profile_running = TRUE;
+
+    ReleaseSemaphore(&gicBase->semaphore);
+    return ret;
+}
+
+/* StopProfiler: Stop sampling; the samples stay available to DumpProfiler().
+ * Args: dropped - optional output for ticks lost to a full buffer.
+ * Returns: number of samples recorded, or negative GIC400_ERR_* on failure.
+ */
+LONG StopProfiler(ULONG *dropped asm("a0"), struct GIC_Base *gicBase asm("a6"))
+{
+    GIC_MMIO_SCOPE(GIC400_STAT_PROFILER);
+    if (!gicBase)
+        return GIC400_ERR_NOT_READY;
+
+    ObtainSemaphore(&gicBase->semaphore);
+    if (gicBase->profile_running)
+    {
+        StopTimer(&gicBase->profile_timer, gicBase);
+        gicBase->profile_running = FALSE;
+    }
+    ReleaseSemaphore(&gicBase->semaphore);
+
+    if (dropped)
+        *dropped = gicBase->profile_dropped;
+    return (LONG)gicBase->profile_count;
+}
+
+/* DumpProfiler: Copy recorded samples out, oldest first.
+ * May be called while sampling; only samples complete at the time of the
+ * call are copied.
+ * Args: buffer - destination; max - its size in samples.
+ * Returns: number of samples copied, or negative GIC400_ERR_* on failure.
+ */
+LONG DumpProfiler(struct GICProfileSample *buffer asm("a0"), ULONG max asm("d0"), struct GIC_Base *gicBase asm("a6"))
+{
+    GIC_MMIO_SCOPE(GIC400_STAT_PROFILER);
+    if (!gicBase)
+        return GIC400_ERR_NOT_READY;
+    if (!buffer)
+        return GIC400_ERR_INVALID_ARGUMENT;
+
+    ObtainSemaphore(&gicBase->semaphore);
+
+    u32 count = gicBase->profile_count;
+    if (count > max)
+        count = max;
+    for (u32 i = 0; i < count; i++)
+        buffer[i] = gicBase->profile_buffer[i];
+
+    ReleaseSemaphore(&gicBase->semaphore);
+    return (LONG)count;
+}
+
+/* gic400_profile_shutdown: Stop sampling and free the sample buffer. */
+void gic400_profile_shutdown(struct GIC_Base *gicBase)
+{
+    if (gicBase->profile_running)
+    {
+        StopTimer(&gicBase->profile_timer, gicBase);
+        gicBase->profile_running = FALSE;
+    }
+
+    if (gicBase->profile_buffer)
+    {
+        FreeMem(gicBase->profile_buffer, gicBase->profile_size * sizeof(struct GICProfileSample));
+        gicBase->profile_buffer = NULL;
+    }
+}
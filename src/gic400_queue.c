@@ -0,0 +1,107 @@
+// SPDX-License-Identifier: MPL-2.0 OR GPL-2.0+
+#include <exec/memory.h>
+#include <gic400_private.h>
+
+/* CreateIntQueue: Allocate an interrupt-to-task handoff ring.
+ * Args:
+ *  capacity - number of slots, a power of two (2-65536)
+ *  task - consumer to signal, NULL for none
+ *  signalMask - signals sent when the ring goes from empty to non-empty
+ * Returns: queue, or NULL on failure.
+ */
+struct GICIntQueue *CreateIntQueue(ULONG capacity asm("d0"), struct Task *task asm("a0"), ULONG signalMask asm("d1"), struct GIC_Base *gicBase asm("a6"))
+{
+    GIC_MMIO_SCOPE(GIC400_STAT_QUEUE);
+    if (!gicBase)
+        return NULL;
+    if (capacity < 2 || capacity > 65536 || (capacity & (capacity - 1)) != 0)
+    {
+        Kprintf("[gic] %s: Capacity %lu is not a power of two\n", __func__, capacity);
+        return NULL;
+    }
+
+    u32 bytes = sizeof(struct GIC_IntQueue) + capacity * sizeof(APTR);
+    struct GIC_IntQueue *queue = AllocMem(bytes, MEMF_PUBLIC | MEMF_CLEAR);
+    if (!queue)
+    {
+        Kprintf("[gic] %s: Failed to allocate queue (%lu bytes)\n", __func__, bytes);
+        return NULL;
+    }
+
+    queue->mask = capacity - 1;
+    queue->task = task;
+    queue->signals = signalMask;
+    return (struct GICIntQueue *)queue;
+}
+
+/* DeleteIntQueue: Free a ring; the producer must no longer use it.
+ * Returns: 0 on success, negative GIC400_ERR_* on failure.
+ */
+LONG DeleteIntQueue(struct GICIntQueue *queue asm("a0"), struct GIC_Base *gicBase asm("a6"))
+{
+    GIC_MMIO_SCOPE(GIC400_STAT_QUEUE);
+    if (!gicBase)
+        return GIC400_ERR_NOT_READY;
+    if (!queue)
+        return GIC400_ERR_INVALID_ARGUMENT;
+
+    struct GIC_IntQueue *ring = (struct GIC_IntQueue *)queue;
+    FreeMem(ring, sizeof(struct GIC_IntQueue) + (ring->mask + 1) * sizeof(APTR));
+    return 0;
+}
+
+/* PutIntQueue: Append one item; called by the single producer, typically
+ * an interrupt server. The consumer is signalled only when the ring was
+ * empty, so a burst costs one Signal().
+ * Args: queue - ring; item - pointer handed over as is.
+ * Returns: 0 on success, GIC400_ERR_FULL when no slot is free.
+ */
+LONG PutIntQueue(struct GICIntQueue *queue asm("a0"), APTR item asm("a1"), struct GIC_Base *gicBase asm("a6"))
+{
+    GIC_MMIO_SCOPE(GIC400_STAT_QUEUE);
+    (void)gicBase;
+    struct GIC_IntQueue *ring = (struct GIC_IntQueue *)queue;
+    if (!ring)
+        return GIC400_ERR_INVALID_ARGUMENT;
+
+    u32 head = ring->head;
+    u32 tail = ring->tail;
+
+    if (head - tail > ring->mask)
+        return GIC400_ERR_FULL;
+
+    ring->slots[head & ring->mask] = item;
+    __asm__ __volatile__("" ::: "memory"); // publish only after the slot is written
+    ring->head = head + 1;
+
+    if (head == tail && ring->task)
+        Signal(ring->task, ring->signals);
+    return 0;
+}
+
+/* GetIntQueue: Take up to max items, oldest first; called by the single
+ * consumer. After a wakeup keep calling until it returns 0, items put
+ * while a batch was taken do not signal again.
+ * Args: queue - ring; items - destination; max - its size.
+ * Returns: number of items taken, or negative GIC400_ERR_* on failure.
+ */
+LONG GetIntQueue(struct GICIntQueue *queue asm("a0"), APTR *items asm("a1"), ULONG max asm("d0"), struct GIC_Base *gicBase asm("a6"))
+{
+    GIC_MMIO_SCOPE(GIC400_STAT_QUEUE);
+    (void)gicBase;
+    struct GIC_IntQueue *ring = (struct GIC_IntQueue *)queue;
+    if (!ring || !items)
+        return GIC400_ERR_INVALID_ARGUMENT;
+
+    u32 tail = ring->tail;
+    u32 count = ring->head - tail;
+    if (count > max)
+        count = max;
+
+    for (u32 i = 0; i < count; i++)
+        items[i] = ring->slots[(tail + i) & ring->mask];
+    __asm__ __volatile__("" ::: "memory"); // release the slots only after they are read
+    ring->tail = tail + count;
+
+    return (LONG)count;
+}
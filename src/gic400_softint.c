@@ -0,0 +1,106 @@
+// SPDX-License-Identifier: MPL-2.0 OR GPL-2.0+
+#include <gic400_private.h>
+
+/* gic400_find_free_spi: Pick an SPI nobody appears to use.
+ * Scans from the top of the SPI range down, one ISENABLER/ISPENDR word pair
+ * per 32 lines, skipping lines that have a server, are enabled or pending,
+ * or belong to a device-tree node.
+ * Returns: IRQ number, or 0 when every SPI is taken.
+ */
+static u32 gic400_find_free_spi(struct GIC_Base *gicBase)
+{
+    for (u32 reg_index = gicBase->max_irqs >> 5; reg_index-- > 1;)
+    {
+        u32 busy = gic_read32(GICD_ISENABLER(reg_index)) | gic_read32(GICD_ISPENDR(reg_index));
+        for (u32 bit = 32; bit-- > 0;)
+        {
+            u32 irq = (reg_index << 5) | bit;
+            if ((busy & ((u32)1 << bit)) == 0 && gicBase->handlers[irq] == NULL && !(gicBase->irq_flags[irq] & GIC_IRQF_DT))
+                return irq;
+        }
+    }
+    return 0;
+}
+
+/* AllocSoftInt: Hand out an unused SPI as a software interrupt channel.
+ * The line is configured edge-triggered at the given priority, routed to
+ * CPU0 and dispatched like any other server (D0 = IRQ, A1 = is_Data).
+ * Args: priority - GIC priority byte (0-0x7f); interrupt - server to call.
+ * Returns: allocated IRQ number, or negative GIC400_ERR_* on failure.
+ */
+LONG AllocSoftInt(UBYTE priority asm("d0"), struct Interrupt *interrupt asm("a1"), struct GIC_Base *gicBase asm("a6"))
+{
+    GIC_MMIO_SCOPE(GIC400_STAT_SOFTINT);
+    if (!gicBase)
+        return GIC400_ERR_NOT_READY;
+    if (!interrupt || !interrupt->is_Code)
+    {
+        Kprintf("[gic] %s: Invalid interrupt server\n", __func__);
+        return GIC400_ERR_INVALID_ARGUMENT;
+    }
+    s32 ret = gic400_ensure_live(gicBase);
+    if (ret < 0)
+        return ret;
+
+    ObtainSemaphore(&gicBase->semaphore);
+
+    u32 irq = gic400_find_free_spi(gicBase);
+    if (irq == 0)
+    {
+        ReleaseSemaphore(&gicBase->semaphore);
+        Kprintf("[gic] %s: No free SPI left\n", __func__);
+        return GIC400_ERR_NO_FREE_IRQ;
+    }
+
+    ret = gic400_add_server(gicBase, irq, priority, TRUE, interrupt);
+    if (ret == 0)
+        gicBase->irq_flags[irq] |= GIC_IRQF_SOFT;
+
+    ReleaseSemaphore(&gicBase->semaphore);
+
+    if (ret < 0)
+        return ret;
+
+    KprintfH("[gic] %s: SPI %ld allocated as software interrupt\n", __func__, irq);
+    return (LONG)irq;
+}
+
+/* FreeSoftInt: Release a line obtained from AllocSoftInt().
+ * Returns: 0 on success, negative GIC400_ERR_* on failure.
+ */
+LONG FreeSoftInt(ULONG irq asm("d0"), struct GIC_Base *gicBase asm("a6"))
+{
+    GIC_MMIO_SCOPE(GIC400_STAT_SOFTINT);
+    if (!gicBase)
+        return GIC400_ERR_NOT_READY;
+    if (!gicBase->live || irq >= gicBase->max_irqs || !(gicBase->irq_flags[irq] & GIC_IRQF_SOFT))
+    {
+        Kprintf("[gic] %s: IRQ %lu is not a software interrupt\n", __func__, irq);
+        return GIC400_ERR_INVALID_IRQ;
+    }
+
+    /* Drop a raise nobody will service before gic400_rem_server() decides
+     * whether the dispatcher is still needed. */
+    Disable();
+    gicd_disable_irq(gicBase, irq);
+    gicd_clear_pending(gicBase, irq);
+    Enable();
+
+    return gic400_rem_server(gicBase, irq, gicBase->handlers[irq]);
+}
+
+/* RaiseSoftInt: Trigger a software interrupt with a single ISPENDR write.
+ * Callable from any context, including interrupt servers.
+ * Returns: 0 on success, negative GIC400_ERR_* on failure.
+ */
+LONG RaiseSoftInt(ULONG irq asm("d0"), struct GIC_Base *gicBase asm("a6"))
+{
+    GIC_MMIO_SCOPE(GIC400_STAT_SOFTINT);
+    if (!gicBase)
+        return GIC400_ERR_NOT_READY;
+    if (!gicBase->live || irq >= gicBase->max_irqs || !(gicBase->irq_flags[irq] & GIC_IRQF_SOFT))
+        return GIC400_ERR_INVALID_IRQ;
+
+    gicd_set_pending(gicBase, irq);
+    return 0;
+}
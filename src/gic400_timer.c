@@ -0,0 +1,301 @@
+// SPDX-License-Identifier: MPL-2.0 OR GPL-2.0+
+#include <gic400_private.h>
+
+#define __NOLIBBASE__
+#include <devtree.h>
+
+static const char gic_timer_name[] = "ARM GIC-400 timer";
+static const char gic_timer_compatible[] = "brcm,bcm2835-system-timer";
+
+/* Compare channel owned by the timer service (1 and 3 are free for the ARM). */
+#define GIC400_TIMER_CHANNEL 3
+/* GIC priority of the compare interrupt; above typical device handlers. */
+#define GIC400_TIMER_PRIORITY 0x20
+/* A compare value closer than this to the counter may be missed. */
+#define GIC400_TIMER_MIN_DELTA 2
+/* Expiry passes per compare interrupt before the rest is left to a re-pend. */
+#define GIC400_TIMER_MAX_PASSES 4
+
+_Static_assert(GIC400_TIMER_MIN_PERIOD > GIC400_TIMER_MIN_DELTA, "GIC400_TIMER_MIN_PERIOD");
+
+/* gic400_timer_init: Locate the system timer and its compare interrupt.
+ * A missing timer is not fatal; the timer service then reports
+ * GIC400_ERR_NOT_SUPPORTED.
+ * Returns: 0 on success, negative GIC400_ERR_* on failure.
+ */
+s32 gic400_timer_init(struct GIC_Base *gicBase)
+{
+    gicBase->timers.mlh_Head = (struct MinNode *)&gicBase->timers.mlh_Tail;
+    gicBase->timers.mlh_Tail = NULL;
+    gicBase->timers.mlh_TailPred = (struct MinNode *)&gicBase->timers.mlh_Head;
+    gicBase->systimer_base = NULL;
+    gicBase->timer_installed = FALSE;
+
+    /* One GIC specifier per compare channel, decoded by the DT index */
+    const struct GIC_DTInt *entry = gic400_dt_find(gicBase, (CONST_STRPTR)gic_timer_compatible, GIC400_TIMER_CHANNEL);
+    if (entry == NULL)
+    {
+        Kprintf("[gic] %s: No %s interrupt for channel %ld, timer service unavailable\n", __func__, gic_timer_compatible, (LONG)GIC400_TIMER_CHANNEL);
+        return GIC400_ERR_NOT_SUPPORTED;
+    }
+    u32 irq = entry->irq;
+
+    APTR DeviceTreeBase = OpenResource((CONST_STRPTR) "devicetree.resource");
+    if (DeviceTreeBase == NULL)
+    {
+        Kprintf("[gic] %s: Failed to open devicetree.resource\n", __func__);
+        return GIC400_ERR_DEVTREE;
+    }
+
+    APTR parent_key = DT_GetParent(entry->key);
+    const u32 address_cells = DT_GetPropertyValueULONG(parent_key, "#address-cells", 1, FALSE);
+    const u32 *reg = DT_GetPropValue(DT_FindProperty(entry->key, (CONST_STRPTR) "reg"));
+    APTR base = reg ? (APTR)(ULONG)DT_GetNumber(reg, address_cells) : NULL;
+    if (base != NULL)
+        DT_TranslateAddress(&base, parent_key);
+
+    if (base == NULL || irq >= gicBase->max_irqs)
+    {
+        Kprintf("[gic] %s: Failed to get system timer base or IRQ (%lu)\n", __func__, irq);
+        return GIC400_ERR_DEVTREE;
+    }
+
+    gicBase->systimer_base = base;
+    gicBase->timer_irq = irq;
+    gicBase->timer_channel = GIC400_TIMER_CHANNEL;
+
+    KprintfH("[gic] %s: System timer at %08lx, channel %ld on IRQ %ld\n", __func__, base, (LONG)GIC400_TIMER_CHANNEL, irq);
+    return 0;
+}
+
+/* gic400_timer_insert: Link timer into the deadline-sorted list.
+ * Must be called with interrupts disabled.
+ * Returns: TRUE when the timer became the earliest one.
+ */
+static BOOL gic400_timer_insert(struct GIC_Base *gicBase, struct GICTimer *timer)
+{
+    struct MinNode *pred = NULL;
+    for (struct MinNode *node = gicBase->timers.mlh_Head; node->mln_Succ != NULL; node = node->mln_Succ)
+    {
+        struct GICTimer *other = (struct GICTimer *)node;
+        if ((LONG)(other->deadline - timer->deadline) > 0)
+            break;
+        pred = node;
+    }
+
+    Insert((struct List *)&gicBase->timers, (struct Node *)&timer->node, (struct Node *)pred);
+    timer->armed = TRUE;
+    return pred == NULL;
+}
+
+/* gic400_timer_run: Fire every expired timer and program the next compare.
+ * Runs at interrupt level from the timer server. When servers keep running
+ * past the next deadline, the pass count is bounded: the timer IRQ is set
+ * pending instead, so the rest is handled after the dispatcher has had a
+ * chance to take more urgent IRQs.
+ */
+static void gic400_timer_run(struct GIC_Base *gicBase)
+{
+    for (u32 pass = 0;; pass++)
+    {
+        if (pass == GIC400_TIMER_MAX_PASSES)
+        {
+            gicd_set_pending(gicBase, gicBase->timer_irq);
+            return;
+        }
+
+        u32 now = gic400_timer_now();
+        struct GICTimer *timer = (struct GICTimer *)gicBase->timers.mlh_Head;
+
+        while (timer->node.mln_Succ != NULL && (LONG)(timer->deadline - now) <= 0)
+        {
+            u32 expired = timer->deadline;
+
+            Remove((struct Node *)&timer->node);
+            timer->armed = FALSE;
+            if (timer->period)
+            {
+                timer->deadline += timer->period;
+                if ((LONG)(timer->deadline - now) <= 0)
+                    timer->deadline = now + timer->period; // overrun: skip missed periods
+                gic400_timer_insert(gicBase, timer);
+            }
+
+            gic400_call_interrupt(timer->interrupt, expired);
+            timer = (struct GICTimer *)gicBase->timers.mlh_Head;
+        }
+
+        if (timer->node.mln_Succ == NULL)
+            return;
+
+        gic_write32(timer->deadline, SYSTIMER_C(gicBase->timer_channel));
+
+        /* The compare only matches on equality; make sure we did not program
+         * a value the counter has already passed. */
+        now = gic400_timer_now();
+        if ((LONG)(timer->deadline - now) >= GIC400_TIMER_MIN_DELTA)
+            return;
+    }
+}
+
+/* gic400_timer_server: Handler for the system timer compare interrupt.
+ * Args: gicBase - library base (is_Data).
+ */
+static ULONG gic400_timer_server(register struct GIC_Base *gicBase asm("a1"))
+{
+    gic_write32(1u << gicBase->timer_channel, SYSTIMER_CS); // acknowledge the match
+    gic400_timer_run(gicBase);
+    return 0;
+}
+
+/* gic400_timer_install: Register the compare interrupt on first use. */
+static s32 gic400_timer_install(struct GIC_Base *gicBase)
+{
+    if (gicBase->timer_installed)
+        return 0;
+
+    gicBase->timer_interrupt.is_Node.ln_Type = NT_INTERRUPT;
+    gicBase->timer_interrupt.is_Node.ln_Pri = 0;
+    gicBase->timer_interrupt.is_Node.ln_Name = (char *)gic_timer_name;
+    gicBase->timer_interrupt.is_Data = gicBase;
+    gicBase->timer_interrupt.is_Code = (APTR)gic400_timer_server;
+
+    gic_write32(1u << gicBase->timer_channel, SYSTIMER_CS); // drop any stale match
+    s32 ret = gic400_add_server(gicBase, gicBase->timer_irq, GIC400_TIMER_PRIORITY, FALSE, &gicBase->timer_interrupt);
+    if (ret < 0)
+        return ret;
+
+    gicBase->timer_installed = TRUE;
+    return 0;
+}
+
+/* gic400_timer_shutdown: Disarm all timers and remove the compare interrupt. */
+void gic400_timer_shutdown(struct GIC_Base *gicBase)
+{
+    if (!gicBase->timer_installed)
+        return;
+
+    Disable();
+    while (gicBase->timers.mlh_Head->mln_Succ != NULL)
+    {
+        struct GICTimer *timer = (struct GICTimer *)gicBase->timers.mlh_Head;
+        Remove((struct Node *)&timer->node);
+        timer->armed = FALSE;
+        Kprintf("[gic] warning: disarmed timer %08lx during shutdown\n", timer);
+    }
+    Enable();
+
+    gic400_rem_server(gicBase, gicBase->timer_irq, &gicBase->timer_interrupt);
+    gicBase->timer_installed = FALSE;
+}
+
+/* StartTimer: Arm (or re-arm) a high-resolution timer.
+ * The first call must come from a task, as it registers the timer interrupt.
+ * Args:
+ *  timer - caller-owned timer with interrupt set
+ *  delay - ticks until the first expiry
+ *  period - ticks between later expiries, 0 for a one-shot timer, else at
+ *   least GIC400_TIMER_MIN_PERIOD
+ * Returns: 0 on success, negative GIC400_ERR_* on failure.
+ */
+LONG StartTimer(struct GICTimer *timer asm("a0"), ULONG delay asm("d0"), ULONG period asm("d1"), struct GIC_Base *gicBase asm("a6"))
+{
+    GIC_MMIO_SCOPE(GIC400_STAT_TIMER);
+    if (!gicBase)
+        return GIC400_ERR_NOT_READY;
+    if (!timer || !timer->interrupt || !timer->interrupt->is_Code)
+    {
+        Kprintf("[gic] %s: Invalid timer %08lx\n", __func__, timer);
+        return GIC400_ERR_INVALID_ARGUMENT;
+    }
+    if (period != 0 && period < GIC400_TIMER_MIN_PERIOD)
+    {
+        Kprintf("[gic] %s: Period %lu below %lu ticks\n", __func__, period, (ULONG)GIC400_TIMER_MIN_PERIOD);
+        return GIC400_ERR_INVALID_ARGUMENT;
+    }
+    s32 ret = gic400_ensure_live(gicBase);
+    if (ret < 0)
+        return ret;
+    if (!gicBase->systimer_base)
+        return GIC400_ERR_NOT_SUPPORTED;
+
+    ret = gic400_timer_install(gicBase);
+    if (ret < 0)
+        return ret;
+
+    Disable();
+
+    if (timer->armed)
+        Remove((struct Node *)&timer->node);
+
+    u32 now = gic400_timer_now();
+    timer->deadline = now + delay;
+    timer->period = period;
+    if (gic400_timer_insert(gicBase, timer))
+    {
+        if (delay >= GIC400_TIMER_MIN_DELTA)
+        {
+            gic_write32(timer->deadline, SYSTIMER_C(gicBase->timer_channel));
+            now = gic400_timer_now(); // as in gic400_timer_run(): the counter may have passed it meanwhile
+        }
+        if ((LONG)(timer->deadline - now) < GIC400_TIMER_MIN_DELTA)
+            gicd_set_pending(gicBase, gicBase->timer_irq); // already due, let the server run it
+    }
+
+    Enable();
+    return 0;
+}
+
+/* StopTimer: Disarm a timer armed by StartTimer().
+ * Returns: 0 on success, GIC400_ERR_NOT_FOUND when the timer is not armed.
+ */
+LONG StopTimer(struct GICTimer *timer asm("a0"), struct GIC_Base *gicBase asm("a6"))
+{
+    GIC_MMIO_SCOPE(GIC400_STAT_TIMER);
+    if (!gicBase)
+        return GIC400_ERR_NOT_READY;
+    if (!timer)
+        return GIC400_ERR_INVALID_ARGUMENT;
+
+    Disable();
+    if (!timer->armed)
+    {
+        Enable();
+        return GIC400_ERR_NOT_FOUND;
+    }
+
+    /* A stale compare may still fire; the server then finds nothing due. */
+    Remove((struct Node *)&timer->node);
+    timer->armed = FALSE;
+    Enable();
+    return 0;
+}
+
+/* ReadTimerCounter: Read the 64-bit timer counter.
+ * Args: high/low - optional outputs for the upper and lower 32 bits.
+ * Returns: 0 on success, negative GIC400_ERR_* on failure.
+ */
+LONG ReadTimerCounter(ULONG *high asm("a0"), ULONG *low asm("a1"), struct GIC_Base *gicBase asm("a6"))
+{
+    GIC_MMIO_SCOPE(GIC400_STAT_TIMER);
+    if (!gicBase)
+        return GIC400_ERR_NOT_READY;
+    LONG ret = gic400_ensure_live(gicBase);
+    if (ret < 0)
+        return ret;
+    if (!gicBase->systimer_base)
+        return GIC400_ERR_NOT_SUPPORTED;
+
+    u32 hi, lo;
+    do
+    {
+        hi = gic_read32(SYSTIMER_CHI);
+        lo = gic_read32(SYSTIMER_CLO);
+    } while (hi != gic_read32(SYSTIMER_CHI));
+
+    if (high)
+        *high = hi;
+    if (low)
+        *low = lo;
+    return 0;
+}
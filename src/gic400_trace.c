@@ -0,0 +1,141 @@
+// SPDX-License-Identifier: MPL-2.0 OR GPL-2.0+
+#include <exec/memory.h>
+#include <gic400_private.h>
+
+/* gic400_trace_record: Append one dispatch to the trace (GIC_HOOK_TRACE).
+ * Called from the dispatcher after the server returned and before EOI.
+ * Args: irq - acknowledged IRQ; arrival - timer value taken after GICC_IAR;
+ *  handled - FALSE when no server was registered.
+ * Returns: void.
+ */
+void gic400_trace_record(struct GIC_Base *gicBase, u32 irq, u32 arrival, BOOL handled)
+{
+    u32 count = gicBase->trace_count;
+    if (count >= gicBase->trace_size)
+    {
+        gicBase->trace_dropped++;
+        return;
+    }
+
+    struct GICTraceRecord *record = &gicBase->trace_buffer[count];
+    record->arrival = arrival;
+    record->duration = gic400_timer_now() - arrival;
+    record->irq = (UWORD)irq;
+    record->flags = handled ? 0 : GIC400_TRACE_UNHANDLED;
+    gicBase->trace_count = count + 1;
+}
+
+/* StartIntTrace: Record every dispatched IRQ until the buffer is full.
+ * The buffer is allocated here, so recording never allocates; records are
+ * kept until the next StartIntTrace() or library expunge. While tracing,
+ * the assembly dispatcher hands every IRQ to the C path.
+ * Args: records - buffer size in records (1-GIC400_TRACE_MAX).
+ * Returns: 0 on success, negative GIC400_ERR_* on failure.
+ */
+LONG StartIntTrace(ULONG records asm("d0"), struct GIC_Base *gicBase asm("a6"))
+{
+    GIC_MMIO_SCOPE(GIC400_STAT_TRACE);
+    if (!gicBase)
+        return GIC400_ERR_NOT_READY;
+    if (records == 0 || records > GIC400_TRACE_MAX)
+        return GIC400_ERR_INVALID_ARGUMENT;
+    LONG ret = gic400_ensure_live(gicBase);
+    if (ret < 0)
+        return ret;
+    if (!gicBase->systimer_base)
+        return GIC400_ERR_NOT_SUPPORTED;
+
+    ObtainSemaphore(&gicBase->semaphore);
+
+    if (gicBase->dispatch.hooks & GIC_HOOK_TRACE)
+    {
+        ReleaseSemaphore(&gicBase->semaphore);
+        return GIC400_ERR_BUSY;
+    }
+
+    if (gicBase->trace_buffer && gicBase->trace_size != records)
+    {
+        FreeMem(gicBase->trace_buffer, gicBase->trace_size * sizeof(struct GICTraceRecord));
+        gicBase->trace_buffer = NULL;
+    }
+    if (!gicBase->trace_buffer)
+    {
+        u32 bytes = records * sizeof(struct GICTraceRecord);
+        gicBase->trace_buffer = AllocMem(bytes, MEMF_CLEAR);
+        if (!gicBase->trace_buffer)
+        {
+            ReleaseSemaphore(&gicBase->semaphore);
+            Kprintf("[gic] %s: Failed to allocate trace buffer (%lu bytes)\n", __func__, bytes);
+            return GIC400_ERR_NO_MEMORY;
+        }
+        gicBase->trace_size = records;
+    }
+
+    Disable();
+    gicBase->trace_count = 0;
+    gicBase->trace_dropped = 0;
+    gicBase->dispatch.hooks |= GIC_HOOK_TRACE;
+    Enable();
+
+    ReleaseSemaphore(&gicBase->semaphore);
+    return 0;
+}
+
+/* StopIntTrace: Stop recording; the records stay available to ReadIntTrace().
+ * Args: dropped - optional output for dispatches lost to a full buffer.
+ * Returns: number of records, or negative GIC400_ERR_* on failure.
+ */
+LONG StopIntTrace(ULONG *dropped asm("a0"), struct GIC_Base *gicBase asm("a6"))
+{
+    GIC_MMIO_SCOPE(GIC400_STAT_TRACE);
+    if (!gicBase)
+        return GIC400_ERR_NOT_READY;
+
+    Disable();
+    gicBase->dispatch.hooks &= ~GIC_HOOK_TRACE;
+    Enable();
+
+    if (dropped)
+        *dropped = gicBase->trace_dropped;
+    return (LONG)gicBase->trace_count;
+}
+
+/* ReadIntTrace: Copy records out, oldest first.
+ * May be called while tracing; only records complete at the time of the
+ * call are copied.
+ * Args: buffer - destination; max - its size in records.
+ * Returns: number of records copied, or negative GIC400_ERR_* on failure.
+ */
+LONG ReadIntTrace(struct GICTraceRecord *buffer asm("a0"), ULONG max asm("d0"), struct GIC_Base *gicBase asm("a6"))
+{
+    GIC_MMIO_SCOPE(GIC400_STAT_TRACE);
+    if (!gicBase)
+        return GIC400_ERR_NOT_READY;
+    if (!buffer)
+        return GIC400_ERR_INVALID_ARGUMENT;
+
+    ObtainSemaphore(&gicBase->semaphore);
+
+    u32 count = gicBase->trace_count;
+    if (count > max)
+        count = max;
+    for (u32 i = 0; i < count; i++)
+        buffer[i] = gicBase->trace_buffer[i];
+
+    ReleaseSemaphore(&gicBase->semaphore);
+    return (LONG)count;
+}
+
+/* gic400_trace_shutdown: Stop recording and free the trace buffer. */
+void gic400_trace_shutdown(struct GIC_Base *gicBase)
+{
+    Disable();
+    gicBase->dispatch.hooks &= ~GIC_HOOK_TRACE;
+    Enable();
+
+    if (gicBase->trace_buffer)
+    {
+        FreeMem(gicBase->trace_buffer, gicBase->trace_size * sizeof(struct GICTraceRecord));
+        gicBase->trace_buffer = NULL;
+    }
+}
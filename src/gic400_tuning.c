@@ -0,0 +1,391 @@
+// SPDX-License-Identifier: MPL-2.0 OR GPL-2.0+
+#include <exec/memory.h>
+#include <exec/tasks.h>
+#include <gic400_private.h>
+
+#define __NOLIBBASE__
+#include <proto/dos.h>
+
+/* Largest profile read, and longest node path or compatible string. */
+#define GIC400_TUNING_MAX_FILE 16384
+#define GIC400_TUNING_MAX_NAME 128
+
+/* gic400_tune_space: Check for a blank within a line. */
+static inline BOOL gic400_tune_space(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+/* gic400_tune_word: Compare a token against a keyword.
+ * Returns: TRUE when the len characters at token are exactly word.
+ */
+static BOOL gic400_tune_word(const char *token, u32 len, const char *word)
+{
+    u32 i = 0;
+    for (; i < len && word[i]; i++)
+    {
+        if (token[i] != word[i])
+            return FALSE;
+    }
+    return i == len && word[i] == '\0';
+}
+
+/* gic400_tune_number: Parse a decimal or 0x-prefixed hexadecimal number.
+ * Args: token/len - characters to parse; value - output.
+ * Returns: TRUE when all len characters formed a number.
+ */
+static BOOL gic400_tune_number(const char *token, u32 len, u32 *value)
+{
+    u32 base = 10;
+    u32 result = 0;
+    u32 i = 0;
+
+    if (len > 2 && token[0] == '0' && (token[1] == 'x' || token[1] == 'X'))
+    {
+        base = 16;
+        i = 2;
+    }
+    if (i == len)
+        return FALSE;
+
+    for (; i < len; i++)
+    {
+        char c = token[i];
+        u32 digit;
+        if (c >= '0' && c <= '9')
+            digit = (u32)(c - '0');
+        else if (base == 16 && c >= 'a' && c <= 'f')
+            digit = (u32)(c - 'a' + 10);
+        else if (base == 16 && c >= 'A' && c <= 'F')
+            digit = (u32)(c - 'A' + 10);
+        else
+            return FALSE;
+        result = result * base + digit;
+    }
+
+    *value = result;
+    return TRUE;
+}
+
+/* gic400_tune_irq: Resolve the key of a profile line to an IRQ.
+ * Args: token/len - IRQ number, or node path / compatible string with an
+ *  optional ":<index>".
+ * Returns: IRQ number, or negative GIC400_ERR_* when it names none.
+ */
+static s32 gic400_tune_irq(struct GIC_Base *gicBase, const char *token, u32 len)
+{
+    u32 irq;
+    if (gic400_tune_number(token, len, &irq))
+        return irq < gicBase->max_irqs ? (s32)irq : GIC400_ERR_INVALID_IRQ;
+
+    u32 index = 0;
+    u32 name_len = len;
+    for (u32 i = len; i-- > 0;)
+    {
+        if (token[i] == ':')
+        {
+            if (!gic400_tune_number(token + i + 1, len - i - 1, &index))
+                return GIC400_ERR_INVALID_ARGUMENT;
+            name_len = i;
+            break;
+        }
+    }
+    if (name_len == 0 || name_len >= GIC400_TUNING_MAX_NAME)
+        return GIC400_ERR_INVALID_ARGUMENT;
+
+    char name[GIC400_TUNING_MAX_NAME];
+    for (u32 i = 0; i < name_len; i++)
+        name[i] = token[i];
+    name[name_len] = '\0';
+
+    const struct GIC_DTInt *entry = gic400_dt_find(gicBase, (CONST_STRPTR)name, index);
+    return entry ? (s32)entry->irq : GIC400_ERR_NOT_FOUND;
+}
+
+/* gic400_tune_line: Parse one profile line into the tuning table.
+ * Args: line/len - the line without its newline; number - for messages;
+ *  table - max_irqs entries.
+ * Returns: 1 when an IRQ was tuned, 0 for a blank or comment line,
+ *  negative GIC400_ERR_* for a malformed one.
+ */
+static s32 gic400_tune_line(struct GIC_Base *gicBase, const char *line, u32 len, u32 number, struct GIC_StagedInt *table)
+{
+    u32 pos = 0;
+    while (pos < len && gic400_tune_space(line[pos]))
+        pos++;
+    if (pos == len || line[pos] == '#' || line[pos] == ';')
+        return 0;
+
+    u32 start = pos;
+    while (pos < len && !gic400_tune_space(line[pos]))
+        pos++;
+    s32 irq = gic400_tune_irq(gicBase, line + start, pos - start);
+    if (irq < 0)
+    {
+        Kprintf("[gic] %s: line %lu: no such IRQ\n", __func__, number);
+        return irq;
+    }
+
+    struct GIC_StagedInt tune = {0, 0, 0, 0};
+    for (;;)
+    {
+        while (pos < len && gic400_tune_space(line[pos]))
+            pos++;
+        if (pos == len || line[pos] == '#')
+            break;
+
+        const char *key = line + pos;
+        u32 key_len = 0;
+        while (pos < len && !gic400_tune_space(line[pos]) && line[pos] != '=')
+        {
+            pos++;
+            key_len++;
+        }
+        if (pos == len || line[pos] != '=')
+        {
+            Kprintf("[gic] %s: line %lu: expected key=value\n", __func__, number);
+            return GIC400_ERR_INVALID_ARGUMENT;
+        }
+        pos++;
+
+        const char *value = line + pos;
+        u32 value_len = 0;
+        while (pos < len && !gic400_tune_space(line[pos]))
+        {
+            pos++;
+            value_len++;
+        }
+
+        u32 n;
+        if (gic400_tune_word(key, key_len, "priority") && gic400_tune_number(value, value_len, &n) && n <= 0xFF)
+        {
+            tune.flags |= GIC400_CFGF_PRIORITY;
+            tune.priority = (u8)n;
+        }
+        else if (gic400_tune_word(key, key_len, "trigger") && gic400_tune_word(value, value_len, "edge"))
+        {
+            tune.flags |= GIC400_CFGF_TRIGGER;
+            tune.state |= GIC_STAGED_EDGE;
+        }
+        else if (gic400_tune_word(key, key_len, "trigger") && gic400_tune_word(value, value_len, "level") && irq >= 16)
+        {
+            tune.flags |= GIC400_CFGF_TRIGGER;
+            tune.state &= (u8)~GIC_STAGED_EDGE;
+        }
+        else if (gic400_tune_word(key, key_len, "targets") && gic400_tune_number(value, value_len, &n) && n != 0 && n <= 0xFF && irq >= 32)
+        {
+            tune.flags |= GIC400_CFGF_TARGETS;
+            tune.targets = (u8)n;
+        }
+        else
+        {
+            Kprintf("[gic] %s: line %lu: bad setting\n", __func__, number);
+            return GIC400_ERR_INVALID_ARGUMENT;
+        }
+    }
+
+    if (tune.flags == 0)
+        return 0;
+    table[irq] = tune;
+    return 1;
+}
+
+/* gic400_tune_read: Read a whole profile file.
+ * Args: DOSBase - open dos.library; path - file; size - output byte count.
+ * Returns: buffer (free with size + 1 bytes), or NULL on failure.
+ */
+static char *gic400_tune_read(struct Library *DOSBase, CONST_STRPTR path, u32 *size)
+{
+    BPTR file = Open(path, MODE_OLDFILE);
+    if (!file)
+        return NULL;
+
+    Seek(file, 0, OFFSET_END);
+    LONG length = Seek(file, 0, OFFSET_BEGINNING);
+    if (length <= 0 || length > GIC400_TUNING_MAX_FILE)
+    {
+        Close(file);
+        return NULL;
+    }
+
+    char *buffer = AllocMem((ULONG)length + 1, MEMF_ANY);
+    if (buffer && Read(file, buffer, length) != length)
+    {
+        FreeMem(buffer, (ULONG)length + 1);
+        buffer = NULL;
+    }
+    Close(file);
+
+    if (buffer)
+    {
+        buffer[length] = '\0';
+        *size = (u32)length;
+    }
+    return buffer;
+}
+
+/* gic400_tune_apply: Push every tuned IRQ to the GIC in one transaction.
+ * Enable state is not staged, so lines stay as they are.
+ * Returns: number of IRQs configured, or negative GIC400_ERR_* on failure.
+ */
+static LONG gic400_tune_apply(struct GIC_Base *gicBase)
+{
+    LONG ret = BeginIntConfig(gicBase);
+    if (ret < 0)
+        return ret;
+
+    for (u32 irq = 0; irq < gicBase->max_irqs; irq++)
+    {
+        const struct GIC_StagedInt *tune = &gicBase->tuning[irq];
+        if (tune->flags == 0)
+            continue;
+
+        struct GICIntSetting setting;
+        setting.irq = irq;
+        setting.flags = tune->flags;
+        setting.priority = tune->priority;
+        setting.cpuMask = tune->targets;
+        setting.edge = (tune->state & GIC_STAGED_EDGE) != 0;
+        setting.enable = FALSE;
+        ret = StageIntConfig(&setting, gicBase);
+        if (ret < 0)
+        {
+            AbortIntConfig(gicBase);
+            return ret;
+        }
+    }
+
+    return CommitIntConfig(gicBase);
+}
+
+/* gic400_tune_fetch: Read a profile file through dos.library.
+ * Args: path - file, NULL for GIC400_TUNING_FILE; text/size - output buffer
+ *  (free with size + 1 bytes) and its length.
+ * Returns: 0 on success, negative GIC400_ERR_* on failure.
+ */
+static LONG gic400_tune_fetch(CONST_STRPTR path, char **text, u32 *size)
+{
+    if (FindTask(NULL)->tc_Node.ln_Type != NT_PROCESS)
+        return GIC400_ERR_NOT_SUPPORTED;
+
+    struct Library *DOSBase = OpenLibrary((CONST_STRPTR) "dos.library", 36);
+    if (!DOSBase)
+        return GIC400_ERR_NOT_SUPPORTED;
+
+    *text = gic400_tune_read(DOSBase, path ? path : (CONST_STRPTR)GIC400_TUNING_FILE, size);
+    CloseLibrary(DOSBase);
+    return *text ? 0 : GIC400_ERR_NOT_FOUND;
+}
+
+/* gic400_tune_load: Parse a profile and make it the current one.
+ * Needs the device-tree index, so only runs once the controller is up.
+ * Args: text/size - profile read by gic400_tune_fetch(), freed here.
+ * Returns: number of IRQs tuned, or negative GIC400_ERR_* on failure.
+ */
+static LONG gic400_tune_load(struct GIC_Base *gicBase, char *text, u32 size)
+{
+    u32 bytes = gicBase->max_irqs * sizeof(struct GIC_StagedInt);
+    struct GIC_StagedInt *table = AllocMem(bytes, MEMF_PUBLIC | MEMF_CLEAR);
+    if (!table)
+    {
+        FreeMem(text, size + 1);
+        Kprintf("[gic] %s: Failed to allocate tuning table (%lu bytes)\n", __func__, bytes);
+        return GIC400_ERR_NO_MEMORY;
+    }
+
+    LONG tuned = 0;
+    u32 number = 1;
+    for (u32 pos = 0; pos < size && tuned >= 0; number++)
+    {
+        u32 end = pos;
+        while (end < size && text[end] != '\n')
+            end++;
+
+        s32 ret = gic400_tune_line(gicBase, text + pos, end - pos, number, table);
+        if (ret < 0)
+            tuned = ret;
+        else
+            tuned += ret;
+        pos = end + 1;
+    }
+    FreeMem(text, size + 1);
+
+    if (tuned < 0)
+    {
+        FreeMem(table, bytes);
+        return tuned;
+    }
+
+    ObtainSemaphore(&gicBase->semaphore);
+    struct GIC_StagedInt *old = gicBase->tuning;
+    Disable();
+    gicBase->tuning = table;
+    Enable();
+    if (old)
+        FreeMem(old, bytes);
+
+    LONG ret = gic400_tune_apply(gicBase);
+    ReleaseSemaphore(&gicBase->semaphore);
+    if (ret < 0)
+        return ret;
+
+    KprintfH("[gic] %s: %ld IRQs tuned\n", __func__, tuned);
+    return tuned;
+}
+
+/* LoadIntTuning: Read an IRQ tuning profile and apply it.
+ * The whole profile is parsed before anything changes; on success it
+ * replaces the previous one, its settings are written to the GIC in one
+ * configuration transaction and later server registrations use them in
+ * place of the driver's values. Must be called from a process.
+ * Args: path - profile file, NULL for GIC400_TUNING_FILE.
+ * Returns: number of IRQs tuned, or negative GIC400_ERR_* on failure.
+ */
+LONG LoadIntTuning(CONST_STRPTR path asm("a0"), struct GIC_Base *gicBase asm("a6"))
+{
+    GIC_MMIO_SCOPE(GIC400_STAT_TUNING);
+    if (!gicBase)
+        return GIC400_ERR_NOT_READY;
+
+    char *text = NULL;
+    u32 size = 0;
+    LONG ret = gic400_tune_fetch(path, &text, &size);
+    if (ret < 0)
+        return ret;
+
+    ret = gic400_ensure_live(gicBase);
+    if (ret < 0)
+    {
+        FreeMem(text, size + 1);
+        return ret;
+    }
+
+    return gic400_tune_load(gicBase, text, size);
+}
+
+/* gic400_tuning_start: Read and apply GIC400_TUNING_FILE if there is one.
+ * Called at the end of bring-up, with the library semaphore held. The file
+ * is only read when bring-up runs in a process; otherwise (and for a
+ * ROM-resident instance) the profile must be loaded with LoadIntTuning().
+ */
+void gic400_tuning_start(struct GIC_Base *gicBase)
+{
+    char *text = NULL;
+    u32 size = 0;
+    if (gic400_tune_fetch(NULL, &text, &size) < 0)
+        return;
+
+    LONG ret = gic400_tune_load(gicBase, text, size);
+    if (ret < 0)
+        Kprintf("[gic] %s: Ignoring %s (%ld)\n", __func__, GIC400_TUNING_FILE, ret);
+}
+
+/* gic400_tuning_shutdown: Free the tuning table. */
+void gic400_tuning_shutdown(struct GIC_Base *gicBase)
+{
+    if (gicBase->tuning)
+    {
+        FreeMem(gicBase->tuning, gicBase->max_irqs * sizeof(struct GIC_StagedInt));
+        gicBase->tuning = NULL;
+    }
+}
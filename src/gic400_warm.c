@@ -0,0 +1,194 @@
+// SPDX-License-Identifier: MPL-2.0 OR GPL-2.0+
+#include <exec/memory.h>
+#include <exec/semaphores.h>
+#include <gic400_private.h>
+
+/* Register words kept per record: IPRIORITYR and ITARGETSR (four IRQs per
+ * word) and ICFGR (sixteen IRQs per word).
+ */
+#define GIC_WARM_WORDS(max_irqs) ((max_irqs) / 4 + (max_irqs) / 4 + (max_irqs) / 16)
+#define GIC_WARM_SIZE(max_irqs) (sizeof(struct GIC_WarmRecord) + GIC_WARM_WORDS(max_irqs) * sizeof(u32))
+
+/* gic400_warm_checksum: Checksum everything after the checksum field.
+ * Returns: rotate-and-add sum of the words.
+ */
+static u32 gic400_warm_checksum(const struct GIC_WarmRecord *record)
+{
+    const u32 *word = (const u32 *)(&record->checksum + 1);
+    const u32 *end = (const u32 *)((const u8 *)record + record->size);
+    u32 sum = GIC_WARM_MAGIC;
+
+    for (; word < end; word++)
+        sum = ((sum << 5) | (sum >> 27)) + *word;
+    return sum;
+}
+
+/* gic400_warm_take: Unlink the published record, if any.
+ * Returns: record, now owned by the caller, or NULL.
+ */
+static struct GIC_WarmRecord *gic400_warm_take(void)
+{
+    Forbid();
+    struct GIC_WarmRecord *record = (struct GIC_WarmRecord *)FindSemaphore((CONST_STRPTR)GIC_WARM_NAME);
+    if (record)
+        RemSemaphore(&record->semaphore);
+    Permit();
+    return record;
+}
+
+/* gic400_warm_restore: Accept a warm-restart record at discovery.
+ * The record must be intact and the controller at the recorded bases must
+ * still report the recorded IIDR/TYPER values. An accepted record replaces
+ * the device-tree lookup and is kept for gic400_warm_apply(); a rejected
+ * one is freed.
+ * Returns: TRUE when the controller was found through a record.
+ */
+BOOL gic400_warm_restore(struct GIC_Base *gicBase)
+{
+    struct GIC_WarmRecord *record = gic400_warm_take();
+    if (!record)
+        return FALSE;
+
+    BOOL valid = record->magic == GIC_WARM_MAGIC && record->version == GIC_WARM_VERSION;
+    u32 max_irqs = (GICD_TYPER_IT_LINES_NUMBER(record->gicd_typer) + 1) * 32;
+    if (valid)
+        valid = record->size == GIC_WARM_SIZE(max_irqs) && record->checksum == gic400_warm_checksum(record);
+
+    if (valid)
+    {
+        gicBase->gic_base_distributor = record->gic_base_distributor;
+        gicBase->gic_base_cpuif = record->gic_base_cpuif;
+        valid = gic_read32(GICD_IIDR) == record->gicd_iidr &&
+                gic_read32(GICD_TYPER) == record->gicd_typer &&
+                gic_read32(GICC_IIDR) == record->gicc_iidr;
+    }
+
+    if (!valid)
+    {
+        Kprintf("[gic] %s: Ignoring stale warm-restart record\n", __func__);
+        gicBase->gic_base_distributor = NULL;
+        gicBase->gic_base_cpuif = NULL;
+        FreeMem(record, record->magic == GIC_WARM_MAGIC ? record->size : sizeof(struct GIC_WarmRecord));
+        return FALSE;
+    }
+
+    gicBase->dt_gic_phandle = record->dt_gic_phandle;
+    gicBase->warm_record = record;
+    return TRUE;
+}
+
+/* gic400_warm_apply: Write back the accepted record at bring-up.
+ * The saved priority, target and trigger words are written with the
+ * distributor off, which replaces the SPI reset of gic400_ensure_live().
+ * Returns: void.
+ */
+void gic400_warm_apply(struct GIC_Base *gicBase)
+{
+    struct GIC_WarmRecord *record = gicBase->warm_record;
+    u32 max_irqs = gicBase->max_irqs;
+    const u32 *priority = record->regs;
+    const u32 *targets = priority + max_irqs / 4;
+    const u32 *icfgr = targets + max_irqs / 4;
+
+    Disable();
+    for (u32 reg_index = 0; reg_index < max_irqs / 4; reg_index++)
+    {
+        gic_write32(priority[reg_index], GICD_IPRIORITYR(reg_index));
+        if (reg_index >= 32 / 4) // SGI/PPI targets are read-only
+            gic_write32(targets[reg_index], GICD_ITARGETSR(reg_index));
+    }
+    for (u32 reg_index = 1; reg_index < max_irqs / 16; reg_index++) // ICFGR0 (SGIs) is read-only
+        gic_write32(icfgr[reg_index], GICD_ICFGR(reg_index));
+    Enable();
+
+    gicBase->warm_record = NULL;
+    FreeMem(record, record->size);
+    Kprintf("[gic] %s: Controller restored from warm-restart record\n", __func__);
+}
+
+/* gic400_warm_save: Publish the controller state for the next LibInit().
+ * Called from gic400_shutdown() before servers are stripped, so priorities,
+ * targets and trigger modes are recorded as the drivers left them. Does
+ * nothing unless SetWarmRestart() is on. A library that was never brought
+ * up passes on the record it accepted, if any, as the controller still
+ * holds the same state. Failure only means the next load does a cold start.
+ * Returns: void.
+ */
+void gic400_warm_save(struct GIC_Base *gicBase)
+{
+    struct GIC_WarmRecord *pending = gicBase->warm_record;
+    gicBase->warm_record = NULL;
+    if (pending && gicBase->warm_restart)
+    {
+        AddSemaphore(&pending->semaphore);
+        return;
+    }
+    if (pending)
+        FreeMem(pending, pending->size);
+    if (!gicBase->warm_restart || !gicBase->live)
+        return;
+
+    u32 max_irqs = gicBase->max_irqs;
+    u32 bytes = GIC_WARM_SIZE(max_irqs);
+
+    struct GIC_WarmRecord *stale = gic400_warm_take();
+    if (stale)
+        FreeMem(stale, stale->magic == GIC_WARM_MAGIC ? stale->size : sizeof(struct GIC_WarmRecord));
+
+    struct GIC_WarmRecord *record = AllocMem(bytes, MEMF_PUBLIC | MEMF_CLEAR);
+    if (!record)
+    {
+        Kprintf("[gic] %s: Failed to allocate warm-restart record (%lu bytes)\n", __func__, bytes);
+        return;
+    }
+
+    record->magic = GIC_WARM_MAGIC;
+    record->version = GIC_WARM_VERSION;
+    record->size = bytes;
+    record->gic_base_distributor = gicBase->gic_base_distributor;
+    record->gic_base_cpuif = gicBase->gic_base_cpuif;
+    record->gicd_iidr = gicBase->gicd_iidr;
+    record->gicd_typer = gicBase->gicd_typer;
+    record->gicc_iidr = gicBase->gicc_iidr;
+    record->dt_gic_phandle = gicBase->dt_gic_phandle;
+
+    u32 *priority = record->regs;
+    u32 *targets = priority + max_irqs / 4;
+    u32 *icfgr = targets + max_irqs / 4;
+    for (u32 reg_index = 0; reg_index < max_irqs / 4; reg_index++)
+    {
+        priority[reg_index] = gic_read32(GICD_IPRIORITYR(reg_index));
+        targets[reg_index] = gic_read32(GICD_ITARGETSR(reg_index));
+    }
+    for (u32 reg_index = 0; reg_index < max_irqs / 16; reg_index++)
+        icfgr[reg_index] = gic_read32(GICD_ICFGR(reg_index));
+
+    record->checksum = gic400_warm_checksum(record);
+
+    const char *src = GIC_WARM_NAME;
+    for (u32 i = 0; src[i] && i < sizeof(record->name) - 1; i++)
+        record->name[i] = src[i];
+    record->semaphore.ss_Link.ln_Name = record->name;
+    record->semaphore.ss_Link.ln_Pri = 0;
+    AddSemaphore(&record->semaphore);
+
+    KprintfH("[gic] %s: Warm-restart record saved (%lu bytes)\n", __func__, bytes);
+}
+
+/* SetWarmRestart: Choose what the next expunge leaves behind.
+ * When enabled, expunging the library publishes the register bases, ID
+ * registers and the priority, target and trigger state of every IRQ. A
+ * reloaded library that finds and validates the record skips device-tree
+ * parsing and the SPI reset; the setting then stays on.
+ * Args: enable - TRUE to leave a record, FALSE for a cold restart.
+ * Returns: 0 on success, negative GIC400_ERR_* on failure.
+ */
+LONG SetWarmRestart(BOOL enable asm("d0"), struct GIC_Base *gicBase asm("a6"))
+{
+    GIC_MMIO_SCOPE(GIC400_STAT_WARM);
+    if (!gicBase)
+        return GIC400_ERR_NOT_READY;
+
+    gicBase->warm_restart = enable ? TRUE : FALSE;
+    return 0;
+}
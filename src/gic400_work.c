@@ -0,0 +1,110 @@
+// SPDX-License-Identifier: MPL-2.0 OR GPL-2.0+
+#include <gic400_private.h>
+
+static const char gic_work_name[] = "ARM GIC-400 deferred work";
+
+/* gic400_work_server: Soft interrupt running all queued work.
+ * Each pass takes a whole priority level with one exchange and runs it in
+ * queueing order, then starts again at the most urgent level, so work
+ * queued by a more urgent IRQ meanwhile goes ahead of what is left.
+ * Args: gicBase - library base (is_Data).
+ */
+static ULONG gic400_work_server(register struct GIC_Base *gicBase asm("a1"))
+{
+    GIC_MMIO_SCOPE(GIC400_STAT_WORK);
+    u32 level = 0;
+    while (level < GIC_WORK_LEVELS)
+    {
+        struct GICWork *batch = __atomic_exchange_n(&gicBase->work_heads[level], NULL, __ATOMIC_ACQUIRE);
+        if (!batch)
+        {
+            level++;
+            continue;
+        }
+
+        /* the level is a LIFO; reverse it to run the oldest item first */
+        struct GICWork *ordered = NULL;
+        while (batch)
+        {
+            struct GICWork *next = batch->next;
+            batch->next = ordered;
+            ordered = batch;
+            batch = next;
+        }
+
+        while (ordered)
+        {
+            struct GICWork *work = ordered;
+            struct Interrupt *interrupt = work->interrupt;
+            u32 irq = work->irq;
+            ordered = work->next;
+            __atomic_store_n(&work->queued, 0, __ATOMIC_RELEASE); // may be queued again from here on
+            gic400_call_interrupt(interrupt, irq);
+        }
+        level = 0;
+    }
+    return 0;
+}
+
+/* gic400_work_init: Empty the queue; called from gic400_init(). */
+void gic400_work_init(struct GIC_Base *gicBase)
+{
+    for (u32 level = 0; level < GIC_WORK_LEVELS; level++)
+        gicBase->work_heads[level] = NULL;
+
+    gicBase->work_softint.is_Node.ln_Type = NT_INTERRUPT;
+    gicBase->work_softint.is_Node.ln_Pri = 32; // ahead of every other soft interrupt
+    gicBase->work_softint.is_Node.ln_Name = (char *)gic_work_name;
+    gicBase->work_softint.is_Data = gicBase;
+    gicBase->work_softint.is_Code = (APTR)gic400_work_server;
+}
+
+/* gic400_work_queue: Push an item onto its priority level and wake the queue.
+ * Lock-free, callable from any context. Causing an already pending soft
+ * interrupt is free, so the wakeup is shared by everything queued before
+ * it runs.
+ * Args: work - item with interrupt set; irq - passed to the server;
+ *  priority - GIC priority byte.
+ * Returns: FALSE when the item was already queued.
+ */
+BOOL gic400_work_queue(struct GIC_Base *gicBase, struct GICWork *work, u32 irq, u8 priority)
+{
+    if (__atomic_exchange_n(&work->queued, 1, __ATOMIC_ACQUIRE))
+        return FALSE;
+
+    work->irq = irq;
+
+    struct GICWork **head = &gicBase->work_heads[priority >> 4];
+    struct GICWork *old = __atomic_load_n(head, __ATOMIC_RELAXED);
+    do
+    {
+        work->next = old;
+    } while (!__atomic_compare_exchange_n(head, &old, work, FALSE, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+
+    Cause(&gicBase->work_softint);
+    return TRUE;
+}
+
+/* QueueWork: Queue follow-up work at the priority of an IRQ.
+ * Callable from interrupt servers; costs one priority read, one
+ * compare-and-swap and a Cause(). The work is run by the library's soft
+ * interrupt after every item of a more urgent priority.
+ * Args: work - caller-owned item with interrupt set; irq - IRQ whose GIC
+ *  priority orders the work, passed to the server in D0.
+ * Returns: 0 on success, negative GIC400_ERR_* on failure; GIC400_ERR_BUSY
+ *  when the item is still queued.
+ */
+LONG QueueWork(struct GICWork *work asm("a0"), ULONG irq asm("d0"), struct GIC_Base *gicBase asm("a6"))
+{
+    GIC_MMIO_SCOPE(GIC400_STAT_WORK);
+    if (!gicBase)
+        return GIC400_ERR_NOT_READY;
+    if (!work || !work->interrupt || !work->interrupt->is_Code)
+        return GIC400_ERR_INVALID_ARGUMENT;
+    if (irq >= gicBase->max_irqs)
+        return GIC400_ERR_INVALID_IRQ;
+
+    if (!gic400_work_queue(gicBase, work, irq, gicd_get_priority(gicBase, irq)))
+        return GIC400_ERR_BUSY;
+    return 0;
+}
@@ -0,0 +1,516 @@
+// SPDX-License-Identifier: MPL-2.0 OR GPL-2.0+
+/* dispatch_test: Run the assembly dispatcher and gic400_dispatch() side by
+ * side against the GIC register model.
+ *
+ * Each case brings the library up on a fresh model, registers host servers
+ * and sets per-IRQ flags or dispatcher hooks, queues one GICC_IAR value and
+ * dispatches it twice: once through the C path the Exec server takes
+ * (gic400_dispatch() on a GICC_IAR read) and once through
+ * _gic400_exec_dispatcher_asm, interpreted from the preprocessed
+ * src/gic400_dispatch.S. The return value, the server calls, the GICC_EOIR
+ * writes and the library state a case probes must be identical, and the
+ * assembly must take the fast or the C path as expected.
+ *
+ * The benchmark then repeats the common case and reports, per dispatch, the
+ * instructions and bus accesses of the assembly fast path and the GIC
+ * register accesses of both paths.
+ *
+ * Usage: dispatch_test <preprocessed gic400_dispatch.S>
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "gic400_host.h"
+#include "gic_model.h"
+#include "m68k_sim.h"
+
+#define HOST_IT_LINES 7 // 256 IRQs
+
+/* Simulated address space */
+#define SIM_SYSBASE 0x00000400u
+#define SIM_DISPATCH 0x00000100u
+#define SIM_HANDLERS 0x00001000u
+#define SIM_FLAGS 0x00002000u
+#define SIM_INTERRUPTS 0x00003000u
+#define SIM_INTERRUPT_SIZE 32
+#define SIM_SLOTS 16
+#define SIM_STACK 0x0000FF00u
+#define SIM_MMIO 0x40000000u
+#define SIM_MMIO_SIZE 0x2000u
+#define SIM_GIC_BASE 0x00C0DE00u // struct GIC_Base token passed to _gic400_dispatch
+#define SIM_DATA 0x00DA7A00u     // is_Data tokens, one per slot
+#define SIM_SERVER_TRAP 0x80000000u
+#define SIM_DISPATCH_TRAP 0x90000000u
+
+#define TEST_IRQ 40
+#define TEST_PRIORITY 0xA0
+#define TEST_CLOCK 1000
+#define TEST_SERVICE 3 // us a test server takes
+#define TEST_MAX_CALLS 4
+
+struct test_call
+{
+    u32 irq;
+    u32 hint;
+    u32 stamp;
+    APTR data;
+};
+
+struct test_outcome
+{
+    ULONG result;
+    u32 eoi_count;
+    u32 eoi[TEST_MAX_CALLS];
+    u32 call_count;
+    struct test_call calls[TEST_MAX_CALLS];
+    u32 probe;
+    u32 slow_calls; // assembly only: calls into gic400_dispatch()
+    u32 abi_errors; // assembly only: bad server or C call registers
+    struct gic_model_counts mmio;
+    struct m68k_sim_stats sim;
+};
+
+static struct test_outcome *current;
+static u32 server_data[SIM_SLOTS];
+
+static ULONG test_server(u32 irq, u32 hint, APTR data, u32 stamp)
+{
+    if (current->call_count < TEST_MAX_CALLS)
+    {
+        struct test_call *call = &current->calls[current->call_count];
+        call->irq = irq;
+        call->hint = hint;
+        call->stamp = stamp;
+        call->data = data;
+    }
+    current->call_count++;
+    gic_model_advance(TEST_SERVICE);
+    return 0;
+}
+
+/* A server whose device raises the line again while it runs */
+static ULONG test_server_repend(u32 irq, u32 hint, APTR data, u32 stamp)
+{
+    gic_model_set_pending(irq);
+    return test_server(irq, hint, data, stamp);
+}
+
+/* Cases */
+
+struct test_case
+{
+    const char *name;
+    u32 iar;
+    u32 irq; // registered IRQ
+    gic400_host_server server;
+    LONG (*setup)(struct GIC_Base *gicBase);
+    u32 (*probe)(struct GIC_Base *gicBase);
+    ULONG result;
+    BOOL eoi;
+    u32 calls;
+    BOOL fast;
+};
+
+static LONG setup_overrun(struct GIC_Base *gicBase)
+{
+    LONG ret = SetIntTriggerEdge(TEST_IRQ, gicBase); // overrun detection is edge-only
+    return ret < 0 ? ret : SetIntOverrunDetect(TEST_IRQ, TRUE, gicBase);
+}
+
+static u32 probe_overrun(struct GIC_Base *gicBase)
+{
+    return (u32)GetIntOverruns(TEST_IRQ, FALSE, gicBase);
+}
+
+static LONG setup_timestamp(struct GIC_Base *gicBase)
+{
+    return SetIntTimestamp(TEST_IRQ, TRUE, gicBase);
+}
+
+static u32 probe_timestamp(struct GIC_Base *gicBase)
+{
+    ULONG stamp = 0;
+    GetIntTimestamp(TEST_IRQ, &stamp, gicBase);
+    return stamp;
+}
+
+static LONG setup_budget(struct GIC_Base *gicBase)
+{
+    return SetIntBudget(TEST_IRQ, 100, 0, gicBase);
+}
+
+static u32 probe_budget(struct GIC_Base *gicBase)
+{
+    struct GICBudgetInfo info;
+    if (GetIntBudgets(&info, 1, gicBase) != 1)
+        return ~0u;
+    return (info.runs << 16) | info.worst;
+}
+
+static LONG setup_trace(struct GIC_Base *gicBase)
+{
+    return StartIntTrace(8, gicBase);
+}
+
+static u32 probe_trace(struct GIC_Base *gicBase)
+{
+    struct GICTraceRecord record;
+    if (ReadIntTrace(&record, 1, gicBase) != 1)
+        return ~0u;
+    return ((u32)record.irq << 16) | (record.duration << 8) | record.flags;
+}
+
+static LONG setup_fairness(struct GIC_Base *gicBase)
+{
+    return SetIntFairness(100, 10, gicBase);
+}
+
+static u32 probe_fairness(struct GIC_Base *gicBase)
+{
+    struct GICFairnessInfo info;
+    GetIntFairness(&info, gicBase);
+    return (info.window << 16) | gicBase->fair_dispatches;
+}
+
+static const struct test_case test_cases[] = {
+    {"registered SPI", TEST_IRQ, TEST_IRQ, test_server, NULL, NULL, 1, TRUE, 1, TRUE},
+    {"SGI with source CPU", (3u << 10) | 5, 5, test_server, NULL, NULL, 1, TRUE, 1, TRUE},
+    {"PPI", 27, 27, test_server, NULL, NULL, 1, TRUE, 1, TRUE},
+    {"unregistered", TEST_IRQ + 1, TEST_IRQ, test_server, NULL, NULL, 1, TRUE, 0, TRUE},
+    {"spurious 1023", 1023, TEST_IRQ, test_server, NULL, NULL, 0, FALSE, 0, FALSE},
+    {"spurious 1022", 1022, TEST_IRQ, test_server, NULL, NULL, 0, FALSE, 0, FALSE},
+    {"out of range (max_irqs)", 256, TEST_IRQ, test_server, NULL, NULL, 1, TRUE, 0, FALSE},
+    {"out of range (1019)", 1019, TEST_IRQ, test_server, NULL, NULL, 1, TRUE, 0, FALSE},
+    {"flagged: overrun", TEST_IRQ, TEST_IRQ, test_server_repend, setup_overrun, probe_overrun, 1, TRUE, 1, FALSE},
+    {"flagged: timestamp", TEST_IRQ, TEST_IRQ, test_server, setup_timestamp, probe_timestamp, 1, TRUE, 1, FALSE},
+    {"flagged: budget", TEST_IRQ, TEST_IRQ, test_server, setup_budget, probe_budget, 1, TRUE, 1, FALSE},
+    {"hooked: trace", TEST_IRQ, TEST_IRQ, test_server, setup_trace, probe_trace, 1, TRUE, 1, FALSE},
+    {"hooked: trace, unregistered", TEST_IRQ + 1, TEST_IRQ, test_server, setup_trace, probe_trace, 1, TRUE, 0, FALSE},
+    {"hooked: fairness", TEST_IRQ, TEST_IRQ, test_server, setup_fairness, probe_fairness, 1, TRUE, 1, FALSE},
+};
+
+#define TEST_CASES (sizeof(test_cases) / sizeof(test_cases[0]))
+
+/* Simulator glue */
+
+struct sim_context
+{
+    struct GIC_Base *gicBase;
+    struct Interrupt *slots[SIM_SLOTS];
+    u32 slot_count;
+};
+
+static const char *const sim_externs[] = {"_gic400_dispatch"};
+static const u32 sim_extern_addresses[] = {SIM_DISPATCH_TRAP};
+
+static const u32 sim_preserved_d[8] = {0, 0, 0x22222222, 0x33333333, 0x44444444, 0x55555555, 0x66666666, 0x77777777};
+static const u32 sim_preserved_a[8] = {0, 0, 0xAAAA2222, 0xAAAA3333, 0xAAAA4444, 0, 0, 0};
+
+/* Exec server or C function return: clobber what the callee may clobber */
+static void sim_clobber(struct m68k_sim *sim, BOOL server)
+{
+    sim->d[1] = 0xDEAD0001;
+    sim->a[0] = 0xDEAD000A;
+    sim->a[1] = 0xDEAD001A;
+    if (server)
+    {
+        sim->d[0] = 0xDEAD0000;
+        sim->a[5] = 0xDEAD005A;
+        sim->a[6] = 0xDEAD006A;
+    }
+}
+
+static void sim_trap(struct m68k_sim *sim, u32 address, void *user)
+{
+    struct sim_context *context = user;
+
+    if (address == SIM_DISPATCH_TRAP)
+    {
+        /* cdecl: gicBase at 4(sp), iar at 8(sp), result in D0 */
+        if (m68k_sim_read32(sim, sim->a[7] + 4) != SIM_GIC_BASE)
+            current->abi_errors++;
+        u32 iar = m68k_sim_read32(sim, sim->a[7] + 8);
+        current->slow_calls++;
+        sim_clobber(sim, FALSE);
+        sim->d[0] = gic400_dispatch(context->gicBase, iar);
+        return;
+    }
+
+    u32 slot = address - SIM_SERVER_TRAP;
+    if (slot >= context->slot_count)
+    {
+        fprintf(stderr, "dispatch_test: call to %08x\n", address);
+        current->abi_errors++;
+        return;
+    }
+
+    /* Exec server ABI: D0 = irq, D1 = hint, A1 = is_Data, A6 = SysBase */
+    struct Interrupt *interrupt = context->slots[slot];
+    u32 irq = sim->d[0];
+    if (irq >= context->gicBase->max_irqs || context->gicBase->handlers[irq] != interrupt || sim->d[1] != 0 ||
+        sim->a[1] != SIM_DATA + slot || sim->a[6] != m68k_sim_read32(sim, 4))
+        current->abi_errors++;
+    gic400_host_call(interrupt, irq, sim->d[1], 0);
+    sim_clobber(sim, TRUE);
+}
+
+/* Mirror the library's struct GIC_Dispatch and tables into simulated RAM */
+static void sim_prepare(struct m68k_sim *sim, struct sim_context *context)
+{
+    struct GIC_Base *gicBase = context->gicBase;
+    const struct GIC_Dispatch *dispatch = &gicBase->dispatch;
+    u8 *gicc = gic_model_gicc();
+
+    memset(sim->ram, 0, sizeof(sim->ram));
+    m68k_sim_write32(sim, 4, SIM_SYSBASE);
+    m68k_sim_write32(sim, SIM_DISPATCH + GIC_DISPATCH_IAR, SIM_MMIO + (u32)((u8 *)dispatch->gicc_iar - gicc));
+    m68k_sim_write32(sim, SIM_DISPATCH + GIC_DISPATCH_EOIR, SIM_MMIO + (u32)((u8 *)dispatch->gicc_eoir - gicc));
+    m68k_sim_write32(sim, SIM_DISPATCH + GIC_DISPATCH_MAX_IRQS, dispatch->max_irqs);
+    m68k_sim_write32(sim, SIM_DISPATCH + GIC_DISPATCH_HANDLERS, SIM_HANDLERS);
+    m68k_sim_write32(sim, SIM_DISPATCH + GIC_DISPATCH_FLAGS, SIM_FLAGS);
+    m68k_sim_write32(sim, SIM_DISPATCH + GIC_DISPATCH_BASE, SIM_GIC_BASE);
+    m68k_sim_write32(sim, SIM_DISPATCH + GIC_DISPATCH_HOOKS, dispatch->hooks);
+
+    context->slot_count = 0;
+    for (u32 irq = 0; irq < dispatch->max_irqs; irq++)
+    {
+        m68k_sim_write8(sim, SIM_FLAGS + irq, dispatch->irq_flags[irq]);
+        struct Interrupt *interrupt = dispatch->handlers[irq];
+        if (!interrupt)
+            continue;
+
+        u32 slot = context->slot_count++;
+        u32 image = SIM_INTERRUPTS + slot * SIM_INTERRUPT_SIZE;
+        context->slots[slot] = interrupt;
+        m68k_sim_write32(sim, image + GIC_IS_DATA, SIM_DATA + slot);
+        m68k_sim_write32(sim, image + GIC_IS_CODE, SIM_SERVER_TRAP + slot);
+        m68k_sim_write32(sim, SIM_HANDLERS + 4 * irq, image);
+    }
+
+    sim->mmio_base = SIM_MMIO;
+    sim->mmio_size = SIM_MMIO_SIZE;
+    sim->mmio_host = gicc;
+    sim->trap = sim_trap;
+    sim->trap_user = context;
+}
+
+/* Run the assembly entry with poisoned registers; check what it must keep */
+static int sim_dispatch(struct m68k_sim *sim, struct test_outcome *outcome)
+{
+    for (u32 i = 0; i < 8; i++)
+    {
+        sim->d[i] = sim_preserved_d[i];
+        sim->a[i] = sim_preserved_a[i];
+    }
+    sim->d[0] = 0xBAD0BAD0;
+    sim->d[1] = 0xBAD1BAD1;
+    sim->a[0] = 0xBAD0A000;
+    sim->a[1] = SIM_DISPATCH;
+    sim->a[5] = 0xBAD5A000;
+    sim->a[6] = SIM_SYSBASE;
+    sim->a[7] = SIM_STACK;
+
+    if (m68k_sim_call(sim, "_gic400_exec_dispatcher_asm") < 0)
+        return -1;
+
+    for (u32 i = 2; i < 8; i++)
+        if (sim->d[i] != sim_preserved_d[i])
+            outcome->abi_errors++;
+    for (u32 i = 2; i < 5; i++)
+        if (sim->a[i] != sim_preserved_a[i])
+            outcome->abi_errors++;
+    if (sim->a[7] != SIM_STACK || sim->z != (sim->d[0] == 0))
+        outcome->abi_errors++;
+    outcome->result = sim->d[0];
+    return 0;
+}
+
+/* Case runner */
+
+static int run_case(const struct test_case *test, struct m68k_sim *sim, struct test_outcome *outcome)
+{
+    memset(outcome, 0, sizeof(*outcome));
+    current = outcome;
+
+    struct GIC_Base *gicBase = gic400_host_open(HOST_IT_LINES);
+    if (!gicBase)
+    {
+        fprintf(stderr, "dispatch_test: library bring-up failed\n");
+        return -1;
+    }
+
+    struct Interrupt server;
+    gic400_host_server_init(&server, test->server, &server_data[0]);
+    if (AddIntServerEx(test->irq, TEST_PRIORITY, FALSE, &server, gicBase) < 0 || (test->setup && test->setup(gicBase) < 0))
+    {
+        fprintf(stderr, "dispatch_test: %s: setup failed\n", test->name);
+        gic400_host_close(gicBase);
+        return -1;
+    }
+
+    gic_model_set_clock(TEST_CLOCK);
+    gic_model_clear_log();
+    gic_model_clear_counts();
+    gic_model_push_iar(test->iar);
+
+    struct sim_context context = {.gicBase = gicBase};
+    int ret = 0;
+    if (sim)
+    {
+        sim_prepare(sim, &context);
+        gic_model_clear_counts();
+        memset(&sim->stats, 0, sizeof(sim->stats));
+        ret = sim_dispatch(sim, outcome);
+        outcome->sim = sim->stats;
+    }
+    else
+        outcome->result = gic400_dispatch(gicBase, mmio_read32(gicBase->dispatch.gicc_iar));
+    outcome->mmio = gic_model_counts();
+
+    outcome->eoi_count = gic_model_eoi_count();
+    for (u32 i = 0; i < outcome->eoi_count && i < TEST_MAX_CALLS; i++)
+        outcome->eoi[i] = gic_model_eoi(i);
+    if (test->probe)
+        outcome->probe = test->probe(gicBase);
+
+    RemIntServerEx(test->irq, &server, gicBase);
+    u32 leaked = gic400_host_close(gicBase);
+    if (leaked)
+    {
+        fprintf(stderr, "dispatch_test: %s: %u allocations leaked\n", test->name, leaked);
+        return -1;
+    }
+    return ret;
+}
+
+static BOOL check(BOOL ok, const char *name, const char *what)
+{
+    if (!ok)
+        printf("FAIL %s: %s\n", name, what);
+    return ok;
+}
+
+static BOOL check_case(const struct test_case *test, const struct test_outcome *c, const struct test_outcome *as)
+{
+    BOOL ok = TRUE;
+    ok &= check(c->result == test->result, test->name, "C result");
+    ok &= check(c->eoi_count == (test->eoi ? 1u : 0u), test->name, "C EOI count");
+    ok &= check(!test->eoi || c->eoi[0] == test->iar, test->name, "C EOI value is not the IAR");
+    ok &= check(c->call_count == test->calls, test->name, "C server calls");
+    for (u32 i = 0; i < c->call_count && i < TEST_MAX_CALLS; i++)
+        ok &= check(c->calls[i].irq == (test->iar & 0x3FF) && c->calls[i].data == &server_data[0], test->name, "C server arguments");
+
+    ok &= check(as->result == c->result, test->name, "asm result differs");
+    ok &= check(as->eoi_count == c->eoi_count && memcmp(as->eoi, c->eoi, sizeof(c->eoi)) == 0, test->name, "asm EOI writes differ");
+    ok &= check(as->call_count == c->call_count && memcmp(as->calls, c->calls, sizeof(c->calls)) == 0, test->name, "asm server calls differ");
+    ok &= check(as->probe == c->probe, test->name, "asm library state differs");
+    ok &= check(as->abi_errors == 0, test->name, "asm register convention");
+    ok &= check(as->slow_calls == (test->fast ? 0u : 1u), test->name, test->fast ? "asm left the fast path" : "asm missed the C path");
+    if (test->fast)
+        ok &= check(as->mmio.reads == 1 && as->mmio.writes == (test->eoi ? 1u : 0u), test->name, "asm fast path register accesses");
+    return ok;
+}
+
+/* Benchmark */
+
+#define BENCH_ROUNDS 1000
+
+static int bench(struct m68k_sim *sim)
+{
+    static const struct
+    {
+        const char *name;
+        u32 iar;
+    } rows[] = {
+        {"registered", TEST_IRQ},
+        {"unregistered", TEST_IRQ + 1},
+        {"spurious", 1023},
+    };
+
+    struct GIC_Base *gicBase = gic400_host_open(HOST_IT_LINES);
+    if (!gicBase)
+        return -1;
+
+    struct test_outcome outcome;
+    memset(&outcome, 0, sizeof(outcome));
+    current = &outcome;
+    struct Interrupt server;
+    gic400_host_server_init(&server, test_server, &server_data[0]);
+    AddIntServerEx(TEST_IRQ, TEST_PRIORITY, FALSE, &server, gicBase);
+
+    struct sim_context context = {.gicBase = gicBase};
+    sim_prepare(sim, &context);
+
+    printf("\nper dispatch, %u rounds   asm: insns  ram rd/wr  gic rd/wr   C: gic rd/wr\n", BENCH_ROUNDS);
+    int ret = 0;
+    for (u32 row = 0; row < sizeof(rows) / sizeof(rows[0]); row++)
+    {
+        gic_model_clear_counts();
+        for (u32 i = 0; i < BENCH_ROUNDS; i++)
+        {
+            gic_model_push_iar(rows[row].iar);
+            gic400_dispatch(gicBase, mmio_read32(gicBase->dispatch.gicc_iar));
+        }
+        struct gic_model_counts c = gic_model_counts();
+
+        gic_model_clear_counts();
+        memset(&sim->stats, 0, sizeof(sim->stats));
+        for (u32 i = 0; i < BENCH_ROUNDS && ret == 0; i++)
+        {
+            gic_model_push_iar(rows[row].iar);
+            ret = sim_dispatch(sim, &outcome);
+        }
+        struct gic_model_counts as = gic_model_counts();
+
+        printf("  %-24s %10.1f %5.1f/%-4.1f %5.1f/%-4.1f %8.1f/%-4.1f\n", rows[row].name,
+               (double)sim->stats.instructions / BENCH_ROUNDS, (double)sim->stats.ram_reads / BENCH_ROUNDS,
+               (double)sim->stats.ram_writes / BENCH_ROUNDS, (double)as.reads / BENCH_ROUNDS,
+               (double)as.writes / BENCH_ROUNDS, (double)c.reads / BENCH_ROUNDS, (double)c.writes / BENCH_ROUNDS);
+        if (as.reads > c.reads || as.writes > c.writes)
+        {
+            printf("FAIL bench %s: asm makes more GIC accesses than C\n", rows[row].name);
+            ret = -1;
+        }
+    }
+    if (outcome.abi_errors)
+        ret = -1;
+
+    RemIntServerEx(TEST_IRQ, &server, gicBase);
+    gic400_host_close(gicBase);
+    return ret;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc != 2)
+    {
+        fprintf(stderr, "usage: %s <preprocessed gic400_dispatch.S>\n", argv[0]);
+        return 2;
+    }
+
+    static struct m68k_sim sim;
+    if (m68k_sim_load(&sim, argv[1], sim_externs, sim_extern_addresses, 1) < 0)
+        return 1;
+
+    u32 failed = 0;
+    for (u32 i = 0; i < TEST_CASES; i++)
+    {
+        const struct test_case *test = &test_cases[i];
+        struct test_outcome c, as;
+        if (run_case(test, NULL, &c) < 0 || run_case(test, &sim, &as) < 0 || !check_case(test, &c, &as))
+        {
+            failed++;
+            continue;
+        }
+        printf("ok   %-28s %s, %u insns, gic %u/%u\n", test->name, test->fast ? "fast" : "C path", as.sim.instructions,
+               as.mmio.reads, as.mmio.writes);
+    }
+
+    if (bench(&sim) < 0)
+        failed++;
+
+    m68k_sim_free(&sim);
+    printf("\n%u of %u cases failed\n", failed, (u32)TEST_CASES);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,453 @@
+// SPDX-License-Identifier: MPL-2.0 OR GPL-2.0+
+/* Exec, devicetree.resource and emu68-common stand-ins for the host build.
+ * Just enough for the library to discover the modelled GIC through a fixed
+ * device tree and run with interrupts "disabled" by a nesting counter.
+ */
+#include <ctype.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <exec/memory.h>
+
+#include "gic400_host.h"
+#include "gic_model.h"
+#include <debug.h>
+#include <devtree.h>
+#include <proto/dos.h>
+#include <strutil.h>
+
+struct gic400_host_exec gic400_host_exec;
+
+/* Exec */
+
+APTR AllocMem(ULONG byteSize, ULONG requirements)
+{
+    APTR block = (requirements & MEMF_CLEAR) ? calloc(1, byteSize ? byteSize : 1) : malloc(byteSize ? byteSize : 1);
+    if (block)
+        gic400_host_exec.allocations++;
+    return block;
+}
+
+void FreeMem(APTR memoryBlock, ULONG byteSize)
+{
+    (void)byteSize;
+    if (!memoryBlock)
+        return;
+    gic400_host_exec.allocations--;
+    free(memoryBlock);
+}
+
+void Disable(void)
+{
+    gic400_host_exec.disable_depth++;
+}
+
+void Enable(void)
+{
+    if (gic400_host_exec.disable_depth == 0)
+    {
+        fprintf(stderr, "host: Enable() without Disable()\n");
+        abort();
+    }
+    gic400_host_exec.disable_depth--;
+}
+
+void Forbid(void)
+{
+}
+
+void Permit(void)
+{
+}
+
+void AddIntServer(LONG intNumber, struct Interrupt *interrupt)
+{
+    (void)interrupt;
+    if (intNumber == INTB_EXTER)
+        gic400_host_exec.exter_servers++;
+}
+
+void RemIntServer(LONG intNumber, struct Interrupt *interrupt)
+{
+    (void)interrupt;
+    if (intNumber == INTB_EXTER)
+        gic400_host_exec.exter_servers--;
+}
+
+void Cause(struct Interrupt *interrupt)
+{
+    (void)interrupt;
+    gic400_host_exec.causes++;
+}
+
+void NewList(struct List *list)
+{
+    list->lh_Head = (struct Node *)&list->lh_Tail;
+    list->lh_Tail = NULL;
+    list->lh_TailPred = (struct Node *)&list->lh_Head;
+}
+
+void Insert(struct List *list, struct Node *node, struct Node *pred)
+{
+    if (pred == NULL)
+        pred = (struct Node *)&list->lh_Head;
+    node->ln_Succ = pred->ln_Succ;
+    node->ln_Pred = pred;
+    pred->ln_Succ->ln_Pred = node;
+    pred->ln_Succ = node;
+}
+
+void AddHead(struct List *list, struct Node *node)
+{
+    Insert(list, node, NULL);
+}
+
+void AddTail(struct List *list, struct Node *node)
+{
+    Insert(list, node, list->lh_TailPred);
+}
+
+void Remove(struct Node *node)
+{
+    node->ln_Pred->ln_Succ = node->ln_Succ;
+    node->ln_Succ->ln_Pred = node->ln_Pred;
+}
+
+void InitSemaphore(struct SignalSemaphore *semaphore)
+{
+    memset(semaphore, 0, sizeof(*semaphore));
+}
+
+void ObtainSemaphore(struct SignalSemaphore *semaphore)
+{
+    semaphore->ss_NestCount++;
+}
+
+void ReleaseSemaphore(struct SignalSemaphore *semaphore)
+{
+    semaphore->ss_NestCount--;
+}
+
+ULONG AttemptSemaphore(struct SignalSemaphore *semaphore)
+{
+    semaphore->ss_NestCount++;
+    return 1;
+}
+
+#define HOST_SEMAPHORES 8
+static struct SignalSemaphore *host_semaphores[HOST_SEMAPHORES];
+
+void AddSemaphore(struct SignalSemaphore *semaphore)
+{
+    for (u32 i = 0; i < HOST_SEMAPHORES; i++)
+    {
+        if (!host_semaphores[i])
+        {
+            host_semaphores[i] = semaphore;
+            return;
+        }
+    }
+}
+
+void RemSemaphore(struct SignalSemaphore *semaphore)
+{
+    for (u32 i = 0; i < HOST_SEMAPHORES; i++)
+        if (host_semaphores[i] == semaphore)
+            host_semaphores[i] = NULL;
+}
+
+struct SignalSemaphore *FindSemaphore(CONST_STRPTR name)
+{
+    for (u32 i = 0; i < HOST_SEMAPHORES; i++)
+        if (host_semaphores[i] && strcmp(host_semaphores[i]->ss_Link.ln_Name, name) == 0)
+            return host_semaphores[i];
+    return NULL;
+}
+
+static struct Task host_task;
+
+struct Task *FindTask(CONST_STRPTR name)
+{
+    return name ? NULL : &host_task;
+}
+
+void Signal(struct Task *task, ULONG signals)
+{
+    (void)task;
+    (void)signals;
+}
+
+static int host_devicetree;
+
+APTR OpenResource(CONST_STRPTR resName)
+{
+    return strcmp(resName, "devicetree.resource") == 0 ? &host_devicetree : NULL;
+}
+
+struct Library *OpenLibrary(CONST_STRPTR libName, ULONG version)
+{
+    (void)libName;
+    (void)version;
+    return NULL; // no dos.library: the tuning profile is never read
+}
+
+void CloseLibrary(struct Library *library)
+{
+    (void)library;
+}
+
+BPTR host_Open(struct Library *base, CONST_STRPTR name, LONG mode)
+{
+    (void)base, (void)name, (void)mode;
+    return 0;
+}
+
+LONG host_Close(struct Library *base, BPTR file)
+{
+    (void)base, (void)file;
+    return 0;
+}
+
+LONG host_Read(struct Library *base, BPTR file, APTR buffer, LONG length)
+{
+    (void)base, (void)file, (void)buffer, (void)length;
+    return -1;
+}
+
+LONG host_Seek(struct Library *base, BPTR file, LONG position, LONG mode)
+{
+    (void)base, (void)file, (void)position, (void)mode;
+    return -1;
+}
+
+/* emu68-common */
+
+LONG _Strnicmp(CONST_STRPTR a, CONST_STRPTR b, LONG length)
+{
+    for (LONG i = 0; i < length; i++)
+    {
+        int ca = tolower((unsigned char)a[i]);
+        int cb = tolower((unsigned char)b[i]);
+        if (ca != cb)
+            return ca - cb;
+        if (ca == 0)
+            return 0;
+    }
+    return 0;
+}
+
+/* Kprintf: Print to stderr when GIC400_HOST_LOG is set. The library passes
+ * 32-bit values with %l conversions, so the l modifiers are dropped.
+ */
+void Kprintf(const char *format, ...)
+{
+    if (!getenv("GIC400_HOST_LOG"))
+        return;
+
+    char converted[512];
+    size_t out = 0;
+    for (const char *p = format; *p && out < sizeof(converted) - 1; p++)
+    {
+        if (*p == 'l' && p > format && strchr("%0123456789-", p[-1]) && strchr("dxXuic", p[1]))
+            continue;
+        converted[out++] = *p;
+    }
+    converted[out] = 0;
+
+    va_list args;
+    va_start(args, format);
+    vfprintf(stderr, converted, args);
+    va_end(args);
+}
+
+/* devicetree.resource: a root, the GIC and the system timer. reg cells hold
+ * tokens that DT_TranslateAddress() turns into the model's pages.
+ */
+
+#define HOST_DT_GICD 1
+#define HOST_DT_GICC 2
+#define HOST_DT_SYSTIMER 3
+#define HOST_DT_PHANDLE 1
+
+struct host_dt_prop
+{
+    const char *name;
+    const void *value;
+    ULONG length;
+};
+
+struct host_dt_node
+{
+    const char *name;
+    struct host_dt_node *parent;
+    const struct host_dt_prop *props;
+    u32 prop_count;
+};
+
+static const u32 host_dt_one[] = {1};
+static const u32 host_dt_phandle[] = {HOST_DT_PHANDLE};
+static const char host_dt_gic_compatible[] = "arm,gic-400";
+static const u32 host_dt_gic_reg[] = {HOST_DT_GICD, 0x1000, HOST_DT_GICC, 0x2000};
+static const char host_dt_timer_compatible[] = "brcm,bcm2835-system-timer";
+static const u32 host_dt_timer_reg[] = {HOST_DT_SYSTIMER, 0x1000};
+static const u32 host_dt_timer_interrupts[] = {0, 64, 4, 0, 65, 4, 0, 66, 4, 0, 67, 4};
+
+static const struct host_dt_prop host_dt_root_props[] = {
+    {"interrupt-parent", host_dt_phandle, sizeof(host_dt_phandle)},
+    {"#address-cells", host_dt_one, sizeof(host_dt_one)},
+    {"#size-cells", host_dt_one, sizeof(host_dt_one)},
+};
+static const struct host_dt_prop host_dt_gic_props[] = {
+    {"compatible", host_dt_gic_compatible, sizeof(host_dt_gic_compatible)},
+    {"reg", host_dt_gic_reg, sizeof(host_dt_gic_reg)},
+    {"phandle", host_dt_phandle, sizeof(host_dt_phandle)},
+};
+static const struct host_dt_prop host_dt_timer_props[] = {
+    {"compatible", host_dt_timer_compatible, sizeof(host_dt_timer_compatible)},
+    {"reg", host_dt_timer_reg, sizeof(host_dt_timer_reg)},
+    {"interrupts", host_dt_timer_interrupts, sizeof(host_dt_timer_interrupts)},
+};
+
+static struct host_dt_node host_dt_root = {"", NULL, host_dt_root_props, 3};
+static struct host_dt_node host_dt_nodes[] = {
+    {"interrupt-controller@40041000", &host_dt_root, host_dt_gic_props, 3},
+    {"timer@7e003000", &host_dt_root, host_dt_timer_props, 3},
+};
+#define HOST_DT_CHILDREN (sizeof(host_dt_nodes) / sizeof(host_dt_nodes[0]))
+
+APTR host_DT_OpenKey(CONST_STRPTR name)
+{
+    if (strcmp(name, "/") == 0)
+        return &host_dt_root;
+    for (u32 i = 0; i < HOST_DT_CHILDREN; i++)
+        if (name[0] == '/' && strcmp(name + 1, host_dt_nodes[i].name) == 0)
+            return &host_dt_nodes[i];
+    return NULL;
+}
+
+void host_DT_CloseKey(APTR key)
+{
+    (void)key;
+}
+
+APTR host_DT_GetChild(APTR key, APTR prev)
+{
+    if (key != &host_dt_root)
+        return NULL;
+    if (prev == NULL)
+        return &host_dt_nodes[0];
+    struct host_dt_node *next = (struct host_dt_node *)prev + 1;
+    return next < host_dt_nodes + HOST_DT_CHILDREN ? next : NULL;
+}
+
+APTR host_DT_GetParent(APTR key)
+{
+    return key ? ((struct host_dt_node *)key)->parent : NULL;
+}
+
+APTR host_DT_FindProperty(APTR key, CONST_STRPTR name)
+{
+    const struct host_dt_node *node = key;
+    for (u32 i = 0; node && i < node->prop_count; i++)
+        if (strcmp(node->props[i].name, name) == 0)
+            return (APTR)&node->props[i];
+    return NULL;
+}
+
+ULONG host_DT_GetPropLen(APTR property)
+{
+    return property ? ((const struct host_dt_prop *)property)->length : 0;
+}
+
+APTR host_DT_GetPropValue(APTR property)
+{
+    return property ? (APTR)((const struct host_dt_prop *)property)->value : NULL;
+}
+
+APTR host_DT_FindByPHandle(APTR key, ULONG phandle)
+{
+    (void)key;
+    return phandle == HOST_DT_PHANDLE ? &host_dt_nodes[0] : NULL;
+}
+
+ULONG host_DT_GetPropertyValueULONG(APTR key, CONST_STRPTR name, ULONG def, BOOL check_parent)
+{
+    for (; key != NULL; key = check_parent ? host_DT_GetParent(key) : NULL)
+    {
+        const u32 *value = host_DT_GetPropValue(host_DT_FindProperty(key, name));
+        if (value)
+            return value[0];
+    }
+    return def;
+}
+
+void host_DT_TranslateAddress(APTR *address, APTR key)
+{
+    (void)key;
+    switch ((uintptr_t)*address)
+    {
+    case HOST_DT_GICD:
+        *address = gic_model_gicd();
+        break;
+    case HOST_DT_GICC:
+        *address = gic_model_gicc();
+        break;
+    case HOST_DT_SYSTIMER:
+        *address = gic_model_systimer();
+        break;
+    default:
+        *address = NULL;
+        break;
+    }
+}
+
+unsigned long long DT_GetNumber(const ULONG *cells, ULONG count)
+{
+    unsigned long long value = 0;
+    for (ULONG i = 0; i < count; i++)
+        value = (value << 32) | cells[i];
+    return value;
+}
+
+/* Harness entry points */
+
+void gic400_host_call(struct Interrupt *interrupt, u32 irq, u32 hint, u32 stamp)
+{
+    gic400_host_server code = (gic400_host_server)(void *)interrupt->is_Code;
+    code(irq, hint, interrupt->is_Data, stamp);
+}
+
+void gic400_host_server_init(struct Interrupt *interrupt, gic400_host_server code, APTR data)
+{
+    memset(interrupt, 0, sizeof(*interrupt));
+    interrupt->is_Node.ln_Type = NT_INTERRUPT;
+    interrupt->is_Data = data;
+    interrupt->is_Code = (VOID (*)())(void *)code;
+}
+
+struct GIC_Base *gic400_host_open(u32 it_lines)
+{
+    gic_model_reset(it_lines);
+    memset(&gic400_host_exec, 0, sizeof(gic400_host_exec));
+
+    struct GIC_Base *gicBase = calloc(1, sizeof(struct GIC_Base));
+    if (!gicBase)
+        return NULL;
+    InitSemaphore(&gicBase->semaphore);
+
+    if (gic400_init(gicBase) < 0 || gic400_ensure_live(gicBase) < 0)
+    {
+        free(gicBase);
+        return NULL;
+    }
+    return gicBase;
+}
+
+u32 gic400_host_close(struct GIC_Base *gicBase)
+{
+    gic400_shutdown(gicBase);
+    free(gicBase);
+    return gic400_host_exec.allocations;
+}
@@ -0,0 +1,45 @@
+// SPDX-License-Identifier: MPL-2.0 OR GPL-2.0+
+#ifndef _GIC400_HOST_H
+#define _GIC400_HOST_H
+
+/* Host build of the library for the tools/ harnesses. The library sources
+ * are compiled unchanged with -DGIC400_HOST against the headers in
+ * tools/host/include; Exec, devicetree.resource and the GIC registers are
+ * provided by tools/host/exec.c and tools/host/gic_model.c.
+ */
+
+#include <gic400_private.h>
+
+/* Server called by gic400_host_call() in place of the Exec register ABI:
+ * D0 = irq, D1 = hint, A1 = is_Data, D2 = stamp. Only servers written for
+ * the host can be registered; the library's own servers (timer, work
+ * queue, groups) use the m68k register ABI and are not run here.
+ */
+typedef ULONG (*gic400_host_server)(u32 irq, u32 hint, APTR data, u32 stamp);
+
+/* gic400_host_open: Discover and bring up the library on the register model.
+ * Args: it_lines - GICD_TYPER.ITLinesNumber, max_irqs = (it_lines + 1) * 32.
+ * Returns: library base, or NULL on failure.
+ */
+struct GIC_Base *gic400_host_open(u32 it_lines);
+
+/* gic400_host_close: Shut the library down and check for leaks.
+ * Returns: number of allocations still outstanding.
+ */
+u32 gic400_host_close(struct GIC_Base *gicBase);
+
+/* gic400_host_server_init: Fill an Interrupt for a host server. */
+void gic400_host_server_init(struct Interrupt *interrupt, gic400_host_server code, APTR data);
+
+/* State of the Exec stand-in. */
+struct gic400_host_exec
+{
+    u32 disable_depth;   // Disable() nesting, 0 outside
+    u32 exter_servers;   // servers on INTB_EXTER
+    u32 causes;          // Cause() calls
+    u32 allocations;     // AllocMem() blocks outstanding
+};
+
+extern struct gic400_host_exec gic400_host_exec;
+
+#endif /* _GIC400_HOST_H */
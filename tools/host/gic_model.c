@@ -0,0 +1,264 @@
+// SPDX-License-Identifier: MPL-2.0 OR GPL-2.0+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "gic_model.h"
+#include <iomem.h>
+
+#define GICD_SIZE 0x1000
+#define GICC_SIZE 0x2000
+#define SYSTIMER_SIZE 0x20
+#define IAR_QUEUE 256
+
+#define GICD_TYPER_OFF 0x004
+#define GICD_IIDR_OFF 0x008
+#define GICD_ISENABLER_OFF 0x100
+#define GICD_ICENABLER_OFF 0x180
+#define GICD_ISPENDR_OFF 0x200
+#define GICD_ICPENDR_OFF 0x280
+#define GICD_ISACTIVER_OFF 0x300
+#define GICD_ICACTIVER_OFF 0x380
+#define GICC_IAR_OFF 0x00C
+#define GICC_EOIR_OFF 0x010
+#define GICC_IIDR_OFF 0x0FC
+#define SYSTIMER_CLO_OFF 0x004
+
+static struct
+{
+    u32 gicd[GICD_SIZE / 4];
+    u32 gicc[GICC_SIZE / 4];
+    u32 systimer[SYSTIMER_SIZE / 4];
+    u32 max_irqs;
+    u32 iar[IAR_QUEUE];
+    u32 iar_head;
+    u32 iar_tail;
+    u32 eoi[GIC_MODEL_EOI_LOG];
+    u32 eoi_count;
+    u32 clock;
+    struct gic_model_counts counts;
+} model;
+
+void gic_model_reset(u32 it_lines)
+{
+    memset(&model, 0, sizeof(model));
+    model.max_irqs = (it_lines + 1) * 32;
+    model.gicd[GICD_TYPER_OFF / 4] = it_lines & 0x1F;
+    model.gicd[GICD_IIDR_OFF / 4] = 0x0200143B; // ARM GIC-400 r0p0
+    model.gicc[GICC_IIDR_OFF / 4] = 0x0202143B;
+    model.gicd[GICD_ISENABLER_OFF / 4] = 0x0000FFFF; // SGIs are always enabled
+}
+
+void *gic_model_gicd(void)
+{
+    return model.gicd;
+}
+
+void *gic_model_gicc(void)
+{
+    return model.gicc;
+}
+
+void *gic_model_systimer(void)
+{
+    return model.systimer;
+}
+
+void gic_model_push_iar(u32 iar)
+{
+    if (model.iar_tail - model.iar_head >= IAR_QUEUE)
+    {
+        fprintf(stderr, "gic_model: IAR queue full\n");
+        abort();
+    }
+    model.iar[model.iar_tail++ % IAR_QUEUE] = iar;
+}
+
+u32 gic_model_eoi_count(void)
+{
+    return model.eoi_count;
+}
+
+u32 gic_model_eoi(u32 index)
+{
+    return index < GIC_MODEL_EOI_LOG ? model.eoi[index] : 0;
+}
+
+void gic_model_clear_log(void)
+{
+    model.eoi_count = 0;
+    model.iar_head = model.iar_tail = 0;
+}
+
+static BOOL gic_model_bit(u32 offset, u32 irq)
+{
+    return (model.gicd[offset / 4 + irq / 32] >> (irq % 32)) & 1;
+}
+
+BOOL gic_model_pending(u32 irq)
+{
+    return gic_model_bit(GICD_ISPENDR_OFF, irq);
+}
+
+BOOL gic_model_enabled(u32 irq)
+{
+    return gic_model_bit(GICD_ISENABLER_OFF, irq);
+}
+
+BOOL gic_model_active(u32 irq)
+{
+    return gic_model_bit(GICD_ISACTIVER_OFF, irq);
+}
+
+void gic_model_set_pending(u32 irq)
+{
+    model.gicd[GICD_ISPENDR_OFF / 4 + irq / 32] |= 1u << (irq % 32);
+}
+
+u8 gic_model_priority(u32 irq)
+{
+    return ((const u8 *)model.gicd)[0x400 + irq];
+}
+
+void gic_model_set_clock(u32 now)
+{
+    model.clock = now;
+}
+
+u32 gic_model_clock(void)
+{
+    return model.clock;
+}
+
+void gic_model_advance(u32 ticks)
+{
+    model.clock += ticks;
+}
+
+struct gic_model_counts gic_model_counts(void)
+{
+    return model.counts;
+}
+
+void gic_model_clear_counts(void)
+{
+    model.counts.reads = 0;
+    model.counts.writes = 0;
+}
+
+/* gic_model_find: Map an MMIO address to a register word.
+ * Returns: the word, with *page and *offset set, or aborts.
+ */
+static u32 *gic_model_find(volatile void *addr, u32 **page, u32 *offset)
+{
+    const u8 *a = (const u8 *)addr;
+    const u8 *gicd = (const u8 *)model.gicd;
+    const u8 *gicc = (const u8 *)model.gicc;
+    const u8 *systimer = (const u8 *)model.systimer;
+
+    if (a >= gicd && a < gicd + GICD_SIZE)
+        *page = model.gicd, *offset = (u32)(a - gicd);
+    else if (a >= gicc && a < gicc + GICC_SIZE)
+        *page = model.gicc, *offset = (u32)(a - gicc);
+    else if (a >= systimer && a < systimer + SYSTIMER_SIZE)
+        *page = model.systimer, *offset = (u32)(a - systimer);
+    else
+    {
+        fprintf(stderr, "gic_model: access to unmapped address %p\n", (const void *)a);
+        abort();
+    }
+    if (*offset & 3)
+    {
+        fprintf(stderr, "gic_model: unaligned 32-bit access at %p\n", (const void *)a);
+        abort();
+    }
+    return &(*page)[*offset / 4];
+}
+
+/* Set/clear register pairs share the set half as backing store */
+static BOOL gic_model_pair(u32 offset, u32 *set_offset, BOOL *clear)
+{
+    static const u32 pairs[] = {GICD_ISENABLER_OFF, GICD_ISPENDR_OFF, GICD_ISACTIVER_OFF};
+    for (u32 i = 0; i < sizeof(pairs) / sizeof(pairs[0]); i++)
+    {
+        if (offset >= pairs[i] && offset < pairs[i] + 0x100)
+        {
+            *clear = offset >= pairs[i] + 0x80;
+            *set_offset = offset - (*clear ? 0x80 : 0);
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+u32 mmio_read32(volatile void *addr)
+{
+    u32 *page;
+    u32 offset;
+    u32 *reg = gic_model_find(addr, &page, &offset);
+    model.counts.reads++;
+
+    if (page == model.gicd)
+    {
+        u32 set_offset;
+        BOOL clear;
+        if (gic_model_pair(offset, &set_offset, &clear))
+            return model.gicd[set_offset / 4];
+    }
+    else if (page == model.gicc && offset == GICC_IAR_OFF)
+    {
+        u32 iar = model.iar_head == model.iar_tail ? 1023 : model.iar[model.iar_head++ % IAR_QUEUE];
+        u32 irq = iar & 0x3FF;
+        if (irq < model.max_irqs)
+        {
+            model.gicd[GICD_ISPENDR_OFF / 4 + irq / 32] &= ~(1u << (irq % 32));
+            model.gicd[GICD_ISACTIVER_OFF / 4 + irq / 32] |= 1u << (irq % 32);
+        }
+        return iar;
+    }
+    else if (page == model.systimer && offset == SYSTIMER_CLO_OFF)
+        return model.clock;
+
+    return *reg;
+}
+
+void mmio_write32(u32 value, volatile void *addr)
+{
+    u32 *page;
+    u32 offset;
+    u32 *reg = gic_model_find(addr, &page, &offset);
+    model.counts.writes++;
+
+    if (page == model.gicd)
+    {
+        u32 set_offset;
+        BOOL clear;
+        if (gic_model_pair(offset, &set_offset, &clear))
+        {
+            if (clear)
+                model.gicd[set_offset / 4] &= ~value;
+            else
+                model.gicd[set_offset / 4] |= value;
+            model.gicd[GICD_ISENABLER_OFF / 4] |= 0x0000FFFF; // SGI enables stay set
+            return;
+        }
+        if (offset == GICD_TYPER_OFF || offset == GICD_IIDR_OFF)
+            return; // read-only
+    }
+    else if (page == model.gicc && offset == GICC_EOIR_OFF)
+    {
+        u32 irq = value & 0x3FF;
+        if (irq < model.max_irqs)
+            model.gicd[GICD_ISACTIVER_OFF / 4 + irq / 32] &= ~(1u << (irq % 32));
+        if (model.eoi_count < GIC_MODEL_EOI_LOG)
+            model.eoi[model.eoi_count] = value;
+        model.eoi_count++;
+        return;
+    }
+    else if (page == model.gicc && (offset == GICC_IAR_OFF || offset == GICC_IIDR_OFF))
+        return; // read-only
+    else if (page == model.systimer && offset == SYSTIMER_CLO_OFF)
+        return;
+
+    *reg = value;
+}
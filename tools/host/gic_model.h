@@ -0,0 +1,52 @@
+// SPDX-License-Identifier: MPL-2.0 OR GPL-2.0+
+#ifndef _GIC_MODEL_H
+#define _GIC_MODEL_H
+
+/* Register-level model of the parts of a GIC-400 and the BCM2835 system
+ * timer the library touches. Every access made through mmio_read32() and
+ * mmio_write32() lands here and is counted; byte accesses (IPRIORITYR,
+ * ITARGETSR) go straight to the backing store, as they do on hardware.
+ *
+ * GICC_IAR returns the values queued with gic_model_push_iar() in order,
+ * then 1023 (spurious). An acknowledged IRQ below the implemented count
+ * becomes active and stops pending; a GICC_EOIR write deactivates it and
+ * is logged.
+ */
+
+#include <exec/types.h>
+#include <types.h>
+
+#define GIC_MODEL_EOI_LOG 64
+
+struct gic_model_counts
+{
+    u32 reads;
+    u32 writes;
+};
+
+void gic_model_reset(u32 it_lines);
+
+void *gic_model_gicd(void);
+void *gic_model_gicc(void);
+void *gic_model_systimer(void);
+
+void gic_model_push_iar(u32 iar);
+u32 gic_model_eoi_count(void);
+u32 gic_model_eoi(u32 index);
+void gic_model_clear_log(void);
+
+BOOL gic_model_pending(u32 irq);
+BOOL gic_model_enabled(u32 irq);
+BOOL gic_model_active(u32 irq);
+void gic_model_set_pending(u32 irq);
+u8 gic_model_priority(u32 irq);
+
+/* System timer counter (SYSTIMER_CLO), in 1 MHz ticks */
+void gic_model_set_clock(u32 now);
+u32 gic_model_clock(void);
+void gic_model_advance(u32 ticks);
+
+struct gic_model_counts gic_model_counts(void);
+void gic_model_clear_counts(void);
+
+#endif /* _GIC_MODEL_H */
@@ -0,0 +1,41 @@
+// SPDX-License-Identifier: MPL-2.0 OR GPL-2.0+
+/* Host stand-in for the Amiga clib/exec_protos.h (tools/ builds only).
+ * Implemented by tools/host/exec.c.
+ */
+#ifndef CLIB_EXEC_PROTOS_H
+#define CLIB_EXEC_PROTOS_H
+
+#include <exec/types.h>
+#include <exec/execbase.h>
+#include <exec/interrupts.h>
+#include <exec/lists.h>
+#include <exec/semaphores.h>
+
+APTR AllocMem(ULONG byteSize, ULONG requirements);
+void FreeMem(APTR memoryBlock, ULONG byteSize);
+void Disable(void);
+void Enable(void);
+void Forbid(void);
+void Permit(void);
+void AddIntServer(LONG intNumber, struct Interrupt *interrupt);
+void RemIntServer(LONG intNumber, struct Interrupt *interrupt);
+void Cause(struct Interrupt *interrupt);
+void Insert(struct List *list, struct Node *node, struct Node *pred);
+void AddHead(struct List *list, struct Node *node);
+void AddTail(struct List *list, struct Node *node);
+void Remove(struct Node *node);
+void NewList(struct List *list);
+void InitSemaphore(struct SignalSemaphore *semaphore);
+void ObtainSemaphore(struct SignalSemaphore *semaphore);
+void ReleaseSemaphore(struct SignalSemaphore *semaphore);
+ULONG AttemptSemaphore(struct SignalSemaphore *semaphore);
+void AddSemaphore(struct SignalSemaphore *semaphore);
+void RemSemaphore(struct SignalSemaphore *semaphore);
+struct SignalSemaphore *FindSemaphore(CONST_STRPTR name);
+struct Task *FindTask(CONST_STRPTR name);
+void Signal(struct Task *task, ULONG signals);
+APTR OpenResource(CONST_STRPTR resName);
+struct Library *OpenLibrary(CONST_STRPTR libName, ULONG version);
+void CloseLibrary(struct Library *library);
+
+#endif /* CLIB_EXEC_PROTOS_H */
@@ -0,0 +1,19 @@
+// SPDX-License-Identifier: MPL-2.0 OR GPL-2.0+
+/* Host stand-in for the emu68-common debug.h (tools/ builds only). Output
+ * goes to stderr when GIC400_HOST_LOG is set in the environment.
+ */
+#ifndef _DEBUG_H
+#define _DEBUG_H
+
+void Kprintf(const char *format, ...);
+
+#ifdef DEBUG_HIGH
+#define KprintfH(...) Kprintf(__VA_ARGS__)
+#else
+#define KprintfH(...) \
+    do                \
+    {                 \
+    } while (0)
+#endif
+
+#endif /* _DEBUG_H */
@@ -0,0 +1,34 @@
+// SPDX-License-Identifier: MPL-2.0 OR GPL-2.0+
+/* Host stand-in for the devicetree.resource API (tools/ builds only). The
+ * tree is the fixed one in tools/host/exec.c: a root node and the GIC.
+ */
+#ifndef _DEVTREE_H
+#define _DEVTREE_H
+
+#include <exec/types.h>
+
+APTR host_DT_OpenKey(CONST_STRPTR name);
+void host_DT_CloseKey(APTR key);
+APTR host_DT_GetChild(APTR key, APTR prev);
+APTR host_DT_GetParent(APTR key);
+APTR host_DT_FindProperty(APTR key, CONST_STRPTR name);
+ULONG host_DT_GetPropLen(APTR property);
+APTR host_DT_GetPropValue(APTR property);
+APTR host_DT_FindByPHandle(APTR key, ULONG phandle);
+ULONG host_DT_GetPropertyValueULONG(APTR key, CONST_STRPTR name, ULONG def, BOOL check_parent);
+void host_DT_TranslateAddress(APTR *address, APTR key);
+unsigned long long DT_GetNumber(const ULONG *cells, ULONG count);
+
+#define DT_OpenKey(name) ((void)DeviceTreeBase, host_DT_OpenKey(name))
+#define DT_CloseKey(key) ((void)DeviceTreeBase, host_DT_CloseKey(key))
+#define DT_GetChild(key, prev) ((void)DeviceTreeBase, host_DT_GetChild((key), (prev)))
+#define DT_GetParent(key) ((void)DeviceTreeBase, host_DT_GetParent(key))
+#define DT_FindProperty(key, name) ((void)DeviceTreeBase, host_DT_FindProperty((key), (name)))
+#define DT_GetPropLen(property) ((void)DeviceTreeBase, host_DT_GetPropLen(property))
+#define DT_GetPropValue(property) ((void)DeviceTreeBase, host_DT_GetPropValue(property))
+#define DT_FindByPHandle(key, phandle) ((void)DeviceTreeBase, host_DT_FindByPHandle((key), (phandle)))
+#define DT_GetPropertyValueULONG(key, name, def, check_parent) \
+    ((void)DeviceTreeBase, host_DT_GetPropertyValueULONG((key), (CONST_STRPTR)(name), (def), (check_parent)))
+#define DT_TranslateAddress(address, key) ((void)DeviceTreeBase, host_DT_TranslateAddress((address), (key)))
+
+#endif /* _DEVTREE_H */
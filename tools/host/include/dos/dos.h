@@ -0,0 +1,13 @@
+// SPDX-License-Identifier: MPL-2.0 OR GPL-2.0+
+/* Host stand-in for the Amiga dos/dos.h (tools/ builds only). */
+#ifndef DOS_DOS_H
+#define DOS_DOS_H
+
+#include <exec/types.h>
+
+#define MODE_OLDFILE 1005
+#define OFFSET_BEGINNING -1
+#define OFFSET_CURRENT 0
+#define OFFSET_END 1
+
+#endif /* DOS_DOS_H */
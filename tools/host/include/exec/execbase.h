@@ -0,0 +1,15 @@
+// SPDX-License-Identifier: MPL-2.0 OR GPL-2.0+
+/* Host stand-in for the Amiga exec/execbase.h (tools/ builds only). */
+#ifndef EXEC_EXECBASE_H
+#define EXEC_EXECBASE_H
+
+#include <exec/libraries.h>
+#include <exec/tasks.h>
+
+struct ExecBase
+{
+    struct Library LibNode;
+    struct Task *ThisTask;
+};
+
+#endif /* EXEC_EXECBASE_H */
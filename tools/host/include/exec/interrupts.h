@@ -0,0 +1,17 @@
+// SPDX-License-Identifier: MPL-2.0 OR GPL-2.0+
+/* Host stand-in for the Amiga exec/interrupts.h (tools/ builds only).
+ * is_Code of a host server is a gic400_host_server (see gic400_host.h).
+ */
+#ifndef EXEC_INTERRUPTS_H
+#define EXEC_INTERRUPTS_H
+
+#include <exec/nodes.h>
+
+struct Interrupt
+{
+    struct Node is_Node;
+    APTR is_Data;
+    VOID (*is_Code)();
+};
+
+#endif /* EXEC_INTERRUPTS_H */
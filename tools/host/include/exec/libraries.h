@@ -0,0 +1,24 @@
+// SPDX-License-Identifier: MPL-2.0 OR GPL-2.0+
+/* Host stand-in for the Amiga exec/libraries.h (tools/ builds only). */
+#ifndef EXEC_LIBRARIES_H
+#define EXEC_LIBRARIES_H
+
+#include <exec/nodes.h>
+
+struct Library
+{
+    struct Node lib_Node;
+    UBYTE lib_Flags;
+    UBYTE lib_pad;
+    UWORD lib_NegSize;
+    UWORD lib_PosSize;
+    UWORD lib_Version;
+    UWORD lib_Revision;
+    APTR lib_IdString;
+    ULONG lib_Sum;
+    UWORD lib_OpenCnt;
+};
+
+#define LIBF_DELEXP (1 << 3)
+
+#endif /* EXEC_LIBRARIES_H */
@@ -0,0 +1,12 @@
+// SPDX-License-Identifier: MPL-2.0 OR GPL-2.0+
+/* Host stand-in for the Amiga exec/memory.h (tools/ builds only). */
+#ifndef EXEC_MEMORY_H
+#define EXEC_MEMORY_H
+
+#include <exec/types.h>
+
+#define MEMF_ANY 0L
+#define MEMF_PUBLIC (1L << 0)
+#define MEMF_CLEAR (1L << 16)
+
+#endif /* EXEC_MEMORY_H */
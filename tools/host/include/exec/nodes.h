@@ -0,0 +1,29 @@
+// SPDX-License-Identifier: MPL-2.0 OR GPL-2.0+
+/* Host stand-in for the Amiga exec/nodes.h (tools/ builds only). */
+#ifndef EXEC_NODES_H
+#define EXEC_NODES_H
+
+#include <exec/types.h>
+
+struct Node
+{
+    struct Node *ln_Succ;
+    struct Node *ln_Pred;
+    UBYTE ln_Type;
+    BYTE ln_Pri;
+    char *ln_Name;
+};
+
+struct MinNode
+{
+    struct MinNode *mln_Succ;
+    struct MinNode *mln_Pred;
+};
+
+#define NT_TASK 1
+#define NT_INTERRUPT 2
+#define NT_LIBRARY 9
+#define NT_PROCESS 13
+#define NT_SIGNALSEM 15
+
+#endif /* EXEC_NODES_H */
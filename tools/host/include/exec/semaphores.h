@@ -0,0 +1,18 @@
+// SPDX-License-Identifier: MPL-2.0 OR GPL-2.0+
+/* Host stand-in for the Amiga exec/semaphores.h (tools/ builds only). */
+#ifndef EXEC_SEMAPHORES_H
+#define EXEC_SEMAPHORES_H
+
+#include <exec/lists.h>
+#include <exec/tasks.h>
+
+struct SignalSemaphore
+{
+    struct Node ss_Link;
+    WORD ss_NestCount;
+    struct MinList ss_WaitQueue;
+    struct Task *ss_Owner;
+    WORD ss_QueueCount;
+};
+
+#endif /* EXEC_SEMAPHORES_H */
@@ -0,0 +1,13 @@
+// SPDX-License-Identifier: MPL-2.0 OR GPL-2.0+
+/* Host stand-in for the Amiga exec/tasks.h (tools/ builds only). */
+#ifndef EXEC_TASKS_H
+#define EXEC_TASKS_H
+
+#include <exec/nodes.h>
+
+struct Task
+{
+    struct Node tc_Node;
+};
+
+#endif /* EXEC_TASKS_H */
@@ -0,0 +1,25 @@
+// SPDX-License-Identifier: MPL-2.0 OR GPL-2.0+
+/* Host stand-in for the Amiga exec/types.h (tools/ builds only). */
+#ifndef EXEC_TYPES_H
+#define EXEC_TYPES_H
+
+#include <stddef.h>
+
+typedef unsigned int ULONG;
+typedef int LONG;
+typedef unsigned short UWORD;
+typedef short WORD;
+typedef unsigned char UBYTE;
+typedef signed char BYTE;
+typedef short BOOL;
+typedef void *APTR;
+typedef char *STRPTR;
+typedef const char *CONST_STRPTR;
+typedef ULONG BPTR;
+
+#define VOID void
+#define CONST const
+#define TRUE 1
+#define FALSE 0
+
+#endif /* EXEC_TYPES_H */
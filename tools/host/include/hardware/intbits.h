@@ -0,0 +1,9 @@
+// SPDX-License-Identifier: MPL-2.0 OR GPL-2.0+
+/* Host stand-in for the Amiga hardware/intbits.h (tools/ builds only). */
+#ifndef HARDWARE_INTBITS_H
+#define HARDWARE_INTBITS_H
+
+#define INTB_SOFTINT 2
+#define INTB_EXTER 13
+
+#endif /* HARDWARE_INTBITS_H */
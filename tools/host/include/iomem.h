@@ -0,0 +1,13 @@
+// SPDX-License-Identifier: MPL-2.0 OR GPL-2.0+
+/* Host stand-in for the emu68-common iomem.h (tools/ builds only). Every
+ * 32-bit access goes to the register model in tools/host/gic_model.c.
+ */
+#ifndef _IOMEM_H
+#define _IOMEM_H
+
+#include <types.h>
+
+u32 mmio_read32(volatile void *addr);
+void mmio_write32(u32 value, volatile void *addr);
+
+#endif /* _IOMEM_H */
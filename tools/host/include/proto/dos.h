@@ -0,0 +1,21 @@
+// SPDX-License-Identifier: MPL-2.0 OR GPL-2.0+
+/* Host stand-in for the Amiga proto/dos.h (tools/ builds only). The host
+ * exec never opens dos.library, so these are only declared.
+ */
+#ifndef PROTO_DOS_H
+#define PROTO_DOS_H
+
+#include <dos/dos.h>
+#include <exec/libraries.h>
+
+BPTR host_Open(struct Library *base, CONST_STRPTR name, LONG mode);
+LONG host_Close(struct Library *base, BPTR file);
+LONG host_Read(struct Library *base, BPTR file, APTR buffer, LONG length);
+LONG host_Seek(struct Library *base, BPTR file, LONG position, LONG mode);
+
+#define Open(name, mode) host_Open(DOSBase, (name), (mode))
+#define Close(file) host_Close(DOSBase, (file))
+#define Read(file, buffer, length) host_Read(DOSBase, (file), (buffer), (length))
+#define Seek(file, position, mode) host_Seek(DOSBase, (file), (position), (mode))
+
+#endif /* PROTO_DOS_H */
@@ -0,0 +1,8 @@
+// SPDX-License-Identifier: MPL-2.0 OR GPL-2.0+
+/* Host stand-in for the Amiga proto/exec.h (tools/ builds only). */
+#ifndef PROTO_EXEC_H
+#define PROTO_EXEC_H
+
+#include <clib/exec_protos.h>
+
+#endif /* PROTO_EXEC_H */
@@ -0,0 +1,10 @@
+// SPDX-License-Identifier: MPL-2.0 OR GPL-2.0+
+/* Host stand-in for the emu68-common strutil.h (tools/ builds only). */
+#ifndef _STRUTIL_H
+#define _STRUTIL_H
+
+#include <exec/types.h>
+
+LONG _Strnicmp(CONST_STRPTR a, CONST_STRPTR b, LONG length);
+
+#endif /* _STRUTIL_H */
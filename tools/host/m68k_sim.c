@@ -0,0 +1,998 @@
+// SPDX-License-Identifier: MPL-2.0 OR GPL-2.0+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "m68k_sim.h"
+#include <iomem.h>
+
+/* Instructions live at CODE_BASE + 4 * index in the simulated address space */
+#define CODE_BASE 0x00F00000u
+#define RETURN_TOKEN 0xFFFFFFF0u
+#define MAX_STEPS 100000
+#define NAME_MAX 64
+
+enum ea_mode
+{
+    EA_NONE,
+    EA_DREG,
+    EA_AREG,
+    EA_IND,
+    EA_POSTINC,
+    EA_PREDEC,
+    EA_DISP,
+    EA_INDEX,
+    EA_ABS,
+    EA_IMM,
+    EA_SYMBOL,
+};
+
+struct ea
+{
+    enum ea_mode mode;
+    u8 reg;
+    u8 index_reg;
+    BOOL index_is_a;
+    BOOL index_long;
+    u8 scale;
+    s32 value;
+    char symbol[NAME_MAX];
+};
+
+enum op
+{
+    OP_MOVE,
+    OP_MOVEQ,
+    OP_ROR,
+    OP_ROL,
+    OP_LSL,
+    OP_LSR,
+    OP_SWAP,
+    OP_AND,
+    OP_OR,
+    OP_ADD,
+    OP_SUB,
+    OP_CMP,
+    OP_TST,
+    OP_CLR,
+    OP_LEA,
+    OP_BCC,
+    OP_JSR,
+    OP_JMP,
+    OP_RTS,
+};
+
+enum cond
+{
+    CC_T,
+    CC_HI,
+    CC_LS,
+    CC_CC,
+    CC_CS,
+    CC_NE,
+    CC_EQ,
+    CC_VC,
+    CC_VS,
+    CC_PL,
+    CC_MI,
+    CC_GE,
+    CC_LT,
+    CC_GT,
+    CC_LE,
+};
+
+struct insn
+{
+    enum op op;
+    u8 size; // 1, 2 or 4
+    enum cond cond;
+    struct ea src;
+    struct ea dst;
+    u32 line;
+};
+
+struct label
+{
+    char name[NAME_MAX];
+    u32 index;
+};
+
+struct m68k_sim_program
+{
+    struct insn *insns;
+    u32 count;
+    struct label *labels;
+    u32 label_count;
+    const char *const *externs;
+    const u32 *extern_addresses;
+    u32 extern_count;
+};
+
+/* Parsing */
+
+static char *trim(char *s)
+{
+    while (isspace((unsigned char)*s))
+        s++;
+    char *end = s + strlen(s);
+    while (end > s && isspace((unsigned char)end[-1]))
+        *--end = 0;
+    return s;
+}
+
+static BOOL parse_number(const char *s, s32 *value)
+{
+    char *end;
+    long v = strtol(s, &end, 0);
+    if (end == s || *trim(end) != 0)
+        return FALSE;
+    *value = (s32)v;
+    return TRUE;
+}
+
+static BOOL parse_reg(const char *s, BOOL *is_a, u8 *reg)
+{
+    if (strcmp(s, "%sp") == 0)
+        return *is_a = TRUE, *reg = 7, TRUE;
+    if (strcmp(s, "%fp") == 0)
+        return *is_a = TRUE, *reg = 6, TRUE;
+    if (s[0] != '%' || (s[1] != 'd' && s[1] != 'a') || s[2] < '0' || s[2] > '7' || s[3] != 0)
+        return FALSE;
+    *is_a = s[1] == 'a';
+    *reg = (u8)(s[2] - '0');
+    return TRUE;
+}
+
+/* "%aN" or "%aN,%Rm[.w|.l][*scale]" inside parentheses */
+static BOOL parse_indirect(char *inner, struct ea *ea)
+{
+    BOOL is_a;
+    char *comma = strchr(inner, ',');
+    if (comma)
+        *comma = 0;
+    if (!parse_reg(trim(inner), &is_a, &ea->reg) || !is_a)
+        return FALSE;
+    if (!comma)
+        return TRUE;
+
+    char *index = trim(comma + 1);
+    ea->mode = EA_INDEX;
+    ea->scale = 1;
+    ea->index_long = FALSE;
+    char *star = strchr(index, '*');
+    if (star)
+    {
+        *star = 0;
+        s32 scale;
+        if (!parse_number(star + 1, &scale) || (scale != 1 && scale != 2 && scale != 4 && scale != 8))
+            return FALSE;
+        ea->scale = (u8)scale;
+    }
+    char *dot = strchr(index, '.');
+    if (dot)
+    {
+        *dot = 0;
+        if (strcmp(dot + 1, "l") == 0)
+            ea->index_long = TRUE;
+        else if (strcmp(dot + 1, "w") != 0)
+            return FALSE;
+    }
+    return parse_reg(trim(index), &ea->index_is_a, &ea->index_reg);
+}
+
+static BOOL parse_ea(char *text, struct ea *ea)
+{
+    memset(ea, 0, sizeof(*ea));
+    char *s = trim(text);
+    size_t len = strlen(s);
+    BOOL is_a;
+
+    if (s[0] == '#')
+    {
+        ea->mode = EA_IMM;
+        return parse_number(s + 1, &ea->value);
+    }
+    if (parse_reg(s, &is_a, &ea->reg))
+    {
+        ea->mode = is_a ? EA_AREG : EA_DREG;
+        return TRUE;
+    }
+    if (s[0] == '-' && s[1] == '(' && s[len - 1] == ')')
+    {
+        s[len - 1] = 0;
+        ea->mode = EA_PREDEC;
+        return parse_reg(trim(s + 2), &is_a, &ea->reg) && is_a;
+    }
+    char *open = strchr(s, '(');
+    if (open)
+    {
+        BOOL postinc = s[len - 1] == '+';
+        char *close = strrchr(s, ')');
+        if (!close || (postinc ? close != s + len - 2 : close != s + len - 1))
+            return FALSE;
+        *close = 0;
+        *open = 0;
+        ea->mode = postinc ? EA_POSTINC : (open == s ? EA_IND : EA_DISP);
+        if (open != s && !parse_number(s, &ea->value))
+            return FALSE;
+        if (!parse_indirect(open + 1, ea))
+            return FALSE;
+        return !(postinc && ea->mode == EA_INDEX);
+    }
+    if (isdigit((unsigned char)s[0]) || s[0] == '-')
+    {
+        ea->mode = EA_ABS;
+        if (len > 2 && s[len - 2] == '.' && (s[len - 1] == 'w' || s[len - 1] == 'l'))
+            s[len - 2] = 0;
+        return parse_number(s, &ea->value);
+    }
+    if (isalpha((unsigned char)s[0]) || s[0] == '_' || s[0] == '.')
+    {
+        ea->mode = EA_SYMBOL;
+        snprintf(ea->symbol, sizeof(ea->symbol), "%s", s);
+        return TRUE;
+    }
+    return FALSE;
+}
+
+static BOOL parse_cond(const char *name, enum cond *cond)
+{
+    static const struct
+    {
+        const char *name;
+        enum cond cond;
+    } table[] = {
+        {"ra", CC_T}, {"hi", CC_HI}, {"ls", CC_LS}, {"cc", CC_CC}, {"hs", CC_CC}, {"cs", CC_CS},
+        {"lo", CC_CS}, {"ne", CC_NE}, {"eq", CC_EQ}, {"vc", CC_VC}, {"vs", CC_VS}, {"pl", CC_PL},
+        {"mi", CC_MI}, {"ge", CC_GE}, {"lt", CC_LT}, {"gt", CC_GT}, {"le", CC_LE},
+    };
+    for (u32 i = 0; i < sizeof(table) / sizeof(table[0]); i++)
+    {
+        if (strcmp(name, table[i].name) == 0)
+        {
+            *cond = table[i].cond;
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+static BOOL parse_mnemonic(const char *mnemonic, struct insn *insn)
+{
+    static const struct
+    {
+        const char *name;
+        enum op op;
+    } table[] = {
+        {"move", OP_MOVE}, {"movea", OP_MOVE}, {"moveq", OP_MOVEQ}, {"ror", OP_ROR}, {"rol", OP_ROL},
+        {"lsl", OP_LSL}, {"lsr", OP_LSR}, {"swap", OP_SWAP}, {"and", OP_AND}, {"andi", OP_AND},
+        {"or", OP_OR}, {"ori", OP_OR}, {"add", OP_ADD}, {"adda", OP_ADD}, {"addi", OP_ADD},
+        {"addq", OP_ADD}, {"sub", OP_SUB}, {"suba", OP_SUB}, {"subi", OP_SUB}, {"subq", OP_SUB},
+        {"cmp", OP_CMP}, {"cmpa", OP_CMP}, {"cmpi", OP_CMP}, {"tst", OP_TST}, {"clr", OP_CLR},
+        {"lea", OP_LEA}, {"jsr", OP_JSR}, {"jmp", OP_JMP}, {"rts", OP_RTS},
+    };
+
+    char base[16];
+    const char *dot = strchr(mnemonic, '.');
+    size_t len = dot ? (size_t)(dot - mnemonic) : strlen(mnemonic);
+    if (len >= sizeof(base))
+        return FALSE;
+    memcpy(base, mnemonic, len);
+    base[len] = 0;
+
+    insn->size = 2; // the assembler's default
+    if (dot)
+    {
+        if (strcmp(dot, ".b") == 0)
+            insn->size = 1;
+        else if (strcmp(dot, ".l") == 0)
+            insn->size = 4;
+        else if (strcmp(dot, ".w") != 0 && strcmp(dot, ".s") != 0)
+            return FALSE;
+    }
+
+    for (u32 i = 0; i < sizeof(table) / sizeof(table[0]); i++)
+    {
+        if (strcmp(base, table[i].name) == 0)
+        {
+            insn->op = table[i].op;
+            if (insn->op == OP_MOVEQ || insn->op == OP_SWAP || insn->op == OP_LEA || insn->op == OP_JSR || insn->op == OP_JMP)
+                insn->size = 4;
+            return TRUE;
+        }
+    }
+    if (base[0] == 'b' && parse_cond(base + 1, &insn->cond))
+    {
+        insn->op = OP_BCC;
+        return TRUE;
+    }
+    return FALSE;
+}
+
+/* Split "a,b" at the top-level comma */
+static int split_operands(char *operands, char **first, char **second)
+{
+    int depth = 0;
+    *first = operands;
+    *second = NULL;
+    for (char *p = operands; *p; p++)
+    {
+        if (*p == '(')
+            depth++;
+        else if (*p == ')')
+            depth--;
+        else if (*p == ',' && depth == 0)
+        {
+            *p = 0;
+            *second = p + 1;
+            return 2;
+        }
+    }
+    return *trim(operands) ? 1 : 0;
+}
+
+static int load_error(const char *path, u32 line, const char *what, const char *text)
+{
+    fprintf(stderr, "%s:%u: %s: %s\n", path, line, what, text);
+    return -1;
+}
+
+int m68k_sim_load(struct m68k_sim *sim, const char *path, const char *const *externs, const u32 *extern_addresses, u32 extern_count)
+{
+    FILE *file = fopen(path, "r");
+    if (!file)
+    {
+        perror(path);
+        return -1;
+    }
+
+    struct m68k_sim_program *program = calloc(1, sizeof(*program));
+    u32 insn_space = 64;
+    u32 label_space = 16;
+    program->insns = calloc(insn_space, sizeof(struct insn));
+    program->labels = calloc(label_space, sizeof(struct label));
+    program->externs = externs;
+    program->extern_addresses = extern_addresses;
+    program->extern_count = extern_count;
+    sim->program = program;
+
+    char buffer[256];
+    u32 line = 0;
+    while (fgets(buffer, sizeof(buffer), file))
+    {
+        line++;
+        char *comment = strchr(buffer, '|');
+        if (comment)
+            *comment = 0;
+        char *text = trim(buffer);
+
+        /* labels, possibly followed by an instruction */
+        char *colon = strchr(text, ':');
+        if (colon && !strchr(text, '(') && !isspace((unsigned char)*text))
+        {
+            *colon = 0;
+            if (program->label_count == label_space)
+                program->labels = realloc(program->labels, (label_space *= 2) * sizeof(struct label));
+            struct label *label = &program->labels[program->label_count++];
+            snprintf(label->name, sizeof(label->name), "%s", trim(text));
+            label->index = program->count;
+            text = trim(colon + 1);
+        }
+        if (*text == 0 || *text == '.')
+            continue; // empty or directive
+
+        char *mnemonic = text;
+        char *operands = text;
+        while (*operands && !isspace((unsigned char)*operands))
+            operands++;
+        if (*operands)
+            *operands++ = 0;
+
+        if (program->count == insn_space)
+            program->insns = realloc(program->insns, (insn_space *= 2) * sizeof(struct insn));
+        struct insn *insn = &program->insns[program->count];
+        memset(insn, 0, sizeof(*insn));
+        insn->line = line;
+        if (!parse_mnemonic(mnemonic, insn))
+        {
+            fclose(file);
+            return load_error(path, line, "unsupported instruction", mnemonic);
+        }
+
+        char *first, *second;
+        int count = split_operands(operands, &first, &second);
+        int wanted = insn->op == OP_RTS ? 0 : (insn->op == OP_SWAP || insn->op == OP_TST || insn->op == OP_CLR || insn->op == OP_BCC || insn->op == OP_JSR || insn->op == OP_JMP) ? 1 : 2;
+        if (count != wanted)
+        {
+            fclose(file);
+            return load_error(path, line, "wrong operand count", mnemonic);
+        }
+        if ((count >= 1 && !parse_ea(first, count == 2 ? &insn->src : &insn->dst)) || (count == 2 && !parse_ea(second, &insn->dst)))
+        {
+            fclose(file);
+            return load_error(path, line, "unsupported operand", operands);
+        }
+        program->count++;
+    }
+    fclose(file);
+
+    /* every symbol must resolve to a label or an extern */
+    for (u32 i = 0; i < program->count; i++)
+    {
+        const struct ea *ea = &program->insns[i].dst;
+        if (ea->mode != EA_SYMBOL)
+            continue;
+        BOOL found = FALSE;
+        for (u32 j = 0; j < program->label_count && !found; j++)
+            found = strcmp(program->labels[j].name, ea->symbol) == 0;
+        for (u32 j = 0; j < extern_count && !found; j++)
+            found = strcmp(externs[j], ea->symbol) == 0;
+        if (!found)
+            return load_error(path, program->insns[i].line, "undefined symbol", ea->symbol);
+    }
+    return 0;
+}
+
+void m68k_sim_free(struct m68k_sim *sim)
+{
+    if (!sim->program)
+        return;
+    free(sim->program->insns);
+    free(sim->program->labels);
+    free(sim->program);
+    sim->program = NULL;
+}
+
+/* Memory */
+
+static BOOL in_mmio(struct m68k_sim *sim, u32 address)
+{
+    return sim->mmio_size && address >= sim->mmio_base && address - sim->mmio_base < sim->mmio_size;
+}
+
+static int fault(struct m68k_sim *sim, const char *what, u32 address)
+{
+    (void)sim;
+    fprintf(stderr, "m68k_sim: %s at %08x\n", what, address);
+    return -1;
+}
+
+static int mem_read(struct m68k_sim *sim, u32 address, u8 size, u32 *value)
+{
+    if (in_mmio(sim, address))
+    {
+        if (size != 4 || (address & 3))
+            return fault(sim, "non-longword MMIO read", address);
+        sim->stats.mmio_reads++;
+        *value = __builtin_bswap32(mmio_read32(sim->mmio_host + (address - sim->mmio_base)));
+        return 0;
+    }
+    if (address > (u32)(M68K_SIM_RAM - size))
+        return fault(sim, "read outside RAM", address);
+    sim->stats.ram_reads++;
+    u32 v = 0;
+    for (u8 i = 0; i < size; i++)
+        v = (v << 8) | sim->ram[address + i];
+    *value = v;
+    return 0;
+}
+
+static int mem_write(struct m68k_sim *sim, u32 address, u8 size, u32 value)
+{
+    if (in_mmio(sim, address))
+    {
+        if (size != 4 || (address & 3))
+            return fault(sim, "non-longword MMIO write", address);
+        sim->stats.mmio_writes++;
+        mmio_write32(__builtin_bswap32(value), sim->mmio_host + (address - sim->mmio_base));
+        return 0;
+    }
+    if (address > (u32)(M68K_SIM_RAM - size))
+        return fault(sim, "write outside RAM", address);
+    sim->stats.ram_writes++;
+    for (u8 i = 0; i < size; i++)
+        sim->ram[address + i] = (u8)(value >> (8 * (size - 1 - i)));
+    return 0;
+}
+
+u32 m68k_sim_read32(struct m68k_sim *sim, u32 address)
+{
+    return ((u32)sim->ram[address] << 24) | ((u32)sim->ram[address + 1] << 16) | ((u32)sim->ram[address + 2] << 8) | sim->ram[address + 3];
+}
+
+void m68k_sim_write32(struct m68k_sim *sim, u32 address, u32 value)
+{
+    for (u32 i = 0; i < 4; i++)
+        sim->ram[address + i] = (u8)(value >> (24 - 8 * i));
+}
+
+void m68k_sim_write8(struct m68k_sim *sim, u32 address, u8 value)
+{
+    sim->ram[address] = value;
+}
+
+static int push(struct m68k_sim *sim, u32 value)
+{
+    sim->a[7] -= 4;
+    return mem_write(sim, sim->a[7], 4, value);
+}
+
+static int pop(struct m68k_sim *sim, u32 *value)
+{
+    int ret = mem_read(sim, sim->a[7], 4, value);
+    sim->a[7] += 4;
+    return ret;
+}
+
+/* Operands */
+
+static u32 mask(u8 size)
+{
+    return size == 4 ? 0xFFFFFFFFu : (1u << (8 * size)) - 1;
+}
+
+static u32 msb(u8 size)
+{
+    return 1u << (8 * size - 1);
+}
+
+static u32 sext(u32 value, u8 size)
+{
+    if (size == 4)
+        return value;
+    value &= mask(size);
+    return (value & msb(size)) ? value | ~mask(size) : value;
+}
+
+static int ea_address(struct m68k_sim *sim, const struct ea *ea, u8 size, u32 *address)
+{
+    u8 step = (size == 1 && ea->reg == 7) ? 2 : size; // the stack stays word aligned
+    switch (ea->mode)
+    {
+    case EA_IND:
+        *address = sim->a[ea->reg];
+        return 0;
+    case EA_POSTINC:
+        *address = sim->a[ea->reg];
+        sim->a[ea->reg] += step;
+        return 0;
+    case EA_PREDEC:
+        sim->a[ea->reg] -= step;
+        *address = sim->a[ea->reg];
+        return 0;
+    case EA_DISP:
+        *address = sim->a[ea->reg] + (u32)ea->value;
+        return 0;
+    case EA_INDEX:
+    {
+        u32 index = ea->index_is_a ? sim->a[ea->index_reg] : sim->d[ea->index_reg];
+        if (!ea->index_long)
+            index = sext(index, 2);
+        *address = sim->a[ea->reg] + (u32)ea->value + index * ea->scale;
+        return 0;
+    }
+    case EA_ABS:
+        *address = (u32)ea->value;
+        return 0;
+    default:
+        return fault(sim, "operand has no address", 0);
+    }
+}
+
+static int read_ea(struct m68k_sim *sim, const struct ea *ea, u8 size, u32 *value)
+{
+    switch (ea->mode)
+    {
+    case EA_DREG:
+        *value = sim->d[ea->reg] & mask(size);
+        return 0;
+    case EA_AREG:
+        *value = sim->a[ea->reg] & mask(size);
+        return 0;
+    case EA_IMM:
+        *value = (u32)ea->value & mask(size);
+        return 0;
+    default:
+    {
+        u32 address;
+        if (ea_address(sim, ea, size, &address) < 0)
+            return -1;
+        return mem_read(sim, address, size, value);
+    }
+    }
+}
+
+static int write_ea(struct m68k_sim *sim, const struct ea *ea, u8 size, u32 value)
+{
+    switch (ea->mode)
+    {
+    case EA_DREG:
+        sim->d[ea->reg] = (sim->d[ea->reg] & ~mask(size)) | (value & mask(size));
+        return 0;
+    case EA_AREG:
+        sim->a[ea->reg] = sext(value, size);
+        return 0;
+    case EA_IMM:
+    case EA_SYMBOL:
+        return fault(sim, "write to a constant", 0);
+    default:
+    {
+        u32 address;
+        if (ea_address(sim, ea, size, &address) < 0)
+            return -1;
+        return mem_write(sim, address, size, value);
+    }
+    }
+}
+
+static void set_nz(struct m68k_sim *sim, u32 value, u8 size)
+{
+    sim->n = (value & msb(size)) != 0;
+    sim->z = (value & mask(size)) == 0;
+}
+
+static void set_logic(struct m68k_sim *sim, u32 value, u8 size)
+{
+    set_nz(sim, value, size);
+    sim->v = FALSE;
+    sim->c = FALSE;
+}
+
+static BOOL test_cond(const struct m68k_sim *sim, enum cond cond)
+{
+    switch (cond)
+    {
+    case CC_T:
+        return TRUE;
+    case CC_HI:
+        return !sim->c && !sim->z;
+    case CC_LS:
+        return sim->c || sim->z;
+    case CC_CC:
+        return !sim->c;
+    case CC_CS:
+        return sim->c;
+    case CC_NE:
+        return !sim->z;
+    case CC_EQ:
+        return sim->z;
+    case CC_VC:
+        return !sim->v;
+    case CC_VS:
+        return sim->v;
+    case CC_PL:
+        return !sim->n;
+    case CC_MI:
+        return sim->n;
+    case CC_GE:
+        return sim->n == sim->v;
+    case CC_LT:
+        return sim->n != sim->v;
+    case CC_GT:
+        return !sim->z && sim->n == sim->v;
+    case CC_LE:
+        return sim->z || sim->n != sim->v;
+    }
+    return FALSE;
+}
+
+static u32 label_index(const struct m68k_sim_program *program, const char *name, BOOL *found)
+{
+    for (u32 i = 0; i < program->label_count; i++)
+    {
+        if (strcmp(program->labels[i].name, name) == 0)
+        {
+            *found = TRUE;
+            return program->labels[i].index;
+        }
+    }
+    *found = FALSE;
+    return 0;
+}
+
+/* Resolve a jsr/jmp operand to a simulated address */
+static int branch_target(struct m68k_sim *sim, const struct ea *ea, u32 *address)
+{
+    if (ea->mode == EA_SYMBOL)
+    {
+        BOOL found;
+        u32 index = label_index(sim->program, ea->symbol, &found);
+        if (found)
+        {
+            *address = CODE_BASE + 4 * index;
+            return 0;
+        }
+        for (u32 i = 0; i < sim->program->extern_count; i++)
+        {
+            if (strcmp(sim->program->externs[i], ea->symbol) == 0)
+            {
+                *address = sim->program->extern_addresses[i];
+                return 0;
+            }
+        }
+        return fault(sim, "unresolved symbol", 0);
+    }
+    return ea_address(sim, ea, 4, address);
+}
+
+static BOOL code_index(const struct m68k_sim *sim, u32 address, u32 *index)
+{
+    if (address < CODE_BASE || (address & 3) || (address - CODE_BASE) / 4 >= sim->program->count)
+        return FALSE;
+    *index = (address - CODE_BASE) / 4;
+    return TRUE;
+}
+
+static int shift(struct m68k_sim *sim, const struct insn *insn)
+{
+    u32 count;
+    if (read_ea(sim, &insn->src, 4, &count) < 0)
+        return -1;
+    count &= 63;
+    if (insn->dst.mode != EA_DREG)
+        return fault(sim, "memory shift", 0);
+
+    u32 value = sim->d[insn->dst.reg] & mask(insn->size);
+    BOOL carry = FALSE;
+    for (u32 i = 0; i < count; i++)
+    {
+        switch (insn->op)
+        {
+        case OP_ROR:
+            carry = value & 1;
+            value = (value >> 1) | (carry ? msb(insn->size) : 0);
+            break;
+        case OP_ROL:
+            carry = (value & msb(insn->size)) != 0;
+            value = ((value << 1) | (carry ? 1 : 0)) & mask(insn->size);
+            break;
+        case OP_LSL:
+            carry = (value & msb(insn->size)) != 0;
+            value = (value << 1) & mask(insn->size);
+            break;
+        default:
+            carry = value & 1;
+            value >>= 1;
+            break;
+        }
+    }
+    sim->d[insn->dst.reg] = (sim->d[insn->dst.reg] & ~mask(insn->size)) | value;
+    set_nz(sim, value, insn->size);
+    sim->v = FALSE;
+    sim->c = count ? carry : FALSE;
+    if (count && (insn->op == OP_LSL || insn->op == OP_LSR))
+        sim->x = carry;
+    return 0;
+}
+
+static int arith(struct m68k_sim *sim, const struct insn *insn)
+{
+    u32 src, dst;
+    if (read_ea(sim, &insn->src, insn->size, &src) < 0)
+        return -1;
+
+    if (insn->dst.mode == EA_AREG && insn->op != OP_CMP)
+    {
+        u32 operand = sext(src, insn->size);
+        sim->a[insn->dst.reg] += insn->op == OP_ADD ? operand : (u32)-operand;
+        return 0; // address arithmetic leaves the flags alone
+    }
+
+    u8 size = insn->size;
+    if (insn->dst.mode == EA_AREG)
+    {
+        src = sext(src, size); // cmpa compares all 32 bits
+        size = 4;
+    }
+
+    /* read-modify-write operands must not step twice */
+    u32 address = 0;
+    BOOL memory = insn->dst.mode != EA_DREG && insn->dst.mode != EA_AREG;
+    if (memory)
+    {
+        if (ea_address(sim, &insn->dst, size, &address) < 0 || mem_read(sim, address, size, &dst) < 0)
+            return -1;
+    }
+    else if (read_ea(sim, &insn->dst, size, &dst) < 0)
+        return -1;
+
+    u32 result;
+    BOOL carry, overflow;
+    if (insn->op == OP_ADD)
+    {
+        result = (dst + src) & mask(size);
+        carry = ((u64)(dst & mask(size)) + (src & mask(size))) > mask(size);
+        overflow = (~(dst ^ src) & (dst ^ result) & msb(size)) != 0;
+    }
+    else
+    {
+        result = (dst - src) & mask(size);
+        carry = (src & mask(size)) > (dst & mask(size));
+        overflow = ((dst ^ src) & (dst ^ result) & msb(size)) != 0;
+    }
+
+    set_nz(sim, result, size);
+    sim->v = overflow;
+    sim->c = carry;
+    if (insn->op == OP_CMP)
+        return 0;
+    sim->x = carry;
+    if (memory)
+        return mem_write(sim, address, size, result);
+    return write_ea(sim, &insn->dst, size, result);
+}
+
+static int logic(struct m68k_sim *sim, const struct insn *insn)
+{
+    u32 src, dst, address = 0;
+    if (read_ea(sim, &insn->src, insn->size, &src) < 0)
+        return -1;
+    BOOL memory = insn->dst.mode != EA_DREG;
+    if (memory)
+    {
+        if (ea_address(sim, &insn->dst, insn->size, &address) < 0 || mem_read(sim, address, insn->size, &dst) < 0)
+            return -1;
+    }
+    else
+        dst = sim->d[insn->dst.reg] & mask(insn->size);
+
+    u32 result = insn->op == OP_AND ? dst & src : dst | src;
+    set_logic(sim, result, insn->size);
+    if (memory)
+        return mem_write(sim, address, insn->size, result);
+    return write_ea(sim, &insn->dst, insn->size, result);
+}
+
+static int call(struct m68k_sim *sim, u32 target, u32 return_address, u32 *pc)
+{
+    u32 index;
+    if (push(sim, return_address) < 0)
+        return -1;
+    if (code_index(sim, target, &index))
+    {
+        *pc = index;
+        return 0;
+    }
+    if (!sim->trap)
+        return fault(sim, "call outside the program", target);
+
+    sim->trap(sim, target, sim->trap_user);
+    u32 back;
+    if (pop(sim, &back) < 0)
+        return -1;
+    if (back != return_address)
+        return fault(sim, "trap changed the return address", back);
+    return 0;
+}
+
+int m68k_sim_call(struct m68k_sim *sim, const char *label)
+{
+    BOOL found;
+    u32 pc = label_index(sim->program, label, &found);
+    if (!found)
+        return fault(sim, "no such label", 0);
+
+    u32 entry_sp = sim->a[7];
+    if (push(sim, RETURN_TOKEN) < 0)
+        return -1;
+
+    for (u32 steps = 0; steps < MAX_STEPS; steps++)
+    {
+        if (pc >= sim->program->count)
+            return fault(sim, "ran off the end of the program", CODE_BASE + 4 * pc);
+
+        const struct insn *insn = &sim->program->insns[pc];
+        u32 next = pc + 1;
+        u32 value;
+        sim->stats.instructions++;
+
+        switch (insn->op)
+        {
+        case OP_MOVE:
+            if (read_ea(sim, &insn->src, insn->size, &value) < 0)
+                return -1;
+            if (insn->dst.mode == EA_AREG)
+            {
+                sim->a[insn->dst.reg] = sext(value, insn->size); // movea: no flags
+                break;
+            }
+            if (write_ea(sim, &insn->dst, insn->size, value) < 0)
+                return -1;
+            set_logic(sim, value, insn->size);
+            break;
+        case OP_MOVEQ:
+            if (insn->src.mode != EA_IMM || insn->dst.mode != EA_DREG || insn->src.value < -128 || insn->src.value > 127)
+                return fault(sim, "bad moveq", CODE_BASE + 4 * pc);
+            sim->d[insn->dst.reg] = sext((u32)insn->src.value, 1);
+            set_logic(sim, sim->d[insn->dst.reg], 4);
+            break;
+        case OP_ROR:
+        case OP_ROL:
+        case OP_LSL:
+        case OP_LSR:
+            if (shift(sim, insn) < 0)
+                return -1;
+            break;
+        case OP_SWAP:
+            if (insn->dst.mode != EA_DREG)
+                return fault(sim, "bad swap", CODE_BASE + 4 * pc);
+            value = sim->d[insn->dst.reg];
+            value = (value << 16) | (value >> 16);
+            sim->d[insn->dst.reg] = value;
+            set_logic(sim, value, 4);
+            break;
+        case OP_AND:
+        case OP_OR:
+            if (logic(sim, insn) < 0)
+                return -1;
+            break;
+        case OP_ADD:
+        case OP_SUB:
+        case OP_CMP:
+            if (arith(sim, insn) < 0)
+                return -1;
+            break;
+        case OP_TST:
+            if (read_ea(sim, &insn->dst, insn->size, &value) < 0)
+                return -1;
+            set_logic(sim, value, insn->size);
+            break;
+        case OP_CLR:
+            if (write_ea(sim, &insn->dst, insn->size, 0) < 0)
+                return -1;
+            set_logic(sim, 0, insn->size);
+            break;
+        case OP_LEA:
+            if (insn->dst.mode != EA_AREG || ea_address(sim, &insn->src, 4, &value) < 0)
+                return fault(sim, "bad lea", CODE_BASE + 4 * pc);
+            sim->a[insn->dst.reg] = value;
+            break;
+        case OP_BCC:
+        {
+            BOOL target_found;
+            u32 target = label_index(sim->program, insn->dst.symbol, &target_found);
+            if (insn->dst.mode != EA_SYMBOL || !target_found)
+                return fault(sim, "branch to an unknown label", CODE_BASE + 4 * pc);
+            if (test_cond(sim, insn->cond))
+                next = target;
+            break;
+        }
+        case OP_JSR:
+        case OP_JMP:
+        {
+            u32 target, index;
+            if (branch_target(sim, &insn->dst, &target) < 0)
+                return -1;
+            if (insn->op == OP_JSR)
+            {
+                if (call(sim, target, CODE_BASE + 4 * next, &next) < 0)
+                    return -1;
+            }
+            else if (code_index(sim, target, &index))
+                next = index;
+            else
+                return fault(sim, "jmp outside the program", target);
+            break;
+        }
+        case OP_RTS:
+        {
+            u32 back, index;
+            if (pop(sim, &back) < 0)
+                return -1;
+            if (back == RETURN_TOKEN)
+            {
+                if (sim->a[7] != entry_sp)
+                    return fault(sim, "stack imbalance on return", sim->a[7]);
+                return 0;
+            }
+            if (!code_index(sim, back, &index))
+                return fault(sim, "rts to a bad address", back);
+            next = index;
+            break;
+        }
+        }
+        pc = next;
+    }
+    return fault(sim, "step limit reached", CODE_BASE + 4 * pc);
+}
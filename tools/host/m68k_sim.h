@@ -0,0 +1,76 @@
+// SPDX-License-Identifier: MPL-2.0 OR GPL-2.0+
+#ifndef _M68K_SIM_H
+#define _M68K_SIM_H
+
+/* Source-level interpreter for the m68k instruction subset of
+ * src/gic400_dispatch.S, for hosts without an m68k emulator. It reads the
+ * preprocessed Motorola-syntax source, so what runs is the shipped text,
+ * not a transcription. Anything outside the subset is rejected at load
+ * time with its line number.
+ *
+ * Memory is a big-endian RAM image starting at address 0, plus one window
+ * forwarded to host MMIO through mmio_read32()/mmio_write32(): the CPU sees
+ * the little-endian GIC registers byte-swapped, exactly as on the bus.
+ * A jsr to an address outside the program, or to an external symbol, calls
+ * the trap hook instead.
+ */
+
+#include <exec/types.h>
+#include <types.h>
+
+#define M68K_SIM_RAM 0x10000
+
+struct m68k_sim;
+
+/* Trap hook: emulate the called routine on the register file. The return
+ * address is on the stack, as for a real callee.
+ */
+typedef void (*m68k_sim_trap)(struct m68k_sim *sim, u32 address, void *user);
+
+struct m68k_sim_stats
+{
+    u32 instructions;
+    u32 ram_reads;
+    u32 ram_writes;
+    u32 mmio_reads;
+    u32 mmio_writes;
+};
+
+struct m68k_sim
+{
+    u32 d[8];
+    u32 a[8]; // a[7] is the stack pointer
+    BOOL x, n, z, v, c;
+    u8 ram[M68K_SIM_RAM];
+
+    u32 mmio_base; // window in the simulated address space
+    u32 mmio_size;
+    volatile u8 *mmio_host;
+
+    m68k_sim_trap trap;
+    void *trap_user;
+
+    struct m68k_sim_stats stats;
+
+    struct m68k_sim_program *program;
+};
+
+/* m68k_sim_load: Parse a preprocessed assembly file.
+ * Args: externs/extern_addresses - symbols the source may jsr to that it
+ *  does not define, and the trap addresses they map to.
+ * Returns: 0 on success, -1 after printing the offending line.
+ */
+int m68k_sim_load(struct m68k_sim *sim, const char *path, const char *const *externs, const u32 *extern_addresses, u32 extern_count);
+
+void m68k_sim_free(struct m68k_sim *sim);
+
+/* m68k_sim_call: Run from a label until its final rts.
+ * Returns: 0 on success, -1 on a fault (message printed).
+ */
+int m68k_sim_call(struct m68k_sim *sim, const char *label);
+
+u32 m68k_sim_read32(struct m68k_sim *sim, u32 address);
+void m68k_sim_write32(struct m68k_sim *sim, u32 address, u32 value);
+void m68k_sim_write8(struct m68k_sim *sim, u32 address, u8 value);
+
+#endif /* _M68K_SIM_H */
@@ -0,0 +1,326 @@
+// SPDX-License-Identifier: MPL-2.0 OR GPL-2.0+
+/* profsym: Turn a DumpProfiler() dump into a symbolised flat profile.
+ *
+ * The dump is either the raw sample array saved on the Amiga (big-endian
+ * struct GICProfileSample, 12 bytes each) or text, one sample per line:
+ *
+ *   <pc> <task> <sr> <flags>    # numbers in C notation, comment
+ *
+ * Symbols come from nm-style maps ("<address> [<size>] <type> <name>", as
+ * printed by m68k-amigaos-nm -n or -S). An executable is loaded wherever
+ * AllocMem() put it, so each map takes the address its text was loaded at:
+ * -m file@base adds base to every symbol in file. Samples are charged to the
+ * closest text symbol at or below their PC (within its size when the map
+ * has one); the rest are listed as [unknown]. Samples without a frame are
+ * counted separately.
+ *
+ * Usage: profsym [-m map[@base]]... [-t] <dump>
+ *   -t  also break the profile down by task
+ */
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <exec/types.h>
+#include <libraries/gic400.h>
+#include <types.h>
+
+#define PROFSYM_SAMPLE_SIZE 12 // sizeof(struct GICProfileSample) on m68k
+#define PROFSYM_SR_SUPERVISOR 0x2000
+
+/* A sample as stored on the Amiga: pointers are 32 bits */
+struct profsym_sample
+{
+    u32 pc;
+    u32 task;
+    u16 sr;
+    u16 flags;
+};
+
+struct profsym_symbol
+{
+    u32 address;
+    u32 size; // 0 when the map has no sizes
+    char *name;
+};
+
+struct profsym_entry
+{
+    const char *name;
+    u32 task;
+    u32 count;
+};
+
+static struct profsym_symbol *symbols;
+static u32 symbol_count;
+
+static int by_address(const void *a, const void *b)
+{
+    const struct profsym_symbol *x = a, *y = b;
+    return x->address < y->address ? -1 : x->address > y->address;
+}
+
+static int by_count(const void *a, const void *b)
+{
+    const struct profsym_entry *x = a, *y = b;
+    if (x->count != y->count)
+        return x->count > y->count ? -1 : 1;
+    int names = strcmp(x->name, y->name);
+    return names ? names : (x->task < y->task ? -1 : x->task > y->task);
+}
+
+/* Maps */
+
+static int load_map(const char *spec)
+{
+    char path[512];
+    snprintf(path, sizeof(path), "%s", spec);
+    u32 base = 0;
+    char *at = strrchr(path, '@');
+    if (at)
+    {
+        *at = 0;
+        char *end;
+        base = (u32)strtoul(at + 1, &end, 0);
+        if (*end != 0)
+        {
+            fprintf(stderr, "profsym: bad load address in %s\n", spec);
+            return -1;
+        }
+    }
+
+    FILE *file = fopen(path, "r");
+    if (!file)
+    {
+        perror(path);
+        return -1;
+    }
+
+    static u32 space;
+    char line[512];
+    while (fgets(line, sizeof(line), file))
+    {
+        char fields[4][256];
+        int count = sscanf(line, "%255s %255s %255s %255s", fields[0], fields[1], fields[2], fields[3]);
+        const char *type = count == 4 ? fields[2] : fields[1];
+        const char *name = count == 4 ? fields[3] : fields[2];
+        if (count < 3 || strlen(type) != 1 || !strchr("TtWw", type[0]) || !isxdigit((unsigned char)fields[0][0]))
+            continue; // undefined, data or absolute symbols, or not a symbol line
+
+        if (symbol_count == space)
+        {
+            space = space ? space * 2 : 256;
+            symbols = realloc(symbols, space * sizeof(struct profsym_symbol));
+        }
+        struct profsym_symbol *symbol = &symbols[symbol_count++];
+        symbol->address = base + (u32)strtoul(fields[0], NULL, 16);
+        symbol->size = count == 4 ? (u32)strtoul(fields[1], NULL, 16) : 0;
+        symbol->name = strdup(name);
+    }
+    fclose(file);
+    return 0;
+}
+
+static const char *lookup(u32 pc)
+{
+    /* last symbol at or below pc */
+    u32 low = 0, high = symbol_count;
+    while (low < high)
+    {
+        u32 middle = (low + high) / 2;
+        if (symbols[middle].address <= pc)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    if (low == 0)
+        return NULL;
+
+    const struct profsym_symbol *symbol = &symbols[low - 1];
+    if (symbol->size && pc - symbol->address >= symbol->size)
+        return NULL;
+    return symbol->name;
+}
+
+/* Dumps */
+
+static u32 be32(const u8 *p)
+{
+    return ((u32)p[0] << 24) | ((u32)p[1] << 16) | ((u32)p[2] << 8) | p[3];
+}
+
+static BOOL is_text(const u8 *data, size_t size)
+{
+    for (size_t i = 0; i < size; i++)
+        if (!isprint(data[i]) && !isspace(data[i]))
+            return FALSE;
+    return TRUE;
+}
+
+static int load_dump(const char *path, struct profsym_sample **samples, u32 *count)
+{
+    FILE *file = fopen(path, "rb");
+    if (!file)
+    {
+        perror(path);
+        return -1;
+    }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    u8 *data = malloc((size_t)size + 1);
+    if (fread(data, 1, (size_t)size, file) != (size_t)size)
+    {
+        perror(path);
+        fclose(file);
+        free(data);
+        return -1;
+    }
+    fclose(file);
+    data[size] = 0;
+
+    int ret = 0;
+    *count = 0;
+    if (is_text(data, (size_t)size))
+    {
+        u32 space = 64;
+        *samples = malloc(space * sizeof(struct profsym_sample));
+        u32 line = 0;
+        for (char *next, *s = (char *)data; s; s = next)
+        {
+            line++;
+            next = strchr(s, '\n');
+            if (next)
+                *next++ = 0;
+            char *comment = strchr(s, '#');
+            if (comment)
+                *comment = 0;
+
+            long pc, task, sr, flags;
+            int fields = sscanf(s, "%li %li %li %li", &pc, &task, &sr, &flags);
+            if (fields <= 0)
+                continue;
+            if (fields != 4)
+            {
+                fprintf(stderr, "%s:%u: expected <pc> <task> <sr> <flags>\n", path, line);
+                ret = -1;
+                break;
+            }
+            if (*count == space)
+                *samples = realloc(*samples, (space *= 2) * sizeof(struct profsym_sample));
+            (*samples)[(*count)++] = (struct profsym_sample){(u32)pc, (u32)task, (u16)sr, (u16)flags};
+        }
+    }
+    else if (size % PROFSYM_SAMPLE_SIZE)
+    {
+        fprintf(stderr, "%s: size is not a multiple of %u\n", path, PROFSYM_SAMPLE_SIZE);
+        ret = -1;
+    }
+    else
+    {
+        *count = (u32)size / PROFSYM_SAMPLE_SIZE;
+        *samples = malloc(*count * sizeof(struct profsym_sample) + 1);
+        for (u32 i = 0; i < *count; i++)
+        {
+            const u8 *p = data + i * PROFSYM_SAMPLE_SIZE;
+            (*samples)[i] = (struct profsym_sample){be32(p), be32(p + 4), (u16)((p[8] << 8) | p[9]), (u16)((p[10] << 8) | p[11])};
+        }
+    }
+    free(data);
+    return ret;
+}
+
+/* Profile */
+
+static void print_profile(const struct profsym_sample *samples, u32 count, BOOL by_task)
+{
+    struct profsym_entry *entries = calloc(count + 1, sizeof(struct profsym_entry));
+    u32 entry_count = 0;
+    u32 noframe = 0, ambiguous = 0, supervisor = 0, framed = 0;
+
+    for (u32 i = 0; i < count; i++)
+    {
+        const struct profsym_sample *sample = &samples[i];
+        if (sample->flags & GIC400_PROF_NOFRAME)
+        {
+            noframe++;
+            if (sample->flags & GIC400_PROF_AMBIGUOUS)
+                ambiguous++;
+            continue;
+        }
+        framed++;
+        if (sample->sr & PROFSYM_SR_SUPERVISOR)
+            supervisor++;
+
+        const char *name = lookup(sample->pc);
+        if (!name)
+            name = "[unknown]";
+        u32 task = by_task ? sample->task : 0;
+
+        u32 e = 0;
+        while (e < entry_count && (strcmp(entries[e].name, name) != 0 || entries[e].task != task))
+            e++;
+        if (e == entry_count)
+            entries[entry_count++] = (struct profsym_entry){name, task, 0};
+        entries[e].count++;
+    }
+
+    qsort(entries, entry_count, sizeof(struct profsym_entry), by_count);
+
+    printf("%u samples, %u with a frame (%u in supervisor mode), %u without (%u ambiguous)\n", count, framed, supervisor,
+           noframe, ambiguous);
+    printf("  samples       %%  %ssymbol\n", by_task ? "task      " : "");
+    for (u32 e = 0; e < entry_count; e++)
+    {
+        printf("  %7u  %5.1f%%  ", entries[e].count, framed ? 100.0 * entries[e].count / framed : 0.0);
+        if (by_task)
+            printf("%08x  ", entries[e].task);
+        printf("%s\n", entries[e].name);
+    }
+    free(entries);
+}
+
+static int usage(const char *name)
+{
+    fprintf(stderr, "usage: %s [-m map[@base]]... [-t] <dump>\n", name);
+    return 2;
+}
+
+int main(int argc, char **argv)
+{
+    const char *path = NULL;
+    BOOL by_task = FALSE;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-m") == 0 && i + 1 < argc)
+        {
+            if (load_map(argv[++i]) < 0)
+                return 1;
+        }
+        else if (strcmp(argv[i], "-t") == 0)
+            by_task = TRUE;
+        else if (argv[i][0] != '-' && !path)
+            path = argv[i];
+        else
+            return usage(argv[0]);
+    }
+    if (!path)
+        return usage(argv[0]);
+
+    qsort(symbols, symbol_count, sizeof(struct profsym_symbol), by_address);
+
+    struct profsym_sample *samples = NULL;
+    u32 count = 0;
+    if (load_dump(path, &samples, &count) < 0)
+        return 1;
+
+    print_profile(samples, count, by_task);
+
+    free(samples);
+    for (u32 i = 0; i < symbol_count; i++)
+        free(symbols[i].name);
+    free(symbols);
+    return 0;
+}
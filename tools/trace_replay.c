@@ -0,0 +1,443 @@
+// SPDX-License-Identifier: MPL-2.0 OR GPL-2.0+
+/* trace_replay: Feed an interrupt capture back through the dispatcher.
+ *
+ * The capture is what ReadIntTrace() returns, either as the raw record
+ * array saved on the Amiga (big-endian struct GICTraceRecord, 12 bytes
+ * each) or as text, one record per line:
+ *
+ *   <arrival> <duration> <irq> [unhandled]    # comment
+ *
+ * The library is brought up on the GIC register model with a host server on
+ * every IRQ the capture saw handled. Each record is replayed at its arrival
+ * time: the IRQ is queued in GICC_IAR and dispatched exactly as the Exec
+ * server does, and its server holds the CPU for the recorded duration. The
+ * dispatches are traced again, so the replay is checked against the capture
+ * record by record (durations of unhandled IRQs excepted: with no server
+ * nothing takes time); policies can be switched on to see their effect on
+ * the same load.
+ *
+ * Usage: trace_replay [-f window:share] [-b irq:us] [-o irq] [-s irq]
+ *                     [-w replayed.bin] <capture>
+ *   -f  SetIntFairness()        -b  SetIntBudget()
+ *   -o  SetIntOverrunDetect()   -s  SetIntTimestamp()
+ *   -w  save the replayed trace in the binary capture format
+ * Exits non-zero when the replay differs from the capture.
+ */
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "gic400_host.h"
+#include "gic_model.h"
+
+#define REPLAY_RECORD_SIZE 12 // sizeof(struct GICTraceRecord) on m68k
+#define REPLAY_PRIORITY 0x40 // leaves room for fair-share demotion
+#define REPLAY_MAX_IRQS 512
+#define REPLAY_MAX_OPTIONS 16
+#define REPLAY_MAX_MISMATCHES 8
+
+struct replay_option
+{
+    char kind; // 'b', 'o' or 's'
+    u32 irq;
+    u32 value;
+};
+
+struct replay_stats
+{
+    u32 count;
+    u32 unhandled;
+    u32 busy;
+    u32 worst;
+    u32 last_arrival;
+    u32 min_gap;
+};
+
+static const struct GICTraceRecord *replay_current;
+
+/* Servers take as long as they took when the capture was made */
+static ULONG replay_server(u32 irq, u32 hint, APTR data, u32 stamp)
+{
+    (void)irq, (void)hint, (void)data, (void)stamp;
+    gic_model_advance(replay_current->duration);
+    return 0;
+}
+
+/* Capture files */
+
+static u32 be32(const u8 *p)
+{
+    return ((u32)p[0] << 24) | ((u32)p[1] << 16) | ((u32)p[2] << 8) | p[3];
+}
+
+static void put_be32(u8 *p, u32 value)
+{
+    p[0] = (u8)(value >> 24);
+    p[1] = (u8)(value >> 16);
+    p[2] = (u8)(value >> 8);
+    p[3] = (u8)value;
+}
+
+static BOOL is_text(const u8 *data, size_t size)
+{
+    for (size_t i = 0; i < size; i++)
+        if (!isprint(data[i]) && !isspace(data[i]))
+            return FALSE;
+    return TRUE;
+}
+
+static int parse_text(char *text, const char *path, struct GICTraceRecord **records, u32 *count)
+{
+    u32 space = 64;
+    *records = malloc(space * sizeof(struct GICTraceRecord));
+    *count = 0;
+
+    u32 line = 0;
+    for (char *next, *s = text; s; s = next)
+    {
+        line++;
+        next = strchr(s, '\n');
+        if (next)
+            *next++ = 0;
+        char *comment = strchr(s, '#');
+        if (comment)
+            *comment = 0;
+
+        char flag[16] = "";
+        long arrival, duration, irq;
+        int fields = sscanf(s, "%li %li %li %15s", &arrival, &duration, &irq, flag);
+        if (fields <= 0)
+            continue; // blank or comment
+        if (fields < 3 || (fields == 4 && strcmp(flag, "unhandled") != 0) || arrival < 0 || duration < 0 || irq < 0)
+        {
+            fprintf(stderr, "%s:%u: expected <arrival> <duration> <irq> [unhandled]\n", path, line);
+            return -1;
+        }
+
+        if (*count == space)
+            *records = realloc(*records, (space *= 2) * sizeof(struct GICTraceRecord));
+        struct GICTraceRecord *record = &(*records)[(*count)++];
+        record->arrival = (ULONG)arrival;
+        record->duration = (ULONG)duration;
+        record->irq = (UWORD)irq;
+        record->flags = fields == 4 ? GIC400_TRACE_UNHANDLED : 0;
+    }
+    return 0;
+}
+
+static int load_capture(const char *path, struct GICTraceRecord **records, u32 *count)
+{
+    FILE *file = fopen(path, "rb");
+    if (!file)
+    {
+        perror(path);
+        return -1;
+    }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    u8 *data = malloc((size_t)size + 1);
+    if (fread(data, 1, (size_t)size, file) != (size_t)size)
+    {
+        perror(path);
+        fclose(file);
+        free(data);
+        return -1;
+    }
+    fclose(file);
+    data[size] = 0;
+
+    int ret = 0;
+    if (is_text(data, (size_t)size))
+        ret = parse_text((char *)data, path, records, count);
+    else if (size % REPLAY_RECORD_SIZE)
+    {
+        fprintf(stderr, "%s: size is not a multiple of %u\n", path, REPLAY_RECORD_SIZE);
+        ret = -1;
+    }
+    else
+    {
+        *count = (u32)size / REPLAY_RECORD_SIZE;
+        *records = malloc(*count * sizeof(struct GICTraceRecord) + 1);
+        for (u32 i = 0; i < *count; i++)
+        {
+            const u8 *p = data + i * REPLAY_RECORD_SIZE;
+            (*records)[i].arrival = be32(p);
+            (*records)[i].duration = be32(p + 4);
+            (*records)[i].irq = (UWORD)((p[8] << 8) | p[9]);
+            (*records)[i].flags = (UWORD)((p[10] << 8) | p[11]);
+        }
+    }
+    free(data);
+
+    for (u32 i = 0; ret == 0 && i < *count; i++)
+    {
+        if ((*records)[i].irq >= REPLAY_MAX_IRQS)
+        {
+            fprintf(stderr, "%s: record %u: IRQ %u out of range\n", path, i, (*records)[i].irq);
+            ret = -1;
+        }
+    }
+    return ret;
+}
+
+static int save_capture(const char *path, const struct GICTraceRecord *records, u32 count)
+{
+    FILE *file = fopen(path, "wb");
+    if (!file)
+    {
+        perror(path);
+        return -1;
+    }
+    for (u32 i = 0; i < count; i++)
+    {
+        u8 p[REPLAY_RECORD_SIZE];
+        put_be32(p, records[i].arrival);
+        put_be32(p + 4, records[i].duration);
+        p[8] = (u8)(records[i].irq >> 8);
+        p[9] = (u8)records[i].irq;
+        p[10] = (u8)(records[i].flags >> 8);
+        p[11] = (u8)records[i].flags;
+        fwrite(p, 1, sizeof(p), file);
+    }
+    return fclose(file) == 0 ? 0 : -1;
+}
+
+/* Replay */
+
+static int apply_option(struct GIC_Base *gicBase, const struct replay_option *option)
+{
+    LONG ret;
+    switch (option->kind)
+    {
+    case 'b':
+        ret = SetIntBudget(option->irq, option->value, 0, gicBase);
+        break;
+    case 'o':
+        ret = SetIntTriggerEdge(option->irq, gicBase); // overrun detection is edge-only
+        if (ret >= 0)
+            ret = SetIntOverrunDetect(option->irq, TRUE, gicBase);
+        break;
+    default:
+        ret = SetIntTimestamp(option->irq, TRUE, gicBase);
+        break;
+    }
+    if (ret < 0)
+        fprintf(stderr, "trace_replay: -%c %u failed (%ld)\n", option->kind, option->irq, (long)ret);
+    return ret < 0 ? -1 : 0;
+}
+
+static void report(struct GIC_Base *gicBase, const struct GICTraceRecord *records, u32 count, const struct replay_option *options, u32 option_count)
+{
+    static struct replay_stats stats[REPLAY_MAX_IRQS];
+    memset(stats, 0, sizeof(stats));
+    for (u32 i = 0; i < count; i++)
+    {
+        struct replay_stats *entry = &stats[records[i].irq];
+        u32 gap = records[i].arrival - entry->last_arrival;
+        if (entry->count && (entry->count == 1 || gap < entry->min_gap))
+            entry->min_gap = gap;
+        entry->last_arrival = records[i].arrival;
+        entry->count++;
+        if (records[i].flags & GIC400_TRACE_UNHANDLED)
+            entry->unhandled++;
+        entry->busy += records[i].duration;
+        if (records[i].duration > entry->worst)
+            entry->worst = records[i].duration;
+    }
+
+    printf("  irq  count  unhandled  busy us  worst us  min gap us\n");
+    for (u32 irq = 0; irq < REPLAY_MAX_IRQS; irq++)
+    {
+        const struct replay_stats *entry = &stats[irq];
+        if (!entry->count)
+            continue;
+        printf("  %3u  %5u  %9u  %7u  %8u  ", irq, entry->count, entry->unhandled, entry->busy, entry->worst);
+        if (entry->count > 1)
+            printf("%10u\n", entry->min_gap);
+        else
+            printf("%10s\n", "-");
+    }
+
+    struct gic_model_counts mmio = gic_model_counts();
+    printf("gic register accesses: %u reads, %u writes (%.2f/%.2f per dispatch)\n", mmio.reads, mmio.writes,
+           count ? (double)mmio.reads / count : 0.0, count ? (double)mmio.writes / count : 0.0);
+
+    struct GICFairnessInfo fairness;
+    if (GetIntFairness(&fairness, gicBase) == 0 && fairness.window)
+        printf("fairness: %u demotions, %u restores, %u demoted now\n", fairness.demotions, fairness.restores, fairness.demotedCount);
+
+    for (u32 i = 0; i < option_count; i++)
+    {
+        const struct replay_option *option = &options[i];
+        if (option->kind == 'o')
+            printf("IRQ %u: %ld overruns\n", option->irq, (long)GetIntOverruns(option->irq, FALSE, gicBase));
+    }
+
+    struct GICBudgetInfo budgets[REPLAY_MAX_OPTIONS];
+    LONG budget_count = GetIntBudgets(budgets, REPLAY_MAX_OPTIONS, gicBase);
+    for (LONG i = 0; i < budget_count; i++)
+        printf("IRQ %u: %u of %u runs over %u us (worst %u us)%s\n", budgets[i].irq, budgets[i].violations, budgets[i].runs,
+               budgets[i].budget, budgets[i].worst, (budgets[i].state & GIC400_BUDGET_FLAGGED) ? ", flagged" : "");
+}
+
+static u32 compare(const struct GICTraceRecord *expected, u32 expected_count, const struct GICTraceRecord *replayed, u32 replayed_count)
+{
+    u32 mismatches = expected_count > replayed_count ? expected_count - replayed_count : replayed_count - expected_count;
+    u32 count = expected_count < replayed_count ? expected_count : replayed_count;
+    if (mismatches)
+        printf("MISMATCH: %u records captured, %u replayed\n", expected_count, replayed_count);
+
+    for (u32 i = 0; i < count; i++)
+    {
+        const struct GICTraceRecord *e = &expected[i];
+        const struct GICTraceRecord *r = &replayed[i];
+        /* without a server nothing takes time, so only handled durations replay */
+        BOOL timed = !(e->flags & GIC400_TRACE_UNHANDLED);
+        if (e->arrival == r->arrival && (!timed || e->duration == r->duration) && e->irq == r->irq && e->flags == r->flags)
+            continue;
+        if (mismatches++ < REPLAY_MAX_MISMATCHES)
+            printf("MISMATCH record %u: captured IRQ %u at %u for %u us flags %x, replayed IRQ %u at %u for %u us flags %x\n", i,
+                   e->irq, e->arrival, e->duration, e->flags, r->irq, r->arrival, r->duration, r->flags);
+    }
+    return mismatches;
+}
+
+static int usage(const char *name)
+{
+    fprintf(stderr, "usage: %s [-f window:share] [-b irq:us] [-o irq] [-s irq] [-w replayed.bin] <capture>\n", name);
+    return 2;
+}
+
+int main(int argc, char **argv)
+{
+    struct replay_option options[REPLAY_MAX_OPTIONS];
+    u32 option_count = 0;
+    unsigned fair_window = 0, fair_share = 0;
+    const char *save_path = NULL;
+    const char *path = NULL;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char *arg = argv[i];
+        if (arg[0] != '-')
+        {
+            if (path)
+                return usage(argv[0]);
+            path = arg;
+            continue;
+        }
+        if (i + 1 >= argc || arg[2] != 0)
+            return usage(argv[0]);
+        const char *value = argv[++i];
+
+        unsigned a = 0, b = 0;
+        switch (arg[1])
+        {
+        case 'f':
+            if (sscanf(value, "%u:%u", &fair_window, &fair_share) != 2)
+                return usage(argv[0]);
+            break;
+        case 'b':
+        case 'o':
+        case 's':
+            if (option_count == REPLAY_MAX_OPTIONS || sscanf(value, arg[1] == 'b' ? "%u:%u" : "%u", &a, &b) != (arg[1] == 'b' ? 2 : 1))
+                return usage(argv[0]);
+            options[option_count++] = (struct replay_option){arg[1], a, b};
+            break;
+        case 'w':
+            save_path = value;
+            break;
+        default:
+            return usage(argv[0]);
+        }
+    }
+    if (!path)
+        return usage(argv[0]);
+
+    struct GICTraceRecord *records = NULL;
+    u32 count = 0;
+    if (load_capture(path, &records, &count) < 0)
+        return 1;
+
+    /* enough IRQ lines for everything in the capture */
+    u32 max_irq = 0;
+    for (u32 i = 0; i < count; i++)
+        if (records[i].irq > max_irq)
+            max_irq = records[i].irq;
+    u32 it_lines = max_irq / 32 < 7 ? 7 : max_irq / 32;
+
+    struct GIC_Base *gicBase = gic400_host_open(it_lines);
+    if (!gicBase)
+    {
+        fprintf(stderr, "trace_replay: library bring-up failed\n");
+        return 1;
+    }
+
+    static struct Interrupt servers[REPLAY_MAX_IRQS];
+    int ret = 0;
+    for (u32 i = 0; i < count && ret == 0; i++)
+    {
+        u32 irq = records[i].irq;
+        if ((records[i].flags & GIC400_TRACE_UNHANDLED) || gicBase->handlers[irq])
+            continue;
+        gic400_host_server_init(&servers[irq], replay_server, NULL);
+        if (AddIntServerEx(irq, REPLAY_PRIORITY, FALSE, &servers[irq], gicBase) < 0)
+            ret = -1;
+    }
+    for (u32 i = 0; i < option_count && ret == 0; i++)
+        ret = apply_option(gicBase, &options[i]);
+    if (ret == 0 && fair_window && SetIntFairness(fair_window, fair_share, gicBase) < 0)
+    {
+        fprintf(stderr, "trace_replay: -f %u:%u failed\n", fair_window, fair_share);
+        ret = -1;
+    }
+    if (ret == 0 && count && StartIntTrace(count, gicBase) < 0)
+        ret = -1;
+    if (ret < 0)
+    {
+        gic400_host_close(gicBase);
+        return 1;
+    }
+
+    gic_model_clear_counts();
+    for (u32 i = 0; i < count; i++)
+    {
+        replay_current = &records[i];
+        gic_model_set_clock(records[i].arrival);
+        gic_model_push_iar(records[i].irq);
+        gic400_dispatch(gicBase, mmio_read32(gicBase->dispatch.gicc_iar)); // what the Exec server does
+    }
+
+    struct GICTraceRecord *replayed = malloc(count * sizeof(struct GICTraceRecord) + 1);
+    ULONG dropped = 0;
+    u32 replayed_count = 0;
+    if (count)
+    {
+        StopIntTrace(&dropped, gicBase);
+        replayed_count = (u32)ReadIntTrace(replayed, count, gicBase);
+    }
+
+    printf("replayed %u records from %s\n", count, path);
+    report(gicBase, replayed, replayed_count, options, option_count);
+    u32 mismatches = compare(records, count, replayed, replayed_count) + dropped;
+    printf("%u mismatches\n", mismatches);
+
+    if (save_path && save_capture(save_path, replayed, replayed_count) < 0)
+        ret = -1;
+
+    for (u32 irq = 0; irq < REPLAY_MAX_IRQS; irq++)
+        if (gicBase->handlers[irq] == &servers[irq])
+            RemIntServerEx(irq, &servers[irq], gicBase);
+    u32 leaked = gic400_host_close(gicBase);
+    if (leaked)
+    {
+        fprintf(stderr, "trace_replay: %u allocations leaked\n", leaked);
+        ret = -1;
+    }
+
+    free(records);
+    free(replayed);
+    return ret < 0 || mismatches ? 1 : 0;
+}